@@ -0,0 +1,84 @@
+#pragma once
+
+#include <new>
+#include <stdlib.h>
+#include <vector>
+
+#include <types.hpp>
+
+using arena_handle_t = u32;
+
+constexpr arena_handle_t null_arena_handle = u32_largest_value;
+
+struct Arena_Statistics {
+  i64 objects = 0;
+  i64 chunks = 0;
+  // Bytes reserved by the chunks, including the unused tail of the last chunk.
+  i64 bytes = 0;
+};
+
+// Arena
+// Chunked bump allocator for trivially destructible objects. Objects are
+// addressed by 32bit handles which remain valid for the lifetime of the arena,
+// i.e. chunks are never moved. Individual objects cannot be freed, all memory
+// is released at once when the arena is destroyed.
+//
+template<typename T>
+struct Arena {
+  private:
+  // 64k objects per chunk.
+  static constexpr u32 chunk_shift = 16;
+  static constexpr u32 chunk_size = 1 << chunk_shift;
+  static constexpr u32 chunk_mask = chunk_size - 1;
+
+  std::vector<T*> chunks;
+  u32 count = 0;
+
+  public:
+  Arena() = default;
+  Arena(Arena const&) = delete;
+  Arena& operator=(Arena const&) = delete;
+
+  ~Arena() {
+    for(T* const chunk: chunks) {
+      free(chunk);
+    }
+  }
+
+  // allocate
+  // Allocate and value-initialise a new object.
+  //
+  // Returns:
+  // Handle to the new object.
+  //
+  [[nodiscard]] arena_handle_t allocate() {
+    if((count & chunk_mask) == 0) {
+      T* const chunk = static_cast<T*>(malloc(sizeof(T) * chunk_size));
+      chunks.push_back(chunk);
+    }
+    arena_handle_t const h = count;
+    count += 1;
+    new(&(*this)[h]) T();
+    return h;
+  }
+
+  [[nodiscard]] T& operator[](arena_handle_t const h) {
+    return chunks[h >> chunk_shift][h & chunk_mask];
+  }
+
+  [[nodiscard]] T const& operator[](arena_handle_t const h) const {
+    return chunks[h >> chunk_shift][h & chunk_mask];
+  }
+
+  [[nodiscard]] i64 size() const {
+    return count;
+  }
+
+  [[nodiscard]] Arena_Statistics statistics() const {
+    return Arena_Statistics{
+      .objects = count,
+      .chunks = static_cast<i64>(chunks.size()),
+      .bytes = static_cast<i64>(chunks.size() * chunk_size * sizeof(T)),
+    };
+  }
+};
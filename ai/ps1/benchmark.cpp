@@ -0,0 +1,1037 @@
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <signal.h>
+#include <stdio.h>
+#include <string_view>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <bucket_open_list.hpp>
+#include <heap.hpp>
+#include <heuristic.hpp>
+#include <pattern_database.hpp>
+#include <solver.hpp>
+#include <timer.hpp>
+
+// Same 48 moves configuration as hardcoded in the solver.
+static constexpr Configuration_Entry benchmark_configuration[] = {
+  2,  5,  13, 12, //
+  1,  16, 3,  15, //
+  9,  7,  14, 6, //
+  10, 11, 8,  4,
+};
+
+// Suite of random walk configurations from 30 to 56 moves. Kept within reach
+// of A* and BA* memory-wise so that every algorithm solves the whole suite.
+static constexpr Configuration_Entry suite_configurations[][16] = {
+  // 30 moves
+  {
+    1,  3,  6,  4, //
+    14, 2,  8,  11, //
+    16, 7,  12, 10, //
+    9,  5,  13, 15,
+  },
+  // 39 moves
+  {
+    9,  10, 7,  8, //
+    3,  6,  4,  11, //
+    2,  13, 14, 12, //
+    1,  5,  16, 15,
+  },
+  // 42 moves
+  {
+    2,  15, 16, 9, //
+    10, 13, 3,  4, //
+    7,  14, 11, 1, //
+    5,  6,  12, 8,
+  },
+  // 42 moves
+  {
+    16, 4,  8,  5, //
+    2,  10, 12, 15, //
+    13, 3,  6,  11, //
+    9,  1,  7,  14,
+  },
+  // 42 moves
+  {
+    2,  12, 7,  11, //
+    4,  3,  6,  15, //
+    5,  1,  10, 8, //
+    13, 16, 9,  14,
+  },
+  // 43 moves
+  {
+    2,  4,  15, 6, //
+    7,  9,  16, 14, //
+    3,  1,  11, 8, //
+    13, 5,  12, 10,
+  },
+  // 44 moves
+  {
+    10, 9,  16, 11, //
+    5,  4,  1,  2, //
+    13, 6,  15, 12, //
+    7,  8,  14, 3,
+  },
+  // 45 moves
+  {
+    7,  3,  11, 14, //
+    6,  12, 4,  10, //
+    2,  5,  8,  15, //
+    13, 1,  16, 9,
+  },
+  // 48 moves
+  {
+    14, 7,  15, 2, //
+    8,  1,  9,  3, //
+    16, 5,  12, 11, //
+    6,  4,  13, 10,
+  },
+  // 51 moves
+  {
+    12, 15, 7,  5, //
+    16, 8,  4,  1, //
+    10, 3,  2,  6, //
+    9,  14, 13, 11,
+  },
+  // 55 moves
+  {
+    7,  4,  13, 9, //
+    14, 6,  15, 1, //
+    11, 8,  2,  16, //
+    5,  12, 3,  10,
+  },
+  // 56 moves
+  {
+    11, 15, 3,  13, //
+    1,  16, 14, 9, //
+    6,  4,  2,  10, //
+    12, 8,  5,  7,
+  },
+};
+
+constexpr i64 instances_default_count = 10;
+constexpr u64 instances_default_seed = 15;
+constexpr i64 instances_default_time_limit_ms = 10000;
+constexpr i64 instances_default_memory_limit = (i64)2 << 30;
+
+static void help(char const* const name) {
+  printf("Usage: %s BENCHMARK\n", name);
+  printf("\n");
+  printf("BENCHMARK\n");
+  printf("  heuristic\n");
+  printf(
+    "    Nodes per second of IDA* and A* on a 48 moves configuration with the "
+    "heuristic evaluated in full and incrementally.\n");
+  printf("  suite\n");
+  printf(
+    "    Nodes and time of A*, IDA*, BA* and perimeter IDA* with the linear "
+    "conflict heuristic on a fixed suite of configurations.\n");
+  printf("  instances [OPTION]...\n");
+  printf(
+    "    Every combination of algorithm and heuristic on a suite of random "
+    "solvable configurations, each run in a child process under time and "
+    "memory limits. Writes a CSV of the solution length, explored nodes, "
+    "nodes per second and peak resident memory to the standard output.\n");
+  printf(
+    "      -i, --input FILE   read the configurations from FILE in the batch "
+    "format of the solver instead of generating them\n");
+  printf(
+    "      -c, --count N      number of generated configurations. Defaults "
+    "to %lld\n",
+    instances_default_count);
+  printf(
+    "          --seed N       seed of the generator. Defaults to %llu\n",
+    instances_default_seed);
+  printf(
+    "          --walk N       generate random walks of N moves from the goal "
+    "instead of uniformly random configurations\n");
+  printf(
+    "      -a, --algorithm    run only the given algorithm. May be repeated. "
+    "Available options are: A*, IDA*, BA*, SMA*, PIDA*\n");
+  printf(
+    "      -e, --heuristic    run only the given heuristic. May be repeated. "
+    "Available options are: MD, LC, PDB\n");
+  printf(
+    "          --time-limit   time limit of a run in milliseconds. Defaults "
+    "to %lld\n",
+    instances_default_time_limit_ms);
+  printf(
+    "          --memory-limit address space limit of a run in MiB. Defaults "
+    "to %lld\n",
+    instances_default_memory_limit >> 20);
+  printf("  generation\n");
+  printf(
+    "    Raw node generation rate of a depth first enumeration without a "
+    "heuristic, probing the directions against the board edges and the path "
+    "versus walking the move table and skipping the undo move.\n");
+  printf("  open-list\n");
+  printf(
+    "    Insert, decrease-key and extract throughput of the heap and the "
+    "bucket open lists on random costs typical for the 15 puzzle.\n");
+}
+
+static void print_result(char const* const algorithm,
+                         char const* const heuristic, char const* const mode,
+                         puzzle15::Solution const& solution, i64 const time) {
+  double const nodes_per_second =
+    time > 0 ? (double)solution.explored * 1000000000.0 / time : 0.0;
+  printf("%-5s %-3s %-12s %10lld nodes %8.1fms %12.0f nodes/s%s\n", algorithm,
+         heuristic, mode, solution.explored, time / 1000000.0,
+         nodes_per_second, solution.found ? "" : " (not found)");
+}
+
+static void benchmark_heuristic() {
+  struct Heuristic {
+    char const* name;
+    heuristic_t heuristic;
+    heuristic_delta_t heuristic_delta;
+  };
+
+  Heuristic const heuristics[] = {
+    {"MD", puzzle15::heuristic_manhattan_distance,
+     puzzle15::heuristic_manhattan_distance_delta},
+    {"LC", puzzle15::heuristic_linear_conflict,
+     puzzle15::heuristic_linear_conflict_delta},
+  };
+
+  for(Heuristic const& h: heuristics) {
+    for(bool const incremental: {false, true}) {
+      char const* const mode = incremental ? "incremental" : "full";
+      heuristic_delta_t const delta =
+        incremental ? h.heuristic_delta : nullptr;
+      {
+        IDAstar_Parameters const p = {
+          .starting_configuration = benchmark_configuration,
+          .heuristic = h.heuristic,
+          .heuristic_delta = delta};
+        Timer timer;
+        timer.start();
+        puzzle15::Solution const solution = puzzle15::IDAstar_solver(p);
+        i64 const time = timer.end_ns();
+        print_result("IDA*", h.name, mode, solution, time);
+      }
+      {
+        Astar_Parameters const p = {
+          .starting_configuration = benchmark_configuration,
+          .heuristic = h.heuristic,
+          .heuristic_delta = delta};
+        Timer timer;
+        timer.start();
+        puzzle15::Solution const solution = puzzle15::Astar_solver(p);
+        i64 const time = timer.end_ns();
+        print_result("A*", h.name, mode, solution, time);
+      }
+    }
+  }
+}
+
+static void benchmark_suite() {
+  struct Algorithm {
+    char const* name;
+    puzzle15::Solution (*solve)(Configuration_View configuration);
+  };
+
+  Algorithm const algorithms[] = {
+    {"A*",
+     [](Configuration_View const configuration) {
+       return puzzle15::Astar_solver(
+         {.starting_configuration = configuration,
+          .heuristic = puzzle15::heuristic_linear_conflict,
+          .heuristic_delta = puzzle15::heuristic_linear_conflict_delta});
+     }},
+    {"IDA*",
+     [](Configuration_View const configuration) {
+       return puzzle15::IDAstar_solver(
+         {.starting_configuration = configuration,
+          .heuristic = puzzle15::heuristic_linear_conflict,
+          .heuristic_delta = puzzle15::heuristic_linear_conflict_delta});
+     }},
+    {"IDA*+TT",
+     [](Configuration_View const configuration) {
+       return puzzle15::IDAstar_solver(
+         {.starting_configuration = configuration,
+          .heuristic = puzzle15::heuristic_linear_conflict,
+          .heuristic_delta = puzzle15::heuristic_linear_conflict_delta,
+          .transposition_table_bytes = (i64)16 << 20});
+     }},
+    {"BA*",
+     [](Configuration_View const configuration) {
+       return puzzle15::Bidirectional_Astar_solver(
+         {.starting_configuration = configuration,
+          .forward_heuristic = puzzle15::heuristic_linear_conflict,
+          .backward_heuristic = puzzle15::heuristic_linear_conflict_generic});
+     }},
+    {"PIDA*",
+     [](Configuration_View const configuration) {
+       return puzzle15::Perimeter_IDAstar_solver(
+         {.starting_configuration = configuration,
+          .heuristic = puzzle15::heuristic_linear_conflict,
+          .heuristic_delta = puzzle15::heuristic_linear_conflict_delta,
+          .perimeter_heuristic = puzzle15::heuristic_linear_conflict_generic});
+     }},
+  };
+
+  // Lengths of the optimal solutions, taken from the first algorithm.
+  constexpr i64 suite_size = std::size(suite_configurations);
+  i64 optimal_lengths[suite_size] = {};
+  for(Algorithm const& algorithm: algorithms) {
+    i64 explored = 0;
+    i64 moves = 0;
+    i64 unsolved = 0;
+    i64 suboptimal = 0;
+    Timer timer;
+    timer.start();
+    for(i64 i = 0; i < suite_size; i += 1) {
+      puzzle15::Solution const solution =
+        algorithm.solve(Configuration_View(suite_configurations[i]));
+      explored += solution.explored;
+      if(!solution.found) {
+        unsolved += 1;
+        continue;
+      }
+
+      i64 const length = solution.path.size() - 1;
+      moves += length;
+      if(&algorithm == &algorithms[0]) {
+        optimal_lengths[i] = length;
+      } else if(length > optimal_lengths[i]) {
+        suboptimal += 1;
+      }
+    }
+    i64 const time = timer.end_ns();
+    double const nodes_per_second =
+      time > 0 ? (double)explored * 1000000000.0 / time : 0.0;
+    printf("%-7s %5lld moves %10lld nodes %8.1fms %12.0f nodes/s "
+           "%2lld unsolved %2lld suboptimal\n",
+           algorithm.name, moves, explored, time / 1000000.0,
+           nodes_per_second, unsolved, suboptimal);
+  }
+}
+
+struct Instance_Heuristic {
+  char const* name;
+  heuristic_t forward;
+  heuristic_delta_t delta;
+  generic_heuristic_t backward;
+};
+
+struct Instance_Algorithm {
+  char const* name;
+  // Whether the algorithm also searches from the goal and requires the
+  // backward heuristic.
+  bool backward;
+  puzzle15::Solution (*solve)(Configuration_View configuration,
+                              Instance_Heuristic const& heuristic,
+                              i64 memory_limit);
+};
+
+static Instance_Heuristic const instance_heuristics[] = {
+  {"MD", puzzle15::heuristic_manhattan_distance,
+   puzzle15::heuristic_manhattan_distance_delta,
+   puzzle15::heuristic_manhattan_distance_generic},
+  {"LC", puzzle15::heuristic_linear_conflict,
+   puzzle15::heuristic_linear_conflict_delta,
+   puzzle15::heuristic_linear_conflict_generic},
+  {"PDB", puzzle15::heuristic_pattern_database, nullptr,
+   puzzle15::heuristic_pattern_database_generic},
+};
+
+static Instance_Algorithm const instance_algorithms[] = {
+  {"A*", false,
+   [](Configuration_View const configuration, Instance_Heuristic const& h,
+      i64) {
+     return puzzle15::Astar_solver({.starting_configuration = configuration,
+                                    .heuristic = h.forward,
+                                    .heuristic_delta = h.delta});
+   }},
+  {"IDA*", false,
+   [](Configuration_View const configuration, Instance_Heuristic const& h,
+      i64) {
+     return puzzle15::IDAstar_solver({.starting_configuration = configuration,
+                                      .heuristic = h.forward,
+                                      .heuristic_delta = h.delta});
+   }},
+  {"BA*", true,
+   [](Configuration_View const configuration, Instance_Heuristic const& h,
+      i64) {
+     return puzzle15::Bidirectional_Astar_solver(
+       {.starting_configuration = configuration,
+        .forward_heuristic = h.forward,
+        .backward_heuristic = h.backward});
+   }},
+  {"SMA*", false,
+   [](Configuration_View const configuration, Instance_Heuristic const& h,
+      i64 const memory_limit) {
+     // Leave room for the rest of the process within the limit.
+     return puzzle15::SMAstar_solver({.starting_configuration = configuration,
+                                      .heuristic = h.forward,
+                                      .heuristic_delta = h.delta,
+                                      .memory_budget = memory_limit / 2});
+   }},
+  {"PIDA*", true,
+   [](Configuration_View const configuration, Instance_Heuristic const& h,
+      i64) {
+     return puzzle15::Perimeter_IDAstar_solver(
+       {.starting_configuration = configuration,
+        .heuristic = h.forward,
+        .heuristic_delta = h.delta,
+        .perimeter_heuristic = h.backward});
+   }},
+};
+
+struct Instances_Options {
+  char const* input = nullptr;
+  i64 count = instances_default_count;
+  u64 seed = instances_default_seed;
+  // 0 selects uniformly random configurations.
+  i32 walk = 0;
+  i64 time_limit_ms = instances_default_time_limit_ms;
+  i64 memory_limit = instances_default_memory_limit;
+  // Names of the selected algorithms and heuristics. Empty selects all.
+  std::vector<std::string_view> algorithms;
+  std::vector<std::string_view> heuristics;
+};
+
+template<typename Integer>
+[[nodiscard]] static std::optional<Integer>
+parse_positive(std::string_view const string) {
+  Integer value = 0;
+  auto const [end, error] =
+    std::from_chars(string.data(), string.data() + string.size(), value);
+  if(error != std::errc() || end != string.data() + string.size() ||
+     value <= 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+[[nodiscard]] static std::optional<Instances_Options>
+parse_instances_options(i32 const argc, char const* const* const argv) {
+  Instances_Options options;
+  for(i32 i = 0; i < argc; i += 2) {
+    std::string_view const option(argv[i]);
+    if(i + 1 >= argc) {
+      printf("error: missing mandatory argument to %s\n", argv[i]);
+      return std::nullopt;
+    }
+
+    std::string_view const argument(argv[i + 1]);
+    if(option == "-i" || option == "--input") {
+      options.input = argv[i + 1];
+    } else if(option == "-a" || option == "--algorithm") {
+      options.algorithms.push_back(argument);
+    } else if(option == "-e" || option == "--heuristic") {
+      options.heuristics.push_back(argument);
+    } else if(option == "-c" || option == "--count" || option == "--seed" ||
+              option == "--walk" || option == "--time-limit" ||
+              option == "--memory-limit") {
+      std::optional<i64> const value = parse_positive<i64>(argument);
+      if(!value) {
+        printf("error: argument to %s must be a positive integer: %s\n",
+               argv[i], argv[i + 1]);
+        return std::nullopt;
+      }
+
+      if(option == "--seed") {
+        options.seed = value.value();
+      } else if(option == "--walk") {
+        options.walk = value.value();
+      } else if(option == "--time-limit") {
+        options.time_limit_ms = value.value();
+      } else if(option == "--memory-limit") {
+        options.memory_limit = value.value() << 20;
+      } else {
+        options.count = value.value();
+      }
+    } else {
+      printf("error: unrecognised option: %s\n", argv[i]);
+      return std::nullopt;
+    }
+  }
+
+  for(std::string_view const name: options.algorithms) {
+    if(std::none_of(std::begin(instance_algorithms),
+                    std::end(instance_algorithms),
+                    [name](Instance_Algorithm const& algorithm) {
+                      return algorithm.name == name;
+                    })) {
+      printf("error: unrecognised algorithm: %.*s\n", (i32)name.size(),
+             name.data());
+      return std::nullopt;
+    }
+  }
+  for(std::string_view const name: options.heuristics) {
+    if(std::none_of(std::begin(instance_heuristics),
+                    std::end(instance_heuristics),
+                    [name](Instance_Heuristic const& heuristic) {
+                      return heuristic.name == name;
+                    })) {
+      printf("error: unrecognised heuristic: %.*s\n", (i32)name.size(),
+             name.data());
+      return std::nullopt;
+    }
+  }
+  return options;
+}
+
+// generate_instances
+// Draw uniformly random solvable configurations, or random walks from the
+// goal when options.walk is set. The same seed always yields the same suite.
+//
+[[nodiscard]] static std::vector<puzzle15::Configuration>
+generate_instances(Instances_Options const& options) {
+  using puzzle15::Puzzle;
+  std::mt19937_64 random(options.seed);
+  std::vector<puzzle15::Configuration> instances;
+  for(i64 i = 0; i < options.count; i += 1) {
+    puzzle15::Configuration configuration = Puzzle::goal_configuration;
+    if(options.walk > 0) {
+      puzzle15::State state = Puzzle::goal_state;
+      i32 parent_empty = -1;
+      for(i32 move = 0; move < options.walk; move += 1) {
+        // Never undo the previous move.
+        i8 targets[4];
+        i32 count = 0;
+        for(i32 const target: Puzzle::moves(state.empty)) {
+          if(target != parent_empty) {
+            targets[count] = target;
+            count += 1;
+          }
+        }
+        parent_empty = state.empty;
+        state = Puzzle::move_empty(state, targets[random() % count]);
+      }
+      configuration = Puzzle::unpack_board(state.board);
+    } else {
+      do {
+        std::shuffle(configuration.begin(), configuration.end(), random);
+      } while(!Puzzle::is_solvable(configuration));
+    }
+    instances.push_back(configuration);
+  }
+  return instances;
+}
+
+// read_instances
+// Read the configurations from path in the batch format of the solver.
+//
+[[nodiscard]] static std::optional<std::vector<puzzle15::Configuration>>
+read_instances(char const* const path) {
+  FILE* const input = fopen(path, "r");
+  if(input == nullptr) {
+    printf("error: could not open %s\n", path);
+    return std::nullopt;
+  }
+
+  std::vector<puzzle15::Configuration> instances;
+  char buffer[256];
+  for(i64 line = 1; fgets(buffer, sizeof(buffer), input) != nullptr;
+      line += 1) {
+    std::string_view const string(buffer);
+    if(string.find_first_not_of(" \t\r\n") == std::string_view::npos ||
+       string[0] == '#') {
+      continue;
+    }
+
+    puzzle15::Configuration configuration;
+    if(!puzzle15::Puzzle::parse_configuration(string, configuration) ||
+       !puzzle15::Puzzle::is_solvable(configuration)) {
+      printf("error: %s:%lld is not a solvable configuration\n", path, line);
+      fclose(input);
+      return std::nullopt;
+    }
+    instances.push_back(configuration);
+  }
+  fclose(input);
+  return instances;
+}
+
+enum struct Run_Status {
+  solved,
+  not_found,
+  time_limit,
+  memory_limit,
+  failed,
+};
+
+static char const* run_status_string(Run_Status const status) {
+  switch(status) {
+    case Run_Status::solved:
+      return "solved";
+    case Run_Status::not_found:
+      return "not_found";
+    case Run_Status::time_limit:
+      return "time_limit";
+    case Run_Status::memory_limit:
+      return "memory_limit";
+    case Run_Status::failed:
+      return "failed";
+  }
+  __builtin_unreachable();
+}
+
+struct Instance_Run {
+  i64 length = 0;
+  i64 explored = 0;
+  i64 time_ns = 0;
+  // Peak resident set of the child process. Includes the memory inherited
+  // from the harness, e.g. the pattern database.
+  i64 peak_rss_bytes = 0;
+  Run_Status status = Run_Status::failed;
+};
+
+// run_instance
+// Solve configuration in a child process, so that the limits apply to and the
+// peak resident memory is measured for this run alone. The child is killed
+// by SIGALRM once the time limit passes. Allocations beyond the memory limit
+// fail and abort the child.
+//
+[[nodiscard]] static Instance_Run
+run_instance(Instance_Algorithm const& algorithm,
+             Instance_Heuristic const& heuristic,
+             Configuration_View const configuration,
+             Instances_Options const& options) {
+  Instance_Run run;
+  int descriptors[2];
+  if(pipe(descriptors) != 0) {
+    return run;
+  }
+
+  // The child inherits the buffers, flush them so they are written once.
+  fflush(stdout);
+  fflush(stderr);
+  // Time of the runs that do not report back, measured by the harness.
+  Timer wall_timer;
+  wall_timer.start();
+  pid_t const pid = fork();
+  if(pid < 0) {
+    close(descriptors[0]);
+    close(descriptors[1]);
+    return run;
+  }
+
+  if(pid == 0) {
+    close(descriptors[0]);
+    rlimit const memory_limit = {.rlim_cur = (rlim_t)options.memory_limit,
+                                 .rlim_max = (rlim_t)options.memory_limit};
+    setrlimit(RLIMIT_AS, &memory_limit);
+    itimerval const time_limit = {
+      .it_interval = {},
+      .it_value = {.tv_sec = options.time_limit_ms / 1000,
+                   .tv_usec = (options.time_limit_ms % 1000) * 1000}};
+    setitimer(ITIMER_REAL, &time_limit, nullptr);
+
+    Timer timer;
+    timer.start();
+    puzzle15::Solution const solution =
+      algorithm.solve(configuration, heuristic, options.memory_limit);
+    Instance_Run result;
+    result.time_ns = timer.end_ns();
+    result.explored = solution.explored;
+    if(solution.found) {
+      result.status = Run_Status::solved;
+      result.length = solution.path.size() - 1;
+    } else {
+      result.status = Run_Status::not_found;
+    }
+    bool const written = write(descriptors[1], &result, sizeof(result)) ==
+                         (ssize_t)sizeof(result);
+    _exit(written ? 0 : 1);
+  }
+
+  close(descriptors[1]);
+  Instance_Run result;
+  // The result is smaller than PIPE_BUF, hence written atomically.
+  bool const received =
+    read(descriptors[0], &result, sizeof(result)) == (ssize_t)sizeof(result);
+  close(descriptors[0]);
+  int status = 0;
+  rusage usage = {};
+  if(wait4(pid, &status, 0, &usage) < 0) {
+    return run;
+  }
+
+  if(received && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+    run = result;
+  } else {
+    run.time_ns = wall_timer.end_ns();
+    if(WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) {
+      run.status = Run_Status::time_limit;
+    } else if(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT) {
+      run.status = Run_Status::memory_limit;
+    }
+  }
+  // Kilobytes on Linux.
+  run.peak_rss_bytes = (i64)usage.ru_maxrss * 1024;
+  return run;
+}
+
+static bool benchmark_instances(i32 const argc, char const* const* const argv) {
+  std::optional<Instances_Options> const parse_result =
+    parse_instances_options(argc, argv);
+  if(!parse_result) {
+    return false;
+  }
+
+  Instances_Options const& options = parse_result.value();
+  std::vector<puzzle15::Configuration> instances;
+  if(options.input != nullptr) {
+    std::optional<std::vector<puzzle15::Configuration>> read_result =
+      read_instances(options.input);
+    if(!read_result) {
+      return false;
+    }
+    instances = std::move(read_result.value());
+  } else {
+    instances = generate_instances(options);
+  }
+
+  auto const selected = [](std::vector<std::string_view> const& names,
+                           char const* const name) {
+    return names.empty() ||
+           std::find(names.begin(), names.end(), name) != names.end();
+  };
+
+  // The same combinations the solver accepts, see
+  // error_algorithm_heuristic_combination.
+  struct Combination {
+    Instance_Algorithm const* algorithm;
+    Instance_Heuristic const* heuristic;
+    i64 solved = 0;
+    i64 explored = 0;
+    i64 time_ns = 0;
+    i64 peak_rss_bytes = 0;
+  };
+
+  std::vector<Combination> combinations;
+  for(Instance_Algorithm const& algorithm: instance_algorithms) {
+    for(Instance_Heuristic const& heuristic: instance_heuristics) {
+      if(selected(options.algorithms, algorithm.name) &&
+         selected(options.heuristics, heuristic.name) &&
+         heuristic.forward != nullptr &&
+         (!algorithm.backward || heuristic.backward != nullptr)) {
+        combinations.push_back(
+          Combination{.algorithm = &algorithm, .heuristic = &heuristic});
+      }
+    }
+  }
+
+  if(selected(options.heuristics, "PDB")) {
+    // Built once in the harness and shared with the children.
+    i32 const threads = std::thread::hardware_concurrency();
+    puzzle15::Pattern_Database_Statistics const database =
+      puzzle15::build_pattern_database(
+        {.cache_path = "pdb-5-5-5.bin", .threads = threads > 0 ? threads : 1});
+    if(!database.loaded && !database.saved) {
+      fprintf(stderr, "warning: could not write pattern database cache "
+                      "pdb-5-5-5.bin\n");
+    }
+  }
+
+  printf("instance,algorithm,heuristic,status,length,explored,time_ms,"
+         "nodes_per_second,peak_rss_bytes\n");
+  for(i64 i = 0; i < (i64)instances.size(); i += 1) {
+    for(Combination& combination: combinations) {
+      Instance_Run const run =
+        run_instance(*combination.algorithm, *combination.heuristic,
+                     instances[i], options);
+      double const nodes_per_second =
+        run.time_ns > 0 ? run.explored * 1000000000.0 / run.time_ns : 0.0;
+      printf("%lld,%s,%s,%s,%lld,%lld,%.3f,%.0f,%lld\n", i + 1,
+             combination.algorithm->name, combination.heuristic->name,
+             run_status_string(run.status), run.length, run.explored,
+             run.time_ns / 1000000.0, nodes_per_second, run.peak_rss_bytes);
+      combination.solved += run.status == Run_Status::solved;
+      combination.explored += run.explored;
+      combination.time_ns += run.time_ns;
+      if(run.peak_rss_bytes > combination.peak_rss_bytes) {
+        combination.peak_rss_bytes = run.peak_rss_bytes;
+      }
+    }
+  }
+
+  fflush(stdout);
+  for(Combination const& combination: combinations) {
+    fprintf(stderr,
+            "%-5s %-3s %3lld/%-3lld solved %12lld nodes %10.1fms %12lld "
+            "peak bytes\n",
+            combination.algorithm->name, combination.heuristic->name,
+            combination.solved, (i64)instances.size(), combination.explored,
+            combination.time_ns / 1000000.0, combination.peak_rss_bytes);
+  }
+  return true;
+}
+
+// generate_by_direction
+// Enumerate the configurations up to depth moves below the last configuration
+// of path. Every direction is tested against the board edges and every
+// successor is looked up on the path.
+//
+// Returns:
+// Number of generated configurations.
+//
+static i64 generate_by_direction(std::vector<puzzle15::State>& path,
+                                 i32 const depth, u64& checksum) {
+  using puzzle15::Puzzle;
+  puzzle15::State const state = path.back();
+  i64 generated = 0;
+  for(i32 successor = 0; successor < 4; successor += 1) {
+    i32 const target = Puzzle::successor_target(state.empty, successor);
+    if(target < 0) {
+      continue;
+    }
+
+    puzzle15::State const next = Puzzle::move_empty(state, target);
+    bool contains = false;
+    for(puzzle15::State const s: path) {
+      if(s.board == next.board) {
+        contains = true;
+        break;
+      }
+    }
+
+    if(contains) {
+      continue;
+    }
+
+    generated += 1;
+    checksum ^= next.board;
+    if(depth > 1) {
+      path.push_back(next);
+      generated += generate_by_direction(path, depth - 1, checksum);
+      path.pop_back();
+    }
+  }
+  return generated;
+}
+
+// generate_by_table
+// Enumerate the configurations up to depth moves below state walking the
+// move table. Only the move back to parent_empty is skipped.
+//
+// Returns:
+// Number of generated configurations.
+//
+static i64 generate_by_table(puzzle15::State const state,
+                             i32 const parent_empty, i32 const depth,
+                             u64& checksum) {
+  using puzzle15::Puzzle;
+  i64 generated = 0;
+  for(i32 const target: Puzzle::moves(state.empty)) {
+    if(target == parent_empty) {
+      continue;
+    }
+
+    puzzle15::State const next = Puzzle::move_empty(state, target);
+    generated += 1;
+    checksum ^= next.board;
+    if(depth > 1) {
+      generated += generate_by_table(next, state.empty, depth - 1, checksum);
+    }
+  }
+  return generated;
+}
+
+static void benchmark_generation() {
+  constexpr i32 depth = 22;
+  puzzle15::State const start =
+    puzzle15::pack_configuration(benchmark_configuration);
+  auto const report = [](char const* const name, i64 const generated,
+                         i64 const time, u64 const checksum) {
+    printf("%-10s %10lld nodes %8.1fms %12.0f nodes/s (checksum %016llx)\n",
+           name, generated, time / 1000000.0,
+           time > 0 ? generated * 1000000000.0 / time : 0.0, checksum);
+  };
+
+  {
+    std::vector<puzzle15::State> path = {start};
+    u64 checksum = 0;
+    Timer timer;
+    timer.start();
+    i64 const generated = generate_by_direction(path, depth, checksum);
+    report("directions", generated, timer.end_ns(), checksum);
+  }
+
+  {
+    u64 checksum = 0;
+    Timer timer;
+    timer.start();
+    i64 const generated = generate_by_table(start, -1, depth, checksum);
+    report("table", generated, timer.end_ns(), checksum);
+  }
+}
+
+struct Open_List_Node {
+  u64 key = 0;
+  i32 g = 0;
+  i32 h = 0;
+};
+
+struct Open_List_Compare {
+  std::vector<Open_List_Node> const* nodes;
+
+  [[nodiscard]] bool operator()(u32 const lhs_index,
+                                u32 const rhs_index) const {
+    Open_List_Node const& lhs = (*nodes)[lhs_index];
+    Open_List_Node const& rhs = (*nodes)[rhs_index];
+    bool const less = (lhs.g + lhs.h) < (rhs.g + rhs.h);
+    bool const equal = (lhs.g + lhs.h) == (rhs.g + rhs.h);
+    return less || (equal && lhs.h < rhs.h);
+  }
+};
+
+struct Open_List_Compare_ID {
+  std::vector<Open_List_Node> const* nodes;
+
+  [[nodiscard]] bool operator()(u32 const lhs, u32 const rhs) const {
+    return (*nodes)[lhs].key < (*nodes)[rhs].key;
+  }
+
+  [[nodiscard]] bool operator()(u32 const lhs, u64 const rhs) const {
+    return (*nodes)[lhs].key < rhs;
+  }
+
+  [[nodiscard]] bool operator()(u64 const lhs, u32 const rhs) const {
+    return lhs < (*nodes)[rhs].key;
+  }
+};
+
+struct Open_List_Priority_Function {
+  std::vector<Open_List_Node> const* nodes;
+
+  [[nodiscard]] Open_List_Priority operator()(u32 const index) const {
+    Open_List_Node const& node = (*nodes)[index];
+    return Open_List_Priority{.f = node.g + node.h, .g = node.g};
+  }
+};
+
+// run_open_list_workload
+// Insert all nodes, lower g of every 4th node and extract all nodes.
+//
+// Parameters:
+// decrease - invoked as decrease(index) after g of the node has been lowered.
+//
+template<typename Insert, typename Decrease, typename Extract>
+static void run_open_list_workload(char const* const name,
+                                   std::vector<Open_List_Node>& nodes,
+                                   Insert&& insert, Decrease&& decrease,
+                                   Extract&& extract) {
+  i64 const count = nodes.size();
+  Timer timer;
+  timer.start();
+  for(i64 i = 0; i < count; i += 1) {
+    insert(i);
+  }
+  i64 const insert_time = timer.end_ns();
+
+  timer.start();
+  i64 decreases = 0;
+  for(i64 i = 0; i < count; i += 4) {
+    if(nodes[i].g > 0) {
+      nodes[i].g -= 1;
+      decrease(i);
+      decreases += 1;
+    }
+  }
+  i64 const decrease_time = timer.end_ns();
+
+  timer.start();
+  // Checksum of the extraction order so that the extraction is not
+  // optimised away and both lists can be compared.
+  u64 checksum = 0;
+  for(i64 i = 0; i < count; i += 1) {
+    Open_List_Node const& node = nodes[extract()];
+    checksum = checksum * 31 + node.g + node.h;
+  }
+  i64 const extract_time = timer.end_ns();
+
+  auto const throughput = [](i64 const operations, i64 const time) {
+    return time > 0 ? operations * 1000.0 / time : 0.0;
+  };
+  printf(
+    "%-8s insert %8.2f Mop/s  decrease %8.2f Mop/s  extract %8.2f Mop/s  "
+    "(checksum %016llx)\n",
+    name, throughput(count, insert_time),
+    throughput(decreases, decrease_time), throughput(count, extract_time),
+    checksum);
+}
+
+static void benchmark_open_list() {
+  constexpr i64 count = 1 << 20;
+
+  // Costs of the nodes generated by A* on hard instances, g up to 80 and h
+  // in a narrow band around the f limit.
+  std::vector<Open_List_Node> initial_nodes(count);
+  std::mt19937_64 random(0x15);
+  std::uniform_int_distribution<i32> g_distribution(1, 80);
+  std::uniform_int_distribution<i32> h_distribution(0, 10);
+  for(i64 i = 0; i < count; i += 1) {
+    i32 const g = g_distribution(random);
+    i32 const h = 80 - g + h_distribution(random);
+    initial_nodes[i] = Open_List_Node{.key = random(), .g = g, .h = h};
+  }
+
+  {
+    std::vector<Open_List_Node> nodes = initial_nodes;
+    using heap_t = Heap<u32, Open_List_Compare, Open_List_Compare_ID>;
+    heap_t heap(Open_List_Compare{&nodes}, Open_List_Compare_ID{&nodes});
+    run_open_list_workload(
+      "heap", nodes, [&](u32 const i) { heap.insert(i); },
+      [&](u32 const i) { heap.decrease(heap.find(nodes[i].key)); },
+      [&] { return heap.extract(); });
+  }
+
+  {
+    std::vector<Open_List_Node> nodes = initial_nodes;
+    Bucket_Open_List<u32, Open_List_Priority_Function> buckets(
+      Open_List_Priority_Function{&nodes});
+    run_open_list_workload(
+      "buckets", nodes, [&](u32 const i) { buckets.insert(i); },
+      [&](u32 const i) { buckets.decrease(i); },
+      [&] { return buckets.extract(); });
+  }
+}
+
+int main(int const argc, char** const argv) {
+  constexpr i32 RETURN_SUCCESS = 0;
+  constexpr i32 RETURN_ERROR = 1;
+  constexpr i32 RETURN_HELP = 2;
+
+  if(argc < 2) {
+    help(argv[0]);
+    return RETURN_HELP;
+  }
+
+  std::string_view const benchmark(argv[1]);
+  if(benchmark == "-h" || benchmark == "--help") {
+    help(argv[0]);
+    return RETURN_HELP;
+  }
+
+  if(benchmark == "heuristic") {
+    benchmark_heuristic();
+  } else if(benchmark == "suite") {
+    benchmark_suite();
+  } else if(benchmark == "instances") {
+    if(!benchmark_instances(argc - 2, argv + 2)) {
+      return RETURN_ERROR;
+    }
+  } else if(benchmark == "generation") {
+    benchmark_generation();
+  } else if(benchmark == "open-list") {
+    benchmark_open_list();
+  } else {
+    printf("error: unrecognised benchmark: %s\n", argv[1]);
+    return RETURN_ERROR;
+  }
+
+  return RETURN_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+
+#include <types.hpp>
+
+struct Open_List_Priority {
+  // Value of the evaluation function, f = g + h.
+  i32 f = 0;
+  // Value of the path cost function.
+  i32 g = 0;
+};
+
+// Bucket_Open_List
+// Open list for small non-negative integer costs. Entries are kept in LIFO
+// stacks indexed by (f, g). Extraction takes the smallest f and among those
+// the largest g, i.e. the node closest to the goal according to the
+// heuristic, and among equal (f, g) the most recently inserted one.
+//
+// The priority of an entry is not stored in the list, it is read through
+// Priority, which is invoked as priority(value) and returns an
+// Open_List_Priority. decrease does not remove the entry from its old stack,
+// instead the old entry is discarded during extraction because its stack no
+// longer matches the priority of the value. Thus the priority of a value may
+// only be changed by the list's user right before a call to decrease and g
+// must strictly decrease.
+//
+template<typename T, typename Priority>
+struct Bucket_Open_List {
+  private:
+  // Both f and g must be smaller than max_cost.
+  static constexpr i32 max_cost = 256;
+
+  struct Bucket {
+    // Stacks indexed by g. Grown on demand.
+    std::vector<std::vector<T>> stacks;
+    // Largest g of a possibly non-empty stack.
+    i32 top_g = -1;
+  };
+
+  // Buckets indexed by f.
+  std::vector<Bucket> buckets;
+  Priority priority;
+  i64 count = 0;
+  i32 min_f = max_cost;
+
+  public:
+  explicit Bucket_Open_List(Priority priority)
+    : buckets(max_cost), priority(priority) {}
+
+  void insert(T const& value) {
+    push(value);
+    count += 1;
+  }
+
+  // extract
+  // Remove the value with the highest priority. The list must not be empty.
+  //
+  [[nodiscard]] T extract() {
+    while(true) {
+      Bucket& bucket = buckets[min_f];
+      i32& g = bucket.top_g;
+      while(g >= 0 && bucket.stacks[g].size() == 0) {
+        g -= 1;
+      }
+
+      if(g < 0) {
+        min_f += 1;
+        continue;
+      }
+
+      std::vector<T>& stack = bucket.stacks[g];
+      T const value = stack.back();
+      stack.pop_back();
+      Open_List_Priority const p = priority(value);
+      // Stale entry left behind by decrease.
+      if(p.f != min_f || p.g != g) {
+        continue;
+      }
+
+      count -= 1;
+      return value;
+    }
+  }
+
+  // decrease
+  // Move value to the stack of its new priority. value must be in the list.
+  //
+  void decrease(T const& value) {
+    push(value);
+  }
+
+  [[nodiscard]] i64 size() const {
+    return count;
+  }
+
+  private:
+  void push(T const& value) {
+    Open_List_Priority const p = priority(value);
+    Bucket& bucket = buckets[p.f];
+    if(p.g >= (i32)bucket.stacks.size()) {
+      bucket.stacks.resize(p.g + 1);
+    }
+    bucket.stacks[p.g].push_back(value);
+    if(p.g > bucket.top_g) {
+      bucket.top_g = p.g;
+    }
+    if(p.f < min_f) {
+      min_f = p.f;
+    }
+  }
+};
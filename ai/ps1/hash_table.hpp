@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <types.hpp>
+
+struct Hash_Table_Statistics {
+  // Number of slots inspected by a lookup grouped by the probe length. The
+  // last bucket collects all probes of length equal or greater to its index.
+  std::array<i64, 16> probe_histogram = {};
+  i64 lookups = 0;
+  i64 probes = 0;
+  i64 max_probe_length = 0;
+  i64 capacity = 0;
+  i64 size = 0;
+  i64 bytes = 0;
+
+  void accumulate(Hash_Table_Statistics const& other) {
+    for(i64 i = 0; i < (i64)probe_histogram.size(); i += 1) {
+      probe_histogram[i] += other.probe_histogram[i];
+    }
+    lookups += other.lookups;
+    probes += other.probes;
+    if(other.max_probe_length > max_probe_length) {
+      max_probe_length = other.max_probe_length;
+    }
+    capacity += other.capacity;
+    size += other.size;
+    bytes += other.bytes;
+  }
+};
+
+// Hash_Table
+// Open addressing hash table with linear probing keyed on packed board
+// configurations (see hash_configuration). Keys and values are stored in
+// separate arrays so that probing touches only the keys.
+//
+// The key 0 denotes an empty slot. A packed configuration is never 0 because
+// a board contains non-zero tiles.
+//
+template<typename Value>
+struct Hash_Table {
+  private:
+  // Maximum load factor expressed as a fraction of 1024.
+  static constexpr i64 max_load = 716;
+
+  std::vector<u64> keys;
+  std::vector<Value> values;
+  i64 mask = 0;
+  i64 count = 0;
+  u32 shift = 0;
+  Hash_Table_Statistics stats;
+
+  public:
+  struct Insert_Result {
+    Value* value;
+    bool inserted;
+  };
+
+  // Hash_Table
+  //
+  // Parameters:
+  // capacity - initial number of slots. Rounded up to a power of 2.
+  //
+  explicit Hash_Table(i64 const capacity = 1 << 16) {
+    i64 c = 16;
+    while(c < capacity) {
+      c <<= 1;
+    }
+    allocate(c);
+  }
+
+  // find
+  //
+  // Returns:
+  // Pointer to the value associated with key or nullptr if the key is not
+  // present in the table. The pointer is invalidated by insert.
+  //
+  [[nodiscard]] Value* find(u64 const key) {
+    i64 probe_length = 1;
+    for(i64 i = slot(key);; i = (i + 1) & mask, probe_length += 1) {
+      if(keys[i] == key) {
+        record_probe(probe_length);
+        return &values[i];
+      }
+
+      if(keys[i] == 0) {
+        record_probe(probe_length);
+        return nullptr;
+      }
+    }
+  }
+
+  // insert
+  // Insert value under key unless the key is already present in which case
+  // the table is not modified.
+  //
+  // Returns:
+  // Pointer to the value stored under key and whether the insertion took
+  // place. The pointer is invalidated by subsequent inserts.
+  //
+  Insert_Result insert(u64 const key, Value const& value) {
+    if((count + 1) * 1024 > (mask + 1) * max_load) {
+      grow();
+    }
+
+    i64 probe_length = 1;
+    for(i64 i = slot(key);; i = (i + 1) & mask, probe_length += 1) {
+      if(keys[i] == key) {
+        record_probe(probe_length);
+        return Insert_Result{&values[i], false};
+      }
+
+      if(keys[i] == 0) {
+        record_probe(probe_length);
+        keys[i] = key;
+        values[i] = value;
+        count += 1;
+        return Insert_Result{&values[i], true};
+      }
+    }
+  }
+
+  [[nodiscard]] i64 size() const {
+    return count;
+  }
+
+  [[nodiscard]] Hash_Table_Statistics statistics() const {
+    Hash_Table_Statistics s = stats;
+    s.capacity = mask + 1;
+    s.size = count;
+    s.bytes = (mask + 1) * (sizeof(u64) + sizeof(Value));
+    return s;
+  }
+
+  private:
+  [[nodiscard]] i64 slot(u64 const key) const {
+    // Fibonacci hashing. The packed configuration is a perfect hash, but its
+    // low bits are highly correlated between neighbouring configurations.
+    return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+  }
+
+  void record_probe(i64 const probe_length) {
+    i64 const last_bucket = stats.probe_histogram.size() - 1;
+    stats.probe_histogram[probe_length < last_bucket ? probe_length
+                                                     : last_bucket] += 1;
+    stats.lookups += 1;
+    stats.probes += probe_length;
+    if(probe_length > stats.max_probe_length) {
+      stats.max_probe_length = probe_length;
+    }
+  }
+
+  void allocate(i64 const capacity) {
+    keys.assign(capacity, 0);
+    values.resize(capacity);
+    mask = capacity - 1;
+    shift = 64;
+    for(i64 c = capacity; c > 1; c >>= 1) {
+      shift -= 1;
+    }
+  }
+
+  void grow() {
+    std::vector<u64> old_keys = std::move(keys);
+    std::vector<Value> old_values = std::move(values);
+    keys = {};
+    values = {};
+    allocate((mask + 1) * 2);
+    for(i64 i = 0; i < (i64)old_keys.size(); i += 1) {
+      u64 const key = old_keys[i];
+      if(key == 0) {
+        continue;
+      }
+
+      i64 j = slot(key);
+      while(keys[j] != 0) {
+        j = (j + 1) & mask;
+      }
+      keys[j] = key;
+      values[j] = std::move(old_values[i]);
+    }
+  }
+};
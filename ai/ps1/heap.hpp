@@ -83,14 +83,14 @@ public:
   void insert(Args&&... args) {
     Node* const node = new Node(std::forward<Args>(args)...);
     insert_heap(node);
-    // insert_tree(node);
+    insert_tree(node);
     nodes += 1;
   }
 
   [[nodiscard]] T extract() {
     Node* const node = heap_root;
     erase_heap(node);
-    // erase_tree(node);
+    erase_tree(node);
     T value = std::move(node->value);
     delete node;
     nodes -= 1;
@@ -1,113 +1,281 @@
 #include <heuristic.hpp>
 
-#include <queue>
-#include <unordered_map>
+#include <stdlib.h>
 
 #include <debug.hpp>
 
-namespace puzzle8 {
-  i32 heuristic_manhattan_distance(Configuration_View const configuration) {
-    i32 result = 0;
-    for(i32 index = 0; Configuration_Entry const value: configuration) {
-      i32 const index_x = index % 3;
-      i32 const index_y = index / 3;
-      i32 const value_x = (value - 1) % 3;
-      i32 const value_y = (value - 1) / 3;
-      result += abs(index_x - value_x) + abs(index_y - value_y);
-    }
-    return result;
+// Goal_Positions
+// Index of the goal square of every tile. The entry of the empty square (0)
+// is unused.
+//
+template<typename Puzzle>
+using Goal_Positions = std::array<i8, Puzzle::cells>;
+
+template<typename Puzzle>
+static constexpr Goal_Positions<Puzzle> standard_goal_positions = [] {
+  Goal_Positions<Puzzle> positions = {};
+  for(i32 tile = 1; tile < Puzzle::cells; tile += 1) {
+    positions[tile] = tile - 1;
   }
-} // namespace puzzle8
+  return positions;
+}();
 
-namespace puzzle15 {
-  // remap_to_standard
-  // Remap the start configuration into a space in which goal configuration is
-  // the standard configuration.
-  //
-  static Configuration remap_to_standard(Configuration_View const start,
-                                         Configuration_View const goal) {
-    Configuration r_start;
-    Configuration map;
-    for(i32 index = 1; Configuration_Entry const g: goal) {
-      map[g - 1] = index;
-      index += 1;
+template<typename Puzzle>
+[[nodiscard]] static Goal_Positions<Puzzle>
+compute_goal_positions(typename Puzzle::board_t const goal) {
+  Goal_Positions<Puzzle> positions = {};
+  for(i32 index = 0; index < Puzzle::cells; index += 1) {
+    positions[Puzzle::get_tile(goal, index)] = index;
+  }
+  return positions;
+}
+
+template<typename Puzzle>
+[[nodiscard]] static i32
+manhattan_distance(typename Puzzle::board_t const board,
+                   Goal_Positions<Puzzle> const& goal) {
+  i32 result = 0;
+  for(i32 index = 0; index < Puzzle::cells; index += 1) {
+    i32 const tile = Puzzle::get_tile(board, index);
+    if(tile == 0) {
+      continue;
     }
 
-    for(i32 index = 0; Configuration_Entry const s: start) {
-      r_start[index] = map[s - 1];
-      index += 1;
+    i32 const position = goal[tile];
+    result += abs(Puzzle::column(index) - Puzzle::column(position)) +
+              abs(Puzzle::row(index) - Puzzle::row(position));
+  }
+  return result;
+}
+
+// Manhattan distance of every tile from every square to its standard goal
+// square.
+template<typename Puzzle>
+static constexpr std::array<std::array<i8, Puzzle::cells>, Puzzle::cells>
+  manhattan_table = [] {
+    std::array<std::array<i8, Puzzle::cells>, Puzzle::cells> table = {};
+    for(i32 tile = 1; tile < Puzzle::cells; tile += 1) {
+      i32 const position = standard_goal_positions<Puzzle>[tile];
+      for(i32 index = 0; index < Puzzle::cells; index += 1) {
+        i32 const dx = Puzzle::column(index) - Puzzle::column(position);
+        i32 const dy = Puzzle::row(index) - Puzzle::row(position);
+        table[tile][index] = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+      }
     }
+    return table;
+  }();
 
-    return r_start;
+template<typename Puzzle>
+[[nodiscard]] static i32
+standard_manhattan_distance(typename Puzzle::board_t const board) {
+  i32 result = 0;
+  for(i32 index = 0; index < Puzzle::cells; index += 1) {
+    result += manhattan_table<Puzzle>[Puzzle::get_tile(board, index)][index];
   }
+  return result;
+}
 
-  i32 heuristic_manhattan_distance(Configuration_View const start) {
-    i32 result = 0;
-    for(i32 index = 0; Configuration_Entry const value: start) {
-      if(value == 16) {
-        continue;
+template<typename Puzzle>
+[[nodiscard]] static i32
+manhattan_distance_delta(typename Puzzle::board_t const board, i32 const tile,
+                         i32 const empty) {
+  i32 const value = Puzzle::get_tile(board, tile);
+  return manhattan_table<Puzzle>[value][empty] -
+         manhattan_table<Puzzle>[value][tile];
+}
+
+// line_conflicts
+// Calculate the number of additional moves required to resolve the conflicts
+// between the tiles in a single line. Tiles which have to leave the line are
+// exactly the ones outside of the longest chain of tiles already in the
+// correct relative order.
+//
+// Parameters:
+// keys - goal positions along the line of the tiles whose goal is in this
+//        line in the order in which they appear in the line.
+// count - number of keys. At most Length.
+//
+template<i32 Length>
+[[nodiscard]] static i32 line_conflicts(i32 const* const keys,
+                                        i32 const count) {
+  // Longest increasing subsequence.
+  i32 lengths[Length];
+  i32 longest = 0;
+  for(i32 i = 0; i < count; i += 1) {
+    lengths[i] = 1;
+    for(i32 j = 0; j < i; j += 1) {
+      if(keys[j] < keys[i] && lengths[j] + 1 > lengths[i]) {
+        lengths[i] = lengths[j] + 1;
       }
+    }
+    if(lengths[i] > longest) {
+      longest = lengths[i];
+    }
+  }
+  return 2 * (count - longest);
+}
 
-      i32 const index_x = index % 4;
-      i32 const index_y = index / 4;
-      i32 const value_x = (value - 1) % 4;
-      i32 const value_y = (value - 1) / 4;
-      result += abs(index_x - value_x) + abs(index_y - value_y);
-      index += 1;
+template<typename Puzzle>
+[[nodiscard]] static i32 row_conflicts(typename Puzzle::board_t const board,
+                                       Goal_Positions<Puzzle> const& goal,
+                                       i32 const row) {
+  constexpr i32 width = Puzzle::width;
+  i32 keys[width];
+  i32 count = 0;
+  for(i32 column = 0; column < width; column += 1) {
+    i32 const tile = Puzzle::get_tile(board, row * width + column);
+    if(tile != 0 && Puzzle::row(goal[tile]) == row) {
+      keys[count] = Puzzle::column(goal[tile]);
+      count += 1;
     }
-    return result;
   }
+  return line_conflicts<width>(keys, count);
+}
 
-  i32 heuristic_manhattan_distance_generic(Configuration_View const start,
-                                           Configuration_View const goal) {
-    Configuration const c = remap_to_standard(start, goal);
-    return heuristic_manhattan_distance(c);
+template<typename Puzzle>
+[[nodiscard]] static i32
+column_conflicts(typename Puzzle::board_t const board,
+                 Goal_Positions<Puzzle> const& goal, i32 const column) {
+  constexpr i32 width = Puzzle::width;
+  constexpr i32 height = Puzzle::height;
+  i32 keys[height];
+  i32 count = 0;
+  for(i32 row = 0; row < height; row += 1) {
+    i32 const tile = Puzzle::get_tile(board, row * width + column);
+    if(tile != 0 && Puzzle::column(goal[tile]) == column) {
+      keys[count] = Puzzle::row(goal[tile]);
+      count += 1;
+    }
   }
+  return line_conflicts<height>(keys, count);
+}
 
-  static i32 count_conflicts(Configuration_View const start) {
-    i32 sum = 0;
-    for(i32 row_offset = 0; row_offset < 16; row_offset += 4) {
-      for(i32 i = 0; i < 4; i += 1) {
-        Configuration_Entry const e1 = start[row_offset + i] - 1;
-        // Entry is the empty square or does not belong in this row.
-        if(e1 == 16 || e1 < row_offset || e1 >= row_offset + 4) {
-          continue;
-        }
+template<typename Puzzle>
+[[nodiscard]] static i32
+line_conflicts_sum(typename Puzzle::board_t const board,
+                   Goal_Positions<Puzzle> const& goal) {
+  i32 sum = 0;
+  for(i32 row = 0; row < Puzzle::height; row += 1) {
+    sum += row_conflicts<Puzzle>(board, goal, row);
+  }
+  for(i32 column = 0; column < Puzzle::width; column += 1) {
+    sum += column_conflicts<Puzzle>(board, goal, column);
+  }
+  return sum;
+}
 
-        for(i32 j = i + 1; j < 4; j += 1) {
-          Configuration_Entry const e2 = start[row_offset + j] - 1;
-          // Entry is the empty square or does not belong in this row.
-          if(e2 == 16 || e2 < row_offset || e2 >= row_offset + 4) {
-            continue;
-          }
+template<typename Puzzle>
+[[nodiscard]] static i32
+linear_conflict(typename Puzzle::board_t const board,
+                Goal_Positions<Puzzle> const& goal) {
+  return manhattan_distance<Puzzle>(board, goal) +
+         line_conflicts_sum<Puzzle>(board, goal);
+}
 
-          if(e1 > e2) {
-            sum += 2;
-          }
-        }
+template<typename Puzzle>
+[[nodiscard]] static i32
+linear_conflict_delta(typename Puzzle::board_t const board, i32 const tile,
+                      i32 const empty) {
+  Goal_Positions<Puzzle> const& goal = standard_goal_positions<Puzzle>;
+  typename Puzzle::board_t const next =
+    Puzzle::move_empty({board, empty}, tile).board;
+  i32 delta = manhattan_distance_delta<Puzzle>(board, tile, empty);
+  if(Puzzle::row(tile) == Puzzle::row(empty)) {
+    // Horizontal move. The tile changes columns.
+    i32 const from = Puzzle::column(tile);
+    i32 const to = Puzzle::column(empty);
+    delta += column_conflicts<Puzzle>(next, goal, from) -
+             column_conflicts<Puzzle>(board, goal, from);
+    delta += column_conflicts<Puzzle>(next, goal, to) -
+             column_conflicts<Puzzle>(board, goal, to);
+  } else {
+    // Vertical move. The tile changes rows.
+    i32 const from = Puzzle::row(tile);
+    i32 const to = Puzzle::row(empty);
+    delta += row_conflicts<Puzzle>(next, goal, from) -
+             row_conflicts<Puzzle>(board, goal, from);
+    delta += row_conflicts<Puzzle>(next, goal, to) -
+             row_conflicts<Puzzle>(board, goal, to);
+  }
+  return delta;
+}
+
+namespace puzzle8 {
+  i32 heuristic_manhattan_distance(u64 const board) {
+    return standard_manhattan_distance<Puzzle>(board);
+  }
+
+  i32 heuristic_manhattan_distance_delta(u64 const board, i32 const tile,
+                                         i32 const empty) {
+    return manhattan_distance_delta<Puzzle>(board, tile, empty);
+  }
+
+  i32 heuristic_linear_conflict(u64 const board) {
+    return linear_conflict<Puzzle>(board, standard_goal_positions<Puzzle>);
+  }
+
+  i32 heuristic_linear_conflict_delta(u64 const board, i32 const tile,
+                                      i32 const empty) {
+    return linear_conflict_delta<Puzzle>(board, tile, empty);
+  }
+} // namespace puzzle8
+
+namespace puzzle15 {
+  Goal_Remap make_goal_remap(u64 const goal) {
+    Goal_Remap remap;
+    remap.goal = goal;
+    remap.squares = compute_goal_positions<Puzzle>(goal);
+    for(i32 tile = 1; tile < 16; tile += 1) {
+      i32 const position = remap.squares[tile];
+      for(i32 index = 0; index < 16; index += 1) {
+        i32 const dx = Puzzle::column(index) - Puzzle::column(position);
+        i32 const dy = Puzzle::row(index) - Puzzle::row(position);
+        remap.manhattan[tile][index] = abs(dx) + abs(dy);
       }
     }
-    return sum;
+    return remap;
   }
 
-  i32 heuristic_linear_conflict(Configuration_View const start) {
-    i32 sum = heuristic_manhattan_distance(start);
-    sum += count_conflicts(start);
-    // Transpose the configuration to count column conflicts.
-    Configuration t = copy_configuration(start);
-    for(i32 i = 0; i < 4; i += 1) {
-      for(i32 j = i + 1; j < 4; j += 1) {
-        std::swap(t[i * 4 + j], t[j * 4 + i]);
-      }
+  // remapped_manhattan_distance
+  // Same cost as the standard Manhattan Distance, the goal has been
+  // folded into the table.
+  //
+  [[nodiscard]] static i32 remapped_manhattan_distance(u64 const board,
+                                                       Goal_Remap const& goal) {
+    i32 result = 0;
+    for(i32 index = 0; index < 16; index += 1) {
+      result += goal.manhattan[get_tile(board, index)][index];
     }
-    sum += count_conflicts(t);
-    return sum;
+    return result;
   }
 
-  i32 heuristic_linear_conflict_generic(Configuration_View const start,
-                                        Configuration_View const goal) {
-    Configuration const c = remap_to_standard(start, goal);
-    return heuristic_linear_conflict(c);
+  i32 heuristic_manhattan_distance(u64 const board) {
+    return standard_manhattan_distance<Puzzle>(board);
+  }
+
+  i32 heuristic_manhattan_distance_delta(u64 const board, i32 const tile,
+                                         i32 const empty) {
+    return manhattan_distance_delta<Puzzle>(board, tile, empty);
+  }
+
+  i32 heuristic_manhattan_distance_generic(u64 const board,
+                                           Goal_Remap const& goal) {
+    return remapped_manhattan_distance(board, goal);
+  }
+
+  i32 heuristic_linear_conflict(u64 const board) {
+    return linear_conflict<Puzzle>(board, standard_goal_positions<Puzzle>);
+  }
+
+  i32 heuristic_linear_conflict_generic(u64 const board,
+                                        Goal_Remap const& goal) {
+    return remapped_manhattan_distance(board, goal) +
+           line_conflicts_sum<Puzzle>(board, goal.squares);
+  }
+
+  i32 heuristic_linear_conflict_delta(u64 const board, i32 const tile,
+                                      i32 const empty) {
+    return linear_conflict_delta<Puzzle>(board, tile, empty);
   }
 
   i32 heuristic_inversions(Configuration_View const start) {
@@ -136,176 +304,24 @@ namespace puzzle15 {
     // }
     return inversions;
   }
+} // namespace puzzle15
 
-  using block_database = std::unordered_map<u64, i32>;
-
-  static void build_block_database(block_database& db,
-                                   Configuration block_configuration) {
-    struct Pattern {
-      Configuration configuration;
-      u64 id;
-      i32 cost;
-    };
-
-    std::queue<Pattern> pattern_queue;
-    {
-      u64 const hash = hash_configuration(block_configuration);
-      db.emplace(hash, 0);
-      pattern_queue.push(Pattern{block_configuration, hash, 0});
-    }
-    while(pattern_queue.size() > 0) {
-      Pattern pattern = pattern_queue.front();
-      pattern_queue.pop();
-
-      for(i32 index = -1; Configuration_Entry const v: pattern.configuration) {
-        index += 1;
-        if(v == 0) {
-          continue;
-        }
-
-        i32 const new_cost = pattern.cost + 1;
-        i32 const x = index % 4;
-        i32 const y = index / 4;
-        // Attempt move left.
-        if(x > 0 && pattern.configuration[index - 1] == 0) {
-          Configuration configuration(pattern.configuration);
-          std::swap(configuration[index], configuration[index - 1]);
-          u64 const hash = hash_configuration(configuration);
-          if(db.find(hash) == db.end()) {
-            db.emplace(hash, new_cost);
-            pattern_queue.push(Pattern{configuration, hash, new_cost});
-          }
-        }
-        // Attempt move right.
-        if(x < 3 && pattern.configuration[index + 1 == 0]) {
-          Configuration configuration(pattern.configuration);
-          std::swap(configuration[index], configuration[index + 1]);
-          u64 const hash = hash_configuration(configuration);
-          if(db.find(hash) == db.end()) {
-            db.emplace(hash, new_cost);
-            pattern_queue.push(Pattern{configuration, hash, new_cost});
-          }
-        }
-        // Attempt move up.
-        if(y > 0 && pattern.configuration[index - 4] == 0) {
-          Configuration configuration(pattern.configuration);
-          std::swap(configuration[index], configuration[index - 4]);
-          u64 const hash = hash_configuration(configuration);
-          if(db.find(hash) == db.end()) {
-            db.emplace(hash, new_cost);
-            pattern_queue.push(Pattern{configuration, hash, new_cost});
-          }
-        }
-        // Attempt move down.
-        if(y < 3 && pattern.configuration[index + 4] == 0) {
-          Configuration configuration(pattern.configuration);
-          std::swap(configuration[index], configuration[index + 4]);
-          u64 const hash = hash_configuration(configuration);
-          if(db.find(hash) == db.end()) {
-            db.emplace(hash, new_cost);
-            pattern_queue.push(Pattern{configuration, hash, new_cost});
-          }
-        }
-      }
-    }
+namespace puzzle24 {
+  i32 heuristic_manhattan_distance(u128 const board) {
+    return standard_manhattan_distance<Puzzle>(board);
   }
 
-  // We divide the board into three blocks of 5 tiles.
-  //
-  //     ###################$$$$$$
-  //     #     |     |     #     $
-  //     #  1  |  2  |  3  #  4  $
-  //     #     |     |     #     $
-  //     #-----+-----#######-----$
-  //     #     |     #     |     $
-  //     #  5  |  6  #  7  |  8  $
-  //     #     |     #     |     $
-  //     #############-----+-----$
-  //     @     |     @     |     $
-  //     @  9  | 10  @ 11  | 12  $
-  //     @     |     @     |     $
-  //     @-----+-----@@@@@@@$$$$$$
-  //     @     |     |     @     |
-  //     @ 13  | 14  | 15  @ 16  |
-  //     @     |     |     @     |
-  //     @@@@@@@@@@@@@@@@@@@-----+
-  //
-  // And generate patterns for each group into a separate set. We will sum the
-  // values of the 3 blocks when we calculate the heuristic.
-
-  static block_database block1_database;
-  static block_database block2_database;
-  static block_database block3_database;
-
-  void build_pattern_database() {
-    DEBUG_PRINT("Building block 1\n");
-    block1_database.max_load_factor(0.7f);
-    Configuration block1_configuration{1, 2, 3, 0, //
-                                       5, 6, 0, 0, //
-                                       0, 0, 0, 0, //
-                                       0, 0, 0, 0};
-    build_block_database(block1_database, block1_configuration);
-    DEBUG_PRINT("Block database 1 size %llu\n", (i64)block1_database.size());
-    DEBUG_PRINT("Building block 2\n");
-    block2_database.max_load_factor(0.7f);
-    Configuration block2_configuration{0, 0, 0,  4, //
-                                       0, 0, 7,  8, //
-                                       0, 0, 11, 12, //
-                                       0, 0, 0,  0};
-    build_block_database(block2_database, block2_configuration);
-    DEBUG_PRINT("Block database 2 size %llu\n", (i64)block2_database.size());
-    DEBUG_PRINT("Building block 3\n");
-    block3_database.max_load_factor(0.7f);
-    Configuration block3_configuration{0,  0,  0,  0, //
-                                       0,  0,  0,  0, //
-                                       9,  10, 0,  0, //
-                                       13, 14, 15, 0};
-    build_block_database(block3_database, block3_configuration);
-    DEBUG_PRINT("Block database 3 size %llu\n", (i64)block3_database.size());
+  i32 heuristic_manhattan_distance_delta(u128 const board, i32 const tile,
+                                         i32 const empty) {
+    return manhattan_distance_delta<Puzzle>(board, tile, empty);
   }
 
-  i32 heuristic_pattern_database(Configuration_View const start) {
-    Configuration block1 = {};
-    Configuration block2 = {};
-    Configuration block3 = {};
-    for(i32 index = 0; Configuration_Entry const v: start) {
-      switch(v) {
-        case 1:
-        case 2:
-        case 3:
-        case 5:
-        case 6:
-          block1[index] = v;
-          break;
-        case 4:
-        case 7:
-        case 8:
-        case 11:
-        case 12:
-          block2[index] = v;
-          break;
-        case 9:
-        case 10:
-        case 13:
-        case 14:
-        case 15:
-          block3[index] = v;
-          break;
-        default:
-          break;
-      }
-      index += 1;
-    }
-    u64 const hash1 = hash_configuration(block1);
-    u64 const hash2 = hash_configuration(block2);
-    u64 const hash3 = hash_configuration(block3);
-    return block1_database[hash1] + block2_database[hash2] +
-           block3_database[hash3];
+  i32 heuristic_linear_conflict(u128 const board) {
+    return linear_conflict<Puzzle>(board, standard_goal_positions<Puzzle>);
   }
 
-  i32 heuristic_pattern_database_generic(Configuration_View const start,
-                                         Configuration_View const goal) {
-    Configuration const c = remap_to_standard(start, goal);
-    return heuristic_pattern_database(c);
+  i32 heuristic_linear_conflict_delta(u128 const board, i32 const tile,
+                                      i32 const empty) {
+    return linear_conflict_delta<Puzzle>(board, tile, empty);
   }
-} // namespace puzzle15
+} // namespace puzzle24
@@ -1,36 +1,99 @@
 #pragma once
 
+#include <array>
+
+#include <sliding_puzzle.hpp>
 #include <types.hpp>
 
-using heuristic_t = i32 (*)(Configuration_View configuration);
-using generic_heuristic_t = i32 (*)(Configuration_View start,
-                                    Configuration_View goal);
+namespace puzzle15 {
+  // Goal_Remap
+  // Goal configuration other than the standard one prepared for the generic
+  // heuristics. A search towards a fixed goal builds it once instead of
+  // deriving the goal squares of the tiles on every evaluation.
+  //
+  struct Goal_Remap {
+    u64 goal = 0;
+    // Goal square of every tile.
+    std::array<i8, 16> squares = {};
+    // Manhattan distance of every tile from every square to its goal square.
+    // The row of the empty square (0) is all 0s.
+    std::array<std::array<i8, 16>, 16> manhattan = {};
+  };
+
+  [[nodiscard]] Goal_Remap make_goal_remap(u64 goal);
+} // namespace puzzle15
+
+// Heuristics operate on packed boards (see puzzle15::State).
+using heuristic_t = puzzle15::Puzzle::heuristic_t;
+using generic_heuristic_t = i32 (*)(u64 board,
+                                    puzzle15::Goal_Remap const& goal);
+// heuristic_delta_t
+// Incremental heuristic evaluation. Calculates the change of the heuristic
+// value caused by sliding the tile at index tile into the adjacent empty square
+// at index empty of board. Undoing the move changes the value by the negation
+// of the delta, hence a search only needs to remember the parent's value.
+using heuristic_delta_t = puzzle15::Puzzle::heuristic_delta_t;
+
+namespace puzzle8 {
+  // Heuristics of the 3x3 puzzle to the standard goal configuration. See the
+  // puzzle15 versions.
+  [[nodiscard]] i32 heuristic_manhattan_distance(u64 board);
+  [[nodiscard]] i32 heuristic_manhattan_distance_delta(u64 board, i32 tile,
+                                                       i32 empty);
+  [[nodiscard]] i32 heuristic_linear_conflict(u64 board);
+  [[nodiscard]] i32 heuristic_linear_conflict_delta(u64 board, i32 tile,
+                                                    i32 empty);
+} // namespace puzzle8
 
 namespace puzzle15 {
   // heuristic_manhattan_distance
   // Optimised version of the Manhattan Distance (MD) for calculating the MD
   // to the standard goal configuration.
   //
-  [[nodiscard]] i32 heuristic_manhattan_distance(Configuration_View start);
+  [[nodiscard]] i32 heuristic_manhattan_distance(u64 board);
 
   // heuristic_manhattan_distance_generic
   // Generic version of the Manhattan Distance (MD) for calculating the MD
-  // to any goal start.
+  // to any goal configuration.
   //
   [[nodiscard]] i32
-  heuristic_manhattan_distance_generic(Configuration_View start,
-                                       Configuration_View goal);
+  heuristic_manhattan_distance_generic(u64 board, Goal_Remap const& goal);
 
-  [[nodiscard]] i32 heuristic_linear_conflict(Configuration_View start);
+  // heuristic_manhattan_distance_delta
+  // Incremental version of heuristic_manhattan_distance. A move changes the
+  // MD by exactly 1.
+  //
+  [[nodiscard]] i32 heuristic_manhattan_distance_delta(u64 board, i32 tile,
+                                                       i32 empty);
 
-  [[nodiscard]] i32 heuristic_linear_conflict_generic(Configuration_View start,
-                                                      Configuration_View goal);
+  // heuristic_linear_conflict
+  // Manhattan Distance increased by 2 moves for every tile that has to leave
+  // its goal row or column to let other tiles in that line pass.
+  //
+  [[nodiscard]] i32 heuristic_linear_conflict(u64 board);
 
-  [[nodiscard]] i32 heuristic_inversions(Configuration_View start);
+  [[nodiscard]] i32 heuristic_linear_conflict_generic(u64 board,
+                                                      Goal_Remap const& goal);
 
-  void build_pattern_database();
+  // heuristic_linear_conflict_delta
+  // Incremental version of heuristic_linear_conflict. A move changes the
+  // conflicts only in the 2 lines perpendicular to the move which the tile
+  // leaves and enters, the order of tiles in the line along the move remains
+  // unchanged.
+  //
+  [[nodiscard]] i32 heuristic_linear_conflict_delta(u64 board, i32 tile,
+                                                    i32 empty);
+
+  [[nodiscard]] i32 heuristic_inversions(Configuration_View start);
+} // namespace puzzle15
 
-  [[nodiscard]] i32 heuristic_pattern_database(Configuration_View start);
-  [[nodiscard]] i32 heuristic_pattern_database_generic(Configuration_View start,
-                                                       Configuration_View goal);
-} // namespace puzzle15
\ No newline at end of file
+namespace puzzle24 {
+  // Heuristics of the 5x5 puzzle to the standard goal configuration. See the
+  // puzzle15 versions.
+  [[nodiscard]] i32 heuristic_manhattan_distance(u128 board);
+  [[nodiscard]] i32 heuristic_manhattan_distance_delta(u128 board, i32 tile,
+                                                       i32 empty);
+  [[nodiscard]] i32 heuristic_linear_conflict(u128 board);
+  [[nodiscard]] i32 heuristic_linear_conflict_delta(u128 board, i32 tile,
+                                                    i32 empty);
+} // namespace puzzle24
@@ -1,35 +1,22 @@
+#include <atomic>
+#include <charconv>
 #include <chrono>
 #include <optional>
 #include <stdio.h>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include <debug.hpp>
 #include <heuristic.hpp>
+#include <pattern_database.hpp>
 #include <solver.hpp>
+#include <thread_pool.hpp>
+#include <timer.hpp>
+#include <trace.hpp>
 
-struct Timer {
-  private:
-  std::chrono::high_resolution_clock::time_point start_time;
-
-  public:
-  void start() {
-    start_time = std::chrono::high_resolution_clock::now();
-  }
-
-  [[nodiscard]] i64 end_ns() {
-    auto const end_time = std::chrono::high_resolution_clock::now();
-    return std::chrono::duration_cast<std::chrono::nanoseconds>(end_time -
-                                                                start_time)
-      .count();
-  }
-
-  [[nodiscard]] i64 end_ms() {
-    auto const end_time = std::chrono::high_resolution_clock::now();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
-                                                                 start_time)
-      .count();
-  }
-};
+// Memory budget of SMA*, 256 MiB.
+constexpr i64 default_memory_budget = (i64)256 << 20;
 
 static void help(char const* const name) {
   printf("Usage: %s [OPTION]... CONFIGURATION\n", name);
@@ -38,13 +25,73 @@ static void help(char const* const name) {
     "CURRENTLY CONFIGURATION IS A HARDCODED 48 MOVES CONFIGURATION AND IS NOT "
     "READ FROM THE STDIN\n");
   printf("\n");
+  printf("       %s [OPTION]... --batch FILE\n", name);
+  printf("\n");
+  printf(
+    "In the batch mode every line of FILE (- for the standard input) holds a "
+    "configuration of WIDTH x HEIGHT numbers with the empty square denoted "
+    "by 0 or WIDTH x HEIGHT. "
+    "Empty lines and lines starting with # are skipped. The results are "
+    "written to the standard output as CSV and the throughput to the "
+    "standard error.\n");
+  printf("\n");
   printf(" -h, --help       display the help page\n");
   printf(
     " -a, --algorithm  select the algorithm to use. Available options "
-    "are: A*, IDA*, BA*\n");
+    "are: A*, IDA*, BA*, SMA*, PIDA* (perimeter search)\n");
+  printf(
+    " -n, --size       select the size of the board. Available options are: "
+    "3x3, 4x4, 5x5. Defaults to 4x4. Other sizes than 4x4 are only solved "
+    "in the batch mode with IDA* and the MD or LC heuristics\n");
   printf(
     " -e, --heuristic  select the heuristic to use. Available options "
     "are: MD, LC, PDB\n");
+  printf(
+    " -p, --partition  select the tile partition of the pattern database. "
+    "Available options are: 5-5-5, 6-6-3, 7-8\n");
+  printf(
+    "     --pdb-cache  path to the pattern database cache file. Defaults to "
+    "pdb-PARTITION.bin in the working directory\n");
+  printf(
+    " -s, --stats      print closed set probe lengths, node arena "
+    "footprint and pattern database source\n");
+  printf(
+    "     --open-list  select the open list of A* and BA*. Available options "
+    "are: heap, buckets. Defaults to buckets\n");
+  printf(
+    " -b, --batch      solve the configurations read from a file\n");
+  printf(
+    " -t, --threads    number of threads used by IDA*. In the batch mode the "
+    "number of instances solved concurrently. Defaults to 1\n");
+  printf(
+    " -d, --split-depth\n"
+    "                  depth at which parallel IDA* splits the search tree "
+    "into tasks. Defaults to %d\n",
+    IDAstar_default_split_depth);
+  printf(
+    "     --perimeter-depth\n"
+    "                  number of moves from the goal covered by the perimeter "
+    "of PIDA*. At most %d. Defaults to %d\n",
+    perimeter_max_depth, perimeter_default_depth);
+  printf(
+    " -m, --memory     memory budget of SMA* in bytes. Accepts K, M and G "
+    "suffixes. Defaults to %lldM\n",
+    default_memory_budget >> 20);
+  printf(
+    "     --tt-memory  size of the transposition table of IDA* in bytes. "
+    "Accepts K, M and G suffixes. Not supported by 5x5. Defaults to no "
+    "table\n");
+  printf(
+    "     --trace      write the counters, histograms and samples collected "
+    "by A*, IDA* and BA* during the search to a file\n");
+  printf(
+    "     --trace-format\n"
+    "                  select the format of the trace. Available options are: "
+    "json, chrome (Trace Event Format). Defaults to json\n");
+  printf(
+    "     --speedup    run IDA* with 1, 2, 4, ... threads up to the number "
+    "given by --threads (or the number of hardware threads) and report the "
+    "speedup over the serial search\n");
 }
 
 enum struct Heuristic_Kind {
@@ -53,10 +100,18 @@ enum struct Heuristic_Kind {
   pattern_database,
 };
 
+enum struct Board_Size {
+  three_by_three,
+  four_by_four,
+  five_by_five,
+};
+
 enum struct Algorithm_Kind {
   Astar,
   IDAstar,
   BAstar,
+  SMAstar,
+  perimeter_IDAstar,
 };
 
 static void error_algorithm_heuristic_combination(
@@ -66,11 +121,77 @@ static void error_algorithm_heuristic_combination(
 }
 
 struct Options {
+  Board_Size size = Board_Size::four_by_four;
   Algorithm_Kind algorithm = Algorithm_Kind::Astar;
   Heuristic_Kind heuristic = Heuristic_Kind::linear_conflict;
+  Open_List_Kind open_list = Open_List_Kind::buckets;
+  puzzle15::Pattern_Partition partition =
+    puzzle15::Pattern_Partition::five_five_five;
+  char const* pdb_cache = nullptr;
+  char const* batch = nullptr;
+  char const* trace = nullptr;
+  Trace_Format trace_format = Trace_Format::json;
+  i32 threads = 1;
+  i32 split_depth = 0;
+  i32 perimeter_depth = 0;
+  i64 memory_budget = default_memory_budget;
+  // 0 disables the transposition table.
+  i64 transposition_table_bytes = 0;
   bool help = false;
+  bool stats = false;
+  bool speedup = false;
 };
 
+// parse_positive
+// Parse a positive decimal integer.
+//
+// Returns:
+// The parsed value or std::nullopt if string is not a positive integer.
+//
+static std::optional<i32> parse_positive(std::string_view const string) {
+  i32 value = 0;
+  auto const [end, error] =
+    std::from_chars(string.data(), string.data() + string.size(), value);
+  if(error != std::errc() || end != string.data() + string.size() ||
+     value <= 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+// parse_size
+// Parse a positive decimal number of bytes optionally followed by a K, M or G
+// binary suffix.
+//
+// Returns:
+// The number of bytes or std::nullopt if string is not a valid size.
+//
+static std::optional<i64> parse_size(std::string_view const string) {
+  i64 value = 0;
+  auto const [end, error] =
+    std::from_chars(string.data(), string.data() + string.size(), value);
+  if(error != std::errc() || value <= 0) {
+    return std::nullopt;
+  }
+
+  std::string_view const suffix(end, string.data() + string.size());
+  i32 shift = 0;
+  if(suffix == "K") {
+    shift = 10;
+  } else if(suffix == "M") {
+    shift = 20;
+  } else if(suffix == "G") {
+    shift = 30;
+  } else if(suffix.size() > 0) {
+    return std::nullopt;
+  }
+
+  if(value > (i64_largest_value >> shift)) {
+    return std::nullopt;
+  }
+  return value << shift;
+}
+
 std::optional<Options> parse_options(i32 const argc,
                                      char const* const* const argv) {
   Options options;
@@ -94,6 +215,29 @@ std::optional<Options> parse_options(i32 const argc,
         options.algorithm = Algorithm_Kind::IDAstar;
       } else if(arg == "BA*") {
         options.algorithm = Algorithm_Kind::BAstar;
+      } else if(arg == "SMA*") {
+        options.algorithm = Algorithm_Kind::SMAstar;
+      } else if(arg == "PIDA*") {
+        options.algorithm = Algorithm_Kind::perimeter_IDAstar;
+      } else {
+        printf("error: unrecognised argument to %s: %s\n", argv[i],
+               argv[i + 1]);
+      }
+
+      i += 2;
+    } else if(option == "-n" || option == "--size") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::string_view arg(argv[i + 1]);
+      if(arg == "3x3") {
+        options.size = Board_Size::three_by_three;
+      } else if(arg == "4x4") {
+        options.size = Board_Size::four_by_four;
+      } else if(arg == "5x5") {
+        options.size = Board_Size::five_by_five;
       } else {
         printf("error: unrecognised argument to %s: %s\n", argv[i],
                argv[i + 1]);
@@ -119,6 +263,137 @@ std::optional<Options> parse_options(i32 const argc,
       }
 
       i += 2;
+    } else if(option == "-p" || option == "--partition") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::string_view arg(argv[i + 1]);
+      if(arg == "5-5-5") {
+        options.partition = puzzle15::Pattern_Partition::five_five_five;
+      } else if(arg == "6-6-3") {
+        options.partition = puzzle15::Pattern_Partition::six_six_three;
+      } else if(arg == "7-8") {
+        options.partition = puzzle15::Pattern_Partition::seven_eight;
+      } else {
+        printf("error: unrecognised argument to %s: %s\n", argv[i],
+               argv[i + 1]);
+      }
+
+      i += 2;
+    } else if(option == "--pdb-cache") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      options.pdb_cache = argv[i + 1];
+      i += 2;
+    } else if(option == "--trace") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      options.trace = argv[i + 1];
+      i += 2;
+    } else if(option == "--trace-format") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::string_view arg(argv[i + 1]);
+      if(arg == "json") {
+        options.trace_format = Trace_Format::json;
+      } else if(arg == "chrome") {
+        options.trace_format = Trace_Format::chrome;
+      } else {
+        printf("error: unrecognised argument to %s: %s\n", argv[i],
+               argv[i + 1]);
+      }
+
+      i += 2;
+    } else if(option == "--open-list") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::string_view arg(argv[i + 1]);
+      if(arg == "heap") {
+        options.open_list = Open_List_Kind::heap;
+      } else if(arg == "buckets") {
+        options.open_list = Open_List_Kind::buckets;
+      } else {
+        printf("error: unrecognised argument to %s: %s\n", argv[i],
+               argv[i + 1]);
+      }
+
+      i += 2;
+    } else if(option == "-b" || option == "--batch") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      options.batch = argv[i + 1];
+      i += 2;
+    } else if(option == "-s" || option == "--stats") {
+      options.stats = true;
+      i += 1;
+    } else if(option == "-t" || option == "--threads" || option == "-d" ||
+              option == "--split-depth" || option == "--perimeter-depth") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::optional<i32> const value = parse_positive(argv[i + 1]);
+      if(!value) {
+        printf("error: argument to %s must be a positive integer: %s\n",
+               argv[i], argv[i + 1]);
+        return std::nullopt;
+      }
+
+      if(option == "-t" || option == "--threads") {
+        options.threads = value.value();
+      } else if(option == "--perimeter-depth") {
+        if(value.value() > perimeter_max_depth) {
+          printf("error: argument to %s must be at most %d: %s\n", argv[i],
+                 perimeter_max_depth, argv[i + 1]);
+          return std::nullopt;
+        }
+
+        options.perimeter_depth = value.value();
+      } else {
+        options.split_depth = value.value();
+      }
+      i += 2;
+    } else if(option == "-m" || option == "--memory" ||
+              option == "--tt-memory") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::optional<i64> const value = parse_size(argv[i + 1]);
+      if(!value) {
+        printf("error: argument to %s must be a positive size: %s\n",
+               argv[i], argv[i + 1]);
+        return std::nullopt;
+      }
+
+      if(option == "--tt-memory") {
+        options.transposition_table_bytes = value.value();
+      } else {
+        options.memory_budget = value.value();
+      }
+      i += 2;
+    } else if(option == "--speedup") {
+      options.speedup = true;
+      i += 1;
     } else {
       // Not an option. End parsing.
       if(!option.starts_with("-")) {
@@ -133,6 +408,94 @@ std::optional<Options> parse_options(i32 const argc,
   return options;
 }
 
+static void print_statistics(Hash_Table_Statistics const& closed_set,
+                             Arena_Statistics const& arena) {
+  if(closed_set.capacity == 0) {
+    printf("no closed set maintained by the algorithm\n");
+    return;
+  }
+
+  printf("closed set: %lld entries, %lld slots (%.2f load), %lld bytes\n",
+         closed_set.size, closed_set.capacity,
+         closed_set.capacity > 0 ? (double)closed_set.size / closed_set.capacity
+                                 : 0.0,
+         closed_set.bytes);
+  printf("closed set probes: %lld lookups, %.3f average length, %lld max\n",
+         closed_set.lookups,
+         closed_set.lookups > 0 ? (double)closed_set.probes / closed_set.lookups
+                                : 0.0,
+         closed_set.max_probe_length);
+  i64 const last_bucket = closed_set.probe_histogram.size() - 1;
+  for(i64 length = 1; length <= last_bucket; length += 1) {
+    i64 const count = closed_set.probe_histogram[length];
+    if(count == 0) {
+      continue;
+    }
+
+    printf("  %s%2lld: %lld\n", length == last_bucket ? ">=" : "  ", length,
+           count);
+  }
+  printf("node arena: %lld nodes, %lld chunks, %lld bytes\n", arena.objects,
+         arena.chunks, arena.bytes);
+}
+
+static void print_transposition_statistics(
+  Transposition_Table_Statistics const& table) {
+  printf("transposition table: %lld slots, %lld bytes\n", table.capacity,
+         table.bytes);
+  printf("transposition table probes: %lld hits (%.2f), %lld misses, "
+         "%lld cutoffs, %lld stores\n",
+         table.hits,
+         table.probes > 0 ? (double)table.hits / table.probes : 0.0,
+         table.probes - table.hits, table.cutoffs, table.stores);
+}
+
+// report_speedup
+// Solve the configuration with IDA* using 1, 2, 4, ... threads, up to
+// max_threads, and print the time of each run relative to the serial search.
+//
+static void report_speedup(IDAstar_Parameters parameters,
+                           i32 const max_threads) {
+  printf("%8s %10s %12s %8s %10s\n", "threads", "time [ms]", "explored",
+         "speedup", "efficiency");
+  i64 serial_time = 0;
+  for(i32 threads = 1;; threads *= 2) {
+    if(threads > max_threads) {
+      threads = max_threads;
+    }
+
+    parameters.threads = threads;
+    Timer timer;
+    timer.start();
+    puzzle15::Solution const solution = puzzle15::IDAstar_solver(parameters);
+    i64 const time = timer.end_ns();
+    if(threads == 1) {
+      serial_time = time;
+    }
+
+    double const speedup = time > 0 ? (double)serial_time / time : 0.0;
+    printf("%8d %10.1f %12lld %8.2f %10.2f%s\n", threads, time / 1000000.0,
+           solution.explored, speedup, speedup / threads,
+           solution.found ? "" : " (not found)");
+    if(threads == max_threads) {
+      break;
+    }
+  }
+}
+
+static char const*
+select_default_cache_path(puzzle15::Pattern_Partition const partition) {
+  switch(partition) {
+    case puzzle15::Pattern_Partition::five_five_five:
+      return "pdb-5-5-5.bin";
+    case puzzle15::Pattern_Partition::six_six_three:
+      return "pdb-6-6-3.bin";
+    case puzzle15::Pattern_Partition::seven_eight:
+      return "pdb-7-8.bin";
+  }
+  __builtin_unreachable();
+}
+
 namespace puzzle15 {
   static heuristic_t select_forward_heuristic(Heuristic_Kind const kind) {
     switch(kind) {
@@ -146,6 +509,18 @@ namespace puzzle15 {
     __builtin_unreachable();
   }
 
+  static heuristic_delta_t select_heuristic_delta(Heuristic_Kind const kind) {
+    switch(kind) {
+      case Heuristic_Kind::manhattan_distance:
+        return heuristic_manhattan_distance_delta;
+      case Heuristic_Kind::linear_conflict:
+        return heuristic_linear_conflict_delta;
+      case Heuristic_Kind::pattern_database:
+        return nullptr;
+    }
+    __builtin_unreachable();
+  }
+
   static generic_heuristic_t
   select_backward_heuristic(Heuristic_Kind const kind) {
     switch(kind) {
@@ -160,6 +535,275 @@ namespace puzzle15 {
   }
 } // namespace puzzle15
 
+struct Solver_Heuristics {
+  heuristic_t forward;
+  heuristic_delta_t delta;
+  generic_heuristic_t backward;
+};
+
+// solve
+// Solve configuration with the algorithm selected by options.
+//
+// Parameters:
+// threads - number of threads used by IDA*.
+// counters - optional live memory counters of SMA*.
+// trace - optional. Fed by A*, IDA* and BA*.
+//
+static puzzle15::Solution solve(Options const& options,
+                                Solver_Heuristics const& heuristics,
+                                Configuration_View const configuration,
+                                i32 const threads,
+                                Memory_Counters* const counters = nullptr,
+                                Search_Trace* const trace = nullptr) {
+  switch(options.algorithm) {
+    case Algorithm_Kind::Astar: {
+      Astar_Parameters astar_parameters = {
+        .starting_configuration = configuration,
+        .heuristic = heuristics.forward,
+        .heuristic_delta = heuristics.delta,
+        .open_list = options.open_list,
+        .trace = trace};
+      return puzzle15::Astar_solver(astar_parameters);
+    }
+
+    case Algorithm_Kind::IDAstar: {
+      IDAstar_Parameters idastar_parameters = {
+        .starting_configuration = configuration,
+        .heuristic = heuristics.forward,
+        .heuristic_delta = heuristics.delta,
+        .threads = threads,
+        .split_depth = options.split_depth,
+        .transposition_table_bytes = options.transposition_table_bytes,
+        .trace = trace};
+      return puzzle15::IDAstar_solver(idastar_parameters);
+    }
+
+    case Algorithm_Kind::BAstar: {
+      Bidirectional_Astar_Parameters bastar_parameters = {
+        .starting_configuration = configuration,
+        .forward_heuristic = heuristics.forward,
+        .backward_heuristic = heuristics.backward,
+        .open_list = options.open_list,
+        .trace = trace};
+      return puzzle15::Bidirectional_Astar_solver(bastar_parameters);
+    }
+
+    case Algorithm_Kind::SMAstar: {
+      SMAstar_Parameters smastar_parameters = {
+        .starting_configuration = configuration,
+        .heuristic = heuristics.forward,
+        .heuristic_delta = heuristics.delta,
+        .memory_budget = options.memory_budget,
+        .counters = counters};
+      return puzzle15::SMAstar_solver(smastar_parameters);
+    }
+
+    case Algorithm_Kind::perimeter_IDAstar: {
+      Perimeter_IDAstar_Parameters perimeter_parameters = {
+        .starting_configuration = configuration,
+        .heuristic = heuristics.forward,
+        .heuristic_delta = heuristics.delta,
+        .perimeter_heuristic = heuristics.backward,
+        .perimeter_depth = options.perimeter_depth};
+      return puzzle15::Perimeter_IDAstar_solver(perimeter_parameters);
+    }
+  }
+  __builtin_unreachable();
+}
+
+enum struct Batch_Status {
+  pending,
+  solved,
+  not_found,
+  unsolvable,
+  invalid,
+};
+
+static char const* batch_status_string(Batch_Status const status) {
+  switch(status) {
+    case Batch_Status::pending:
+      return "pending";
+    case Batch_Status::solved:
+      return "solved";
+    case Batch_Status::not_found:
+      return "not_found";
+    case Batch_Status::unsolvable:
+      return "unsolvable";
+    case Batch_Status::invalid:
+      return "invalid";
+  }
+  __builtin_unreachable();
+}
+
+template<typename Puzzle>
+struct Batch_Instance {
+  typename Puzzle::Configuration configuration;
+  // Line of the input the configuration has been read from.
+  i64 line = 0;
+  // Number of moves of the solution.
+  i64 length = 0;
+  i64 explored = 0;
+  i64 time_ns = 0;
+  Batch_Status status = Batch_Status::pending;
+};
+
+// run_batch
+// Solve the configurations read from input, block by block, on options.threads
+// workers and write a CSV row per configuration in the input order.
+//
+// Parameters:
+// solve - invoked as solve(configuration) and returns the Solution of the
+//         configuration. Invoked concurrently by the workers.
+//
+// Returns:
+// Whether the input could be read.
+//
+template<typename Puzzle, typename Solve>
+static bool run_batch(Options const& options, Solve&& solve) {
+  // Number of instances read ahead and distributed over the workers at once.
+  constexpr i64 block_size = 1024;
+
+  bool const read_stdin = std::string_view(options.batch) == "-";
+  FILE* const input = read_stdin ? stdin : fopen(options.batch, "r");
+  if(input == nullptr) {
+    printf("error: could not open %s\n", options.batch);
+    return false;
+  }
+
+  Work_Stealing_Pool pool(options.threads);
+  std::vector<Batch_Instance<Puzzle>> instances;
+  instances.reserve(block_size);
+  i64 line = 0;
+  i64 total = 0;
+  i64 solved = 0;
+  Timer timer;
+  timer.start();
+  printf("line,status,length,explored,time_ms\n");
+  bool end_of_input = false;
+  while(!end_of_input) {
+    instances.clear();
+    char buffer[256];
+    while((i64)instances.size() < block_size) {
+      if(fgets(buffer, sizeof(buffer), input) == nullptr) {
+        end_of_input = true;
+        break;
+      }
+
+      line += 1;
+      std::string_view const string(buffer);
+      if(string.find_first_not_of(" \t\r\n") == std::string_view::npos ||
+         string[0] == '#') {
+        continue;
+      }
+
+      Batch_Instance<Puzzle> instance;
+      instance.line = line;
+      if(!Puzzle::parse_configuration(string, instance.configuration)) {
+        instance.status = Batch_Status::invalid;
+      } else if(!Puzzle::is_solvable(instance.configuration)) {
+        instance.status = Batch_Status::unsolvable;
+      }
+      instances.push_back(instance);
+    }
+
+    pool.run(instances.size(), [&](i32, i64 const task) {
+      Batch_Instance<Puzzle>& instance = instances[task];
+      if(instance.status != Batch_Status::pending) {
+        return;
+      }
+
+      Timer instance_timer;
+      instance_timer.start();
+      auto const solution = solve(instance.configuration);
+      instance.time_ns = instance_timer.end_ns();
+      instance.explored = solution.explored;
+      if(solution.found) {
+        instance.status = Batch_Status::solved;
+        instance.length = solution.path.size() - 1;
+      } else {
+        instance.status = Batch_Status::not_found;
+      }
+    });
+
+    for(Batch_Instance<Puzzle> const& instance: instances) {
+      printf("%lld,%s,%lld,%lld,%.3f\n", instance.line,
+             batch_status_string(instance.status), instance.length,
+             instance.explored, instance.time_ns / 1000000.0);
+      solved += instance.status == Batch_Status::solved;
+    }
+    total += instances.size();
+    fflush(stdout);
+  }
+
+  if(!read_stdin) {
+    fclose(input);
+  }
+
+  i64 const time = timer.end_ns();
+  fprintf(stderr,
+          "%lld instances (%lld solved) in %.3fs, %.2f instances/s on %d "
+          "threads\n",
+          total, solved, time / 1000000000.0,
+          time > 0 ? total * 1000000000.0 / time : 0.0, pool.size());
+  return true;
+}
+
+template<typename Puzzle>
+struct Sliding_Puzzle_Solver {
+  typename Puzzle::heuristic_t manhattan_distance;
+  typename Puzzle::heuristic_delta_t manhattan_distance_delta;
+  typename Puzzle::heuristic_t linear_conflict;
+  typename Puzzle::heuristic_delta_t linear_conflict_delta;
+  Solution<typename Puzzle::Configuration> (*IDAstar_solver)(
+    Sliding_IDAstar_Parameters<Puzzle>);
+};
+
+// run_sliding_batch
+// Batch mode for the boards other than 4x4. Only IDA* with the MD and LC
+// heuristics is available for those.
+//
+// Returns:
+// Whether the options are supported and the input could be read.
+//
+template<typename Puzzle>
+static bool run_sliding_batch(Options const& options,
+                              Sliding_Puzzle_Solver<Puzzle> const& solver) {
+  if(options.batch == nullptr) {
+    printf("error: boards other than 4x4 are only solved in the batch mode\n");
+    return false;
+  }
+
+  if(options.algorithm != Algorithm_Kind::IDAstar ||
+     options.heuristic == Heuristic_Kind::pattern_database) {
+    printf(
+      "error: boards other than 4x4 are only solved with IDA* and the MD or "
+      "LC heuristics\n");
+    return false;
+  }
+
+  if(options.transposition_table_bytes > 0 &&
+     sizeof(typename Puzzle::board_t) > sizeof(u64)) {
+    printf("error: --tt-memory is not supported by 5x5\n");
+    return false;
+  }
+
+  bool const manhattan_distance =
+    options.heuristic == Heuristic_Kind::manhattan_distance;
+  return run_batch<Puzzle>(
+    options, [&](Configuration_View const configuration) {
+      Sliding_IDAstar_Parameters<Puzzle> const parameters = {
+        .starting_configuration = configuration,
+        .heuristic = manhattan_distance ? solver.manhattan_distance
+                                        : solver.linear_conflict,
+        .heuristic_delta = manhattan_distance
+                             ? solver.manhattan_distance_delta
+                             : solver.linear_conflict_delta,
+        .split_depth = options.split_depth,
+        .transposition_table_bytes = options.transposition_table_bytes};
+      return solver.IDAstar_solver(parameters);
+    });
+}
+
 int main(int const argc, char** const argv) {
   constexpr i32 RETURN_SUCCESS = 0;
   constexpr i32 RETURN_ERROR = 1;
@@ -220,74 +864,195 @@ int main(int const argc, char** const argv) {
     return RETURN_HELP;
   }
 
-  if(!puzzle15::is_solvable(configuration)) {
-    printf("configuration not solvable");
-    return RETURN_SUCCESS;
+  switch(options.size) {
+    case Board_Size::three_by_three: {
+      Sliding_Puzzle_Solver<puzzle8::Puzzle> const solver = {
+        .manhattan_distance = puzzle8::heuristic_manhattan_distance,
+        .manhattan_distance_delta =
+          puzzle8::heuristic_manhattan_distance_delta,
+        .linear_conflict = puzzle8::heuristic_linear_conflict,
+        .linear_conflict_delta = puzzle8::heuristic_linear_conflict_delta,
+        .IDAstar_solver = puzzle8::IDAstar_solver};
+      return run_sliding_batch(options, solver) ? RETURN_SUCCESS
+                                                : RETURN_ERROR;
+    }
+
+    case Board_Size::five_by_five: {
+      Sliding_Puzzle_Solver<puzzle24::Puzzle> const solver = {
+        .manhattan_distance = puzzle24::heuristic_manhattan_distance,
+        .manhattan_distance_delta =
+          puzzle24::heuristic_manhattan_distance_delta,
+        .linear_conflict = puzzle24::heuristic_linear_conflict,
+        .linear_conflict_delta = puzzle24::heuristic_linear_conflict_delta,
+        .IDAstar_solver = puzzle24::IDAstar_solver};
+      return run_sliding_batch(options, solver) ? RETURN_SUCCESS
+                                                : RETURN_ERROR;
+    }
+
+    case Board_Size::four_by_four:
+      break;
   }
 
   if(options.heuristic == Heuristic_Kind::pattern_database) {
+    char const* cache_path = options.pdb_cache;
+    if(cache_path == nullptr) {
+      cache_path = select_default_cache_path(options.partition);
+    }
+
     Timer database_timer;
     database_timer.start();
-    puzzle15::build_pattern_database();
-    [[maybe_unused]] i64 const database_time = database_timer.end_ms();
-    DEBUG_PRINT("database built in %lldms\n", database_time);
+    i32 const threads = std::thread::hardware_concurrency();
+    puzzle15::Pattern_Database_Statistics const database =
+      puzzle15::build_pattern_database(
+        {.partition = options.partition,
+         .cache_path = cache_path,
+         .threads = threads > 0 ? threads : 1});
+    i64 const database_time = database_timer.end_ms();
+    DEBUG_PRINT("database ready in %lldms\n", database_time);
+    if(options.stats) {
+      printf("pattern database: %lld entries, %lld bytes, %s in %lldms\n",
+             database.entries, database.bytes,
+             database.loaded ? "mapped" : "built", database_time);
+    }
+    if(!database.loaded && !database.saved) {
+      printf("warning: could not write pattern database cache %s\n",
+             cache_path);
+    }
   }
 
-  heuristic_t const forward_heuristic =
-    puzzle15::select_forward_heuristic(options.heuristic);
-  generic_heuristic_t const backward_heuristic =
-    puzzle15::select_backward_heuristic(options.heuristic);
+  Solver_Heuristics const heuristics = {
+    .forward = puzzle15::select_forward_heuristic(options.heuristic),
+    .delta = puzzle15::select_heuristic_delta(options.heuristic),
+    .backward = puzzle15::select_backward_heuristic(options.heuristic)};
+  if(heuristics.forward == nullptr ||
+     ((options.algorithm == Algorithm_Kind::BAstar ||
+       options.algorithm == Algorithm_Kind::perimeter_IDAstar) &&
+      heuristics.backward == nullptr)) {
+    error_algorithm_heuristic_combination(options.algorithm,
+                                          options.heuristic);
+    return RETURN_ERROR;
+  }
 
-  Solution<puzzle15::Configuration> solution;
-  Timer timer;
-  timer.start();
-  switch(options.algorithm) {
-    case Algorithm_Kind::Astar: {
-      if(forward_heuristic == nullptr) {
-        error_algorithm_heuristic_combination(options.algorithm,
-                                              options.heuristic);
-        return RETURN_ERROR;
-      }
+  if(options.trace != nullptr) {
+    if(!trace_enabled) {
+      printf("error: tracing has been compiled out (ENABLE_TRACE=0)\n");
+      return RETURN_ERROR;
+    }
 
-      Astar_Parameters astar_parameters = {.starting_configuration =
-                                             configuration,
-                                           .heuristic = forward_heuristic};
-      solution = puzzle15::Astar_solver(astar_parameters);
-    } break;
+    if(options.batch != nullptr || options.speedup) {
+      printf("error: --trace is not supported in the batch mode and with "
+             "--speedup\n");
+      return RETURN_ERROR;
+    }
 
-    case Algorithm_Kind::IDAstar: {
-      if(forward_heuristic == nullptr) {
-        error_algorithm_heuristic_combination(options.algorithm,
-                                              options.heuristic);
-        return RETURN_ERROR;
-      }
-      IDAstar_Parameters idastar_parameters = {.starting_configuration =
-                                                 configuration,
-                                               .heuristic = forward_heuristic};
-      solution = puzzle15::IDAstar_solver(idastar_parameters);
-    } break;
+    if(options.algorithm != Algorithm_Kind::Astar &&
+       options.algorithm != Algorithm_Kind::IDAstar &&
+       options.algorithm != Algorithm_Kind::BAstar) {
+      printf("error: --trace is only supported by A*, IDA* and BA*\n");
+      return RETURN_ERROR;
+    }
+  }
 
-    case Algorithm_Kind::BAstar: {
-      if(forward_heuristic == nullptr || backward_heuristic == nullptr) {
-        error_algorithm_heuristic_combination(options.algorithm,
-                                              options.heuristic);
-        return RETURN_ERROR;
+  if(options.transposition_table_bytes > 0 &&
+     options.algorithm != Algorithm_Kind::IDAstar) {
+    printf("error: --tt-memory is only supported by IDA*\n");
+    return RETURN_ERROR;
+  }
+
+  if(options.batch != nullptr) {
+    bool const read = run_batch<puzzle15::Puzzle>(
+      options, [&](Configuration_View const configuration) {
+        return solve(options, heuristics, configuration, 1);
+      });
+    return read ? RETURN_SUCCESS : RETURN_ERROR;
+  }
+
+  if(!puzzle15::is_solvable(configuration)) {
+    printf("configuration not solvable");
+    return RETURN_SUCCESS;
+  }
+
+  if(options.speedup) {
+    if(options.algorithm != Algorithm_Kind::IDAstar) {
+      printf("error: --speedup is only supported by IDA*\n");
+      return RETURN_ERROR;
+    }
+
+    i32 max_threads = options.threads;
+    if(max_threads == 1) {
+      max_threads = std::thread::hardware_concurrency();
+      if(max_threads < 1) {
+        max_threads = 1;
       }
+    }
 
-      Bidirectional_Astar_Parameters bastar_parameters = {
-        .starting_configuration = configuration,
-        .forward_heuristic = forward_heuristic,
-        .backward_heuristic = backward_heuristic};
-      solution = puzzle15::Bidirectional_Astar_solver(bastar_parameters);
-    } break;
+    IDAstar_Parameters const idastar_parameters = {
+      .starting_configuration = configuration,
+      .heuristic = heuristics.forward,
+      .heuristic_delta = heuristics.delta,
+      .split_depth = options.split_depth,
+      .transposition_table_bytes = options.transposition_table_bytes};
+    report_speedup(idastar_parameters, max_threads);
+    return RETURN_SUCCESS;
   }
 
+  // Report the memory held by SMA* every second while it runs.
+  Memory_Counters counters;
+  std::atomic<bool> finished = false;
+  std::thread monitor;
+  if(options.stats && options.algorithm == Algorithm_Kind::SMAstar) {
+    monitor = std::thread([&counters, &finished] {
+      using namespace std::chrono_literals;
+      for(i32 tick = 1; !finished.load(std::memory_order_relaxed);
+          tick += 1) {
+        std::this_thread::sleep_for(100ms);
+        if(tick % 10 != 0) {
+          continue;
+        }
+
+        fprintf(stderr, "resident: %lld nodes, %lld bytes\n",
+                counters.resident_nodes.load(std::memory_order_relaxed),
+                counters.resident_bytes.load(std::memory_order_relaxed));
+      }
+    });
+  }
+
+  Search_Trace trace;
+  Timer timer;
+  timer.start();
+  puzzle15::Solution const solution =
+    solve(options, heuristics, configuration, options.threads, &counters,
+          options.trace != nullptr ? &trace : nullptr);
   i64 const search_time = timer.end_ms();
+  if(options.trace != nullptr &&
+     !write_trace(trace, options.trace_format, options.trace)) {
+    printf("warning: could not write trace %s\n", options.trace);
+  }
+  if(monitor.joinable()) {
+    finished.store(true, std::memory_order_relaxed);
+    monitor.join();
+  }
+  if(options.stats && options.algorithm == Algorithm_Kind::SMAstar) {
+    printf("memory: %lld peak resident nodes, %lld peak resident bytes, "
+           "%lld pruned\n",
+           solution.peak_resident_nodes, solution.peak_resident_bytes,
+           solution.pruned);
+  }
+  if(options.stats &&
+     options.algorithm == Algorithm_Kind::perimeter_IDAstar) {
+    printf("perimeter: %lld configurations\n", solution.perimeter);
+  }
+  if(options.stats && solution.transposition_table.capacity > 0) {
+    print_transposition_statistics(solution.transposition_table);
+  }
   if(!solution.found) {
     printf(
       "solution not found in %lldms (%lld "
       "iterations)\n",
       search_time, solution.iterations);
+    if(options.stats) {
+      print_statistics(solution.closed_set, solution.arena);
+    }
     return RETURN_SUCCESS;
   }
 
@@ -296,6 +1061,9 @@ int main(int const argc, char** const argv) {
     "iterations, %lld depth, %lld "
     "explored)\n",
     search_time, solution.iterations, solution.depth, solution.explored);
+  if(options.stats) {
+    print_statistics(solution.closed_set, solution.arena);
+  }
   for(i32 index = 0; Configuration_View const configuration: solution.path) {
     printf("%d)\n", index);
     puzzle15::print(configuration);
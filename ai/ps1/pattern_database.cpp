@@ -0,0 +1,436 @@
+#include <pattern_database.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <debug.hpp>
+#include <sliding_puzzle.hpp>
+#include <thread_pool.hpp>
+
+namespace puzzle15 {
+  // Pattern databases are indexed by a perfect ranking of the squares
+  // occupied by the pattern tiles. The squares p_0, ..., p_(k-1) of the k
+  // tiles are turned into the digits d_i = p_i - |{j < i : p_j < p_i}| of a
+  // mixed radix number with bases 16, 15, ..., 16 - k + 1, which enumerates
+  // the 16! / (16 - k)! placements densely. Every entry is a single byte.
+  //
+  // The cache file consists of a Pattern_Database_Header followed by the
+  // tables, each starting at a 64 byte aligned offset. The version must be
+  // bumped whenever the ranking or the layout changes.
+
+  static constexpr i32 max_pattern_tiles = 8;
+  static constexpr i32 max_patterns = 3;
+  static constexpr u8 unvisited = 0xFF;
+  static constexpr char pattern_database_magic[8] = {'P', '1', '5', 'P',
+                                                     'D', 'B', 0,   0};
+  static constexpr u32 pattern_database_version = 1;
+
+  struct Pattern {
+    // Tiles of the pattern in the order of ranking.
+    std::array<i8, max_pattern_tiles> tiles = {};
+    i32 tile_count = 0;
+  };
+
+  struct Partition_Definition {
+    std::array<Pattern, max_patterns> patterns;
+    i32 pattern_count = 0;
+  };
+
+  struct Pattern_Database_Header {
+    char magic[8];
+    u32 version;
+    u32 pattern_count;
+    // Tiles of every pattern, 0 terminated.
+    i8 tiles[max_patterns][max_pattern_tiles + 1];
+    u8 padding[5];
+    u64 offsets[max_patterns];
+    u64 sizes[max_patterns];
+  };
+
+  static_assert(sizeof(Pattern_Database_Header) % 8 == 0);
+
+  //     +----+----+----+----+
+  //     |  1 |  2 |  3 |  4 |
+  //     +----+----+----+----+
+  //     |  5 |  6 |  7 |  8 |
+  //     +----+----+----+----+
+  //     |  9 | 10 | 11 | 12 |
+  //     +----+----+----+----+
+  //     | 13 | 14 | 15 |    |
+  //     +----+----+----+----+
+  //
+  // 5-5-5: {1, 2, 3, 5, 6}, {4, 7, 8, 11, 12}, {9, 10, 13, 14, 15}
+  // 6-6-3: {1, 2, 3, 5, 6, 7}, {9, 10, 11, 13, 14, 15}, {4, 8, 12}
+  //   7-8: {1, 2, 3, 4, 5, 6, 7, 8}, {9, 10, 11, 12, 13, 14, 15}
+  //
+  [[nodiscard]] static Partition_Definition
+  get_partition_definition(Pattern_Partition const partition) {
+    switch(partition) {
+      case Pattern_Partition::five_five_five:
+        return Partition_Definition{
+          .patterns = {Pattern{{1, 2, 3, 5, 6}, 5},
+                       Pattern{{4, 7, 8, 11, 12}, 5},
+                       Pattern{{9, 10, 13, 14, 15}, 5}},
+          .pattern_count = 3};
+      case Pattern_Partition::six_six_three:
+        return Partition_Definition{
+          .patterns = {Pattern{{1, 2, 3, 5, 6, 7}, 6},
+                       Pattern{{9, 10, 11, 13, 14, 15}, 6},
+                       Pattern{{4, 8, 12}, 3}},
+          .pattern_count = 3};
+      case Pattern_Partition::seven_eight:
+        return Partition_Definition{
+          .patterns = {Pattern{{1, 2, 3, 4, 5, 6, 7, 8}, 8},
+                       Pattern{{9, 10, 11, 12, 13, 14, 15}, 7}},
+          .pattern_count = 2};
+    }
+    __builtin_unreachable();
+  }
+
+  [[nodiscard]] static i64 get_table_size(Pattern const& pattern) {
+    i64 size = 1;
+    for(i32 i = 0; i < pattern.tile_count; i += 1) {
+      size *= 16 - i;
+    }
+    return size;
+  }
+
+  // rank_squares
+  //
+  // Parameters:
+  // squares - squares of the pattern tiles, 4 bits per tile with the first
+  //           tile in the least significant nibble.
+  //
+  [[nodiscard]] static u32 rank_squares(u32 const squares,
+                                        i32 const tile_count) {
+    u32 used = 0;
+    u32 rank = 0;
+    for(i32 i = 0; i < tile_count; i += 1) {
+      u32 const square = (squares >> (i * 4)) & 0x0F;
+      u32 const smaller = used & ((1u << square) - 1);
+      u32 const digit = square - __builtin_popcount(smaller);
+      rank = rank * (16 - i) + digit;
+      used |= 1u << square;
+    }
+    return rank;
+  }
+
+  // Currently active database. Tables point either into the owned storage or
+  // into the mapped cache file.
+  static Partition_Definition active_partition;
+  static u8 const* active_tables[max_patterns] = {};
+  static std::vector<u8> owned_tables[max_patterns];
+  static void* mapped_file = nullptr;
+  static i64 mapped_file_size = 0;
+
+  static void release_database() {
+    for(i32 i = 0; i < max_patterns; i += 1) {
+      active_tables[i] = nullptr;
+      owned_tables[i] = {};
+    }
+    if(mapped_file != nullptr) {
+      munmap(mapped_file, mapped_file_size);
+      mapped_file = nullptr;
+      mapped_file_size = 0;
+    }
+  }
+
+  // build_table
+  // Level synchronous breadth first search from the goal placement of the
+  // pattern tiles. Frontiers are split into chunks distributed over the
+  // workers of pool. Entries are claimed with a compare-and-swap, thus every
+  // placement enters the next frontier exactly once.
+  //
+  static void build_table(std::vector<u8>& table, Pattern const& pattern,
+                          Work_Stealing_Pool& pool) {
+    constexpr i64 chunk_size = 4096;
+
+    i32 const tile_count = pattern.tile_count;
+    table.assign(get_table_size(pattern), unvisited);
+    std::vector<u32> frontier;
+    {
+      u32 squares = 0;
+      for(i32 i = 0; i < tile_count; i += 1) {
+        squares |= (u32)(pattern.tiles[i] - 1) << (i * 4);
+      }
+      table[rank_squares(squares, tile_count)] = 0;
+      frontier.push_back(squares);
+    }
+
+    std::vector<std::vector<u32>> next_frontiers(pool.size());
+    for(u8 depth = 0; frontier.size() > 0; depth += 1) {
+      DEBUG_PRINT("pattern database depth %d, frontier %lld\n", depth,
+                  (i64)frontier.size());
+      i64 const chunks = (frontier.size() + chunk_size - 1) / chunk_size;
+      pool.run(chunks, [&](i32 const worker, i64 const chunk) {
+        std::vector<u32>& next = next_frontiers[worker];
+        i64 const begin = chunk * chunk_size;
+        i64 const end = std::min<i64>(begin + chunk_size, frontier.size());
+        for(i64 f = begin; f < end; f += 1) {
+          u32 const squares = frontier[f];
+          u32 occupied = 0;
+          for(i32 i = 0; i < tile_count; i += 1) {
+            occupied |= 1u << ((squares >> (i * 4)) & 0x0F);
+          }
+
+          for(i32 i = 0; i < tile_count; i += 1) {
+            i32 const square = (squares >> (i * 4)) & 0x0F;
+            i32 targets[4];
+            i32 target_count = 0;
+            if(square >= 4) {
+              targets[target_count] = square - 4;
+              target_count += 1;
+            }
+            if(square < 12) {
+              targets[target_count] = square + 4;
+              target_count += 1;
+            }
+            if((square & 3) > 0) {
+              targets[target_count] = square - 1;
+              target_count += 1;
+            }
+            if((square & 3) < 3) {
+              targets[target_count] = square + 1;
+              target_count += 1;
+            }
+
+            for(i32 t = 0; t < target_count; t += 1) {
+              i32 const target = targets[t];
+              if(occupied & (1u << target)) {
+                continue;
+              }
+
+              u32 const next_squares =
+                (squares & ~(0x0Fu << (i * 4))) | ((u32)target << (i * 4));
+              std::atomic_ref<u8> entry(
+                table[rank_squares(next_squares, tile_count)]);
+              u8 expected = unvisited;
+              if(entry.load(std::memory_order_relaxed) == unvisited &&
+                 entry.compare_exchange_strong(expected, (u8)(depth + 1),
+                                               std::memory_order_relaxed)) {
+                next.push_back(next_squares);
+              }
+            }
+          }
+        }
+      });
+
+      frontier.clear();
+      for(std::vector<u32>& next: next_frontiers) {
+        frontier.insert(frontier.end(), next.begin(), next.end());
+        next.clear();
+      }
+    }
+  }
+
+  [[nodiscard]] static bool
+  header_matches(Pattern_Database_Header const& header,
+                 Partition_Definition const& partition) {
+    if(memcmp(header.magic, pattern_database_magic, sizeof(header.magic)) !=
+         0 ||
+       header.version != pattern_database_version ||
+       header.pattern_count != (u32)partition.pattern_count) {
+      return false;
+    }
+
+    for(i32 p = 0; p < partition.pattern_count; p += 1) {
+      Pattern const& pattern = partition.patterns[p];
+      for(i32 i = 0; i <= max_pattern_tiles; i += 1) {
+        i8 const tile = i < pattern.tile_count ? pattern.tiles[i] : 0;
+        if(header.tiles[p][i] != tile) {
+          return false;
+        }
+      }
+
+      if(header.sizes[p] != (u64)get_table_size(pattern) ||
+         header.offsets[p] % 64 != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  [[nodiscard]] static bool
+  load_database(char const* const path, Partition_Definition const& partition) {
+    i32 const fd = open(path, O_RDONLY);
+    if(fd < 0) {
+      return false;
+    }
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 ||
+       file_stat.st_size < (i64)sizeof(Pattern_Database_Header)) {
+      close(fd);
+      return false;
+    }
+
+    void* const file =
+      mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping remains valid after the descriptor is closed.
+    close(fd);
+    if(file == MAP_FAILED) {
+      return false;
+    }
+
+    Pattern_Database_Header const& header =
+      *static_cast<Pattern_Database_Header const*>(file);
+    bool valid = header_matches(header, partition);
+    for(i32 p = 0; valid && p < partition.pattern_count; p += 1) {
+      valid = header.offsets[p] + header.sizes[p] <= (u64)file_stat.st_size;
+    }
+
+    if(!valid) {
+      munmap(file, file_stat.st_size);
+      return false;
+    }
+
+    mapped_file = file;
+    mapped_file_size = file_stat.st_size;
+    for(i32 p = 0; p < partition.pattern_count; p += 1) {
+      active_tables[p] = static_cast<u8 const*>(file) + header.offsets[p];
+    }
+    return true;
+  }
+
+  // save_database
+  // Write the owned tables to path. The file is written under a temporary
+  // name and renamed so that a concurrently starting process never maps a
+  // partially written database.
+  //
+  [[nodiscard]] static bool
+  save_database(char const* const path, Partition_Definition const& partition) {
+    Pattern_Database_Header header = {};
+    memcpy(header.magic, pattern_database_magic, sizeof(header.magic));
+    header.version = pattern_database_version;
+    header.pattern_count = partition.pattern_count;
+    u64 offset = (sizeof(Pattern_Database_Header) + 63) & ~(u64)63;
+    for(i32 p = 0; p < partition.pattern_count; p += 1) {
+      Pattern const& pattern = partition.patterns[p];
+      for(i32 i = 0; i < pattern.tile_count; i += 1) {
+        header.tiles[p][i] = pattern.tiles[i];
+      }
+      header.offsets[p] = offset;
+      header.sizes[p] = owned_tables[p].size();
+      offset = (offset + header.sizes[p] + 63) & ~(u64)63;
+    }
+
+    std::vector<char> temporary_path(strlen(path) + 5);
+    snprintf(temporary_path.data(), temporary_path.size(), "%s.tmp", path);
+    FILE* const file = fopen(temporary_path.data(), "wb");
+    if(file == nullptr) {
+      return false;
+    }
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    u64 written = sizeof(header);
+    for(i32 p = 0; success && p < partition.pattern_count; p += 1) {
+      static constexpr u8 zeros[64] = {};
+      success = fwrite(zeros, 1, header.offsets[p] - written, file) ==
+                  header.offsets[p] - written &&
+                fwrite(owned_tables[p].data(), 1, header.sizes[p], file) ==
+                  header.sizes[p];
+      written = header.offsets[p] + header.sizes[p];
+    }
+    success = fclose(file) == 0 && success;
+    if(success) {
+      success = rename(temporary_path.data(), path) == 0;
+    }
+    if(!success) {
+      remove(temporary_path.data());
+    }
+    return success;
+  }
+
+  Pattern_Database_Statistics
+  build_pattern_database(Pattern_Database_Parameters const p) {
+    release_database();
+    Partition_Definition const partition =
+      get_partition_definition(p.partition);
+    active_partition = partition;
+
+    Pattern_Database_Statistics statistics;
+    for(i32 i = 0; i < partition.pattern_count; i += 1) {
+      statistics.entries += get_table_size(partition.patterns[i]);
+    }
+    statistics.bytes = statistics.entries;
+
+    if(p.cache_path != nullptr && load_database(p.cache_path, partition)) {
+      statistics.loaded = true;
+      return statistics;
+    }
+
+    Work_Stealing_Pool pool(p.threads);
+    for(i32 i = 0; i < partition.pattern_count; i += 1) {
+      DEBUG_PRINT("Building pattern %d\n", i);
+      build_table(owned_tables[i], partition.patterns[i], pool);
+      active_tables[i] = owned_tables[i].data();
+    }
+
+    if(p.cache_path != nullptr) {
+      statistics.saved = save_database(p.cache_path, partition);
+    }
+    return statistics;
+  }
+
+  // lookup_pattern_database
+  //
+  // Parameters:
+  // squares - square of every tile.
+  // excluded_tile - patterns containing this tile are skipped.
+  //
+  [[nodiscard]] static i32 lookup_pattern_database(i8 const* const squares,
+                                                   i32 const excluded_tile) {
+    i32 result = 0;
+    for(i32 p = 0; p < active_partition.pattern_count; p += 1) {
+      Pattern const& pattern = active_partition.patterns[p];
+      u32 packed = 0;
+      bool excluded = false;
+      for(i32 i = 0; i < pattern.tile_count; i += 1) {
+        i32 const tile = pattern.tiles[i];
+        excluded |= tile == excluded_tile;
+        packed |= (u32)squares[tile] << (i * 4);
+      }
+
+      if(!excluded) {
+        result += active_tables[p][rank_squares(packed, pattern.tile_count)];
+      }
+    }
+    return result;
+  }
+
+  i32 heuristic_pattern_database(u64 const board) {
+    i8 squares[16];
+    for(i32 index = 0; index < 16; index += 1) {
+      squares[get_tile(board, index)] = index;
+    }
+    return lookup_pattern_database(squares, -1);
+  }
+
+  i32 heuristic_pattern_database_generic(u64 const board,
+                                         Goal_Remap const& goal) {
+    // Rename the tiles so that the tile with goal square s becomes s + 1, i.e.
+    // as if the goal were the standard goal configuration. The name of the
+    // goal square of the empty square has no tile, hence the pattern
+    // containing it is skipped, and the tile with goal square 15 belongs to
+    // no pattern. Both only lower the value which keeps it admissible.
+    i32 const goal_empty = goal.squares[0];
+    i8 squares[16] = {};
+    for(i32 index = 0; index < 16; index += 1) {
+      i32 const tile = get_tile(board, index);
+      i32 const name = goal.squares[tile] + 1;
+      if(tile != 0 && name < 16) {
+        squares[name] = index;
+      }
+    }
+    return lookup_pattern_database(squares,
+                                   goal_empty < 15 ? goal_empty + 1 : -1);
+  }
+} // namespace puzzle15
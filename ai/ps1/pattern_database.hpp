@@ -0,0 +1,56 @@
+#pragma once
+
+#include <heuristic.hpp>
+#include <types.hpp>
+
+namespace puzzle15 {
+  // Pattern_Partition
+  // Partition of the tiles into disjoint patterns. The values of the pattern
+  // databases are added together, hence larger patterns yield a stronger
+  // heuristic at the cost of memory and build time.
+  //
+  enum struct Pattern_Partition {
+    // Three 5 tile patterns, 3 x 512 KiB.
+    five_five_five,
+    // Two 6 tile patterns and a 3 tile pattern, 2 x 5.5 MiB + 3.3 KiB.
+    six_six_three,
+    // 7 and 8 tile patterns, 55 MiB + 495 MiB.
+    seven_eight,
+  };
+
+  struct Pattern_Database_Parameters {
+    Pattern_Partition partition = Pattern_Partition::five_five_five;
+    // Path to the cache file. The database is mapped from the file if it
+    // holds a database of the same partition and format version, otherwise
+    // the database is built and written to the file. nullptr disables the
+    // cache.
+    char const* cache_path = nullptr;
+    // Number of threads used to build the database.
+    i32 threads = 1;
+  };
+
+  struct Pattern_Database_Statistics {
+    i64 entries = 0;
+    i64 bytes = 0;
+    // Whether the database has been mapped from the cache file.
+    bool loaded = false;
+    // Whether a built database has been written to the cache file.
+    bool saved = false;
+  };
+
+  // build_pattern_database
+  // Build or load the pattern database used by heuristic_pattern_database.
+  // Replaces the previous database, if any.
+  //
+  Pattern_Database_Statistics
+  build_pattern_database(Pattern_Database_Parameters parameters);
+
+  // heuristic_pattern_database
+  // Disjoint additive pattern database heuristic. Every pattern database
+  // stores the number of moves of the pattern tiles required to bring them to
+  // their goal squares, ignoring the other tiles and the empty square.
+  //
+  [[nodiscard]] i32 heuristic_pattern_database(u64 board);
+  [[nodiscard]] i32 heuristic_pattern_database_generic(u64 board,
+                                                       Goal_Remap const& goal);
+} // namespace puzzle15
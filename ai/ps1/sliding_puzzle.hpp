@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <stdio.h>
+#include <string_view>
+#include <type_traits>
+
+#include <types.hpp>
+
+// Sliding_Puzzle
+// Geometry and packed board representation of a Width x Height sliding
+// puzzle. Everything is computed at compile time from the dimensions, hence
+// every size gets its own constant folded move tables and packing.
+//
+// In a configuration the tiles are numbered from 1 to cells - 1 and the empty
+// square is denoted by cells. The goal configuration lists the tiles in
+// increasing order with the empty square last.
+//
+// The board is packed into a single word, square_bits bits per square, with
+// the first square in the most significant bits, i.e. the layout produced by
+// hash_configuration. The empty square is stored as 0. The packed board
+// doubles as the unique id of the configuration.
+//
+template<i32 Width, i32 Height>
+struct Sliding_Puzzle {
+  static constexpr i32 width = Width;
+  static constexpr i32 height = Height;
+  static constexpr i32 cells = Width * Height;
+  static constexpr i32 square_bits = std::bit_width((u32)cells - 1);
+
+  static_assert(Width >= 2 && Height >= 2, "board too small");
+  static_assert(cells * square_bits <= 128, "board does not fit 128 bits");
+
+  using board_t = std::conditional_t<cells * square_bits <= 64, u64, u128>;
+  using Configuration = std::array<Configuration_Entry, cells>;
+  // Heuristics operate on packed boards. See heuristic_t and
+  // heuristic_delta_t.
+  using heuristic_t = i32 (*)(board_t board);
+  using heuristic_delta_t = i32 (*)(board_t board, i32 tile, i32 empty);
+
+  static constexpr board_t square_mask = (board_t(1) << square_bits) - 1;
+
+  struct State {
+    board_t board = 0;
+    // Index of the empty square.
+    i32 empty = 0;
+  };
+
+  [[nodiscard]] static constexpr Configuration
+  copy_configuration(Configuration_View const view) {
+    // configuration is ALWAYS initialised, but the compiler keeps bitching
+    // about it being maybe uninitialised, hence we do the stupid and initialise
+    // the configuration to 0s and only then copy to it.
+    Configuration configuration = {};
+    std::copy(view.begin(), view.end(), configuration.begin());
+    return configuration;
+  }
+
+  [[nodiscard]] static constexpr board_t
+  hash_configuration(Configuration_View const view) {
+    board_t result = 0;
+    for(i8 v: view) {
+      result = (result << square_bits) | (v != cells ? v : 0);
+    }
+    return result;
+  }
+
+  // Indices are never negative, unsigned division lets the compiler reduce
+  // it to shifts for power of 2 widths.
+  [[nodiscard]] static constexpr i32 row(i32 const index) {
+    return (u32)index / width;
+  }
+
+  [[nodiscard]] static constexpr i32 column(i32 const index) {
+    return (u32)index % width;
+  }
+
+  // parse_configuration
+  // Parse cells numbers separated by whitespace or commas. The empty square
+  // may be denoted by either 0 or cells.
+  //
+  // Returns:
+  // Whether the string is a permutation of the tiles.
+  //
+  [[nodiscard]] static bool parse_configuration(std::string_view string,
+                                                Configuration& configuration) {
+    u64 seen = 0;
+    i32 count = 0;
+    while(true) {
+      while(string.size() > 0 &&
+            (string[0] == ' ' || string[0] == '\t' || string[0] == ',' ||
+             string[0] == '\r' || string[0] == '\n')) {
+        string.remove_prefix(1);
+      }
+
+      if(string.size() == 0) {
+        break;
+      }
+
+      i32 value = 0;
+      auto const [end, error] =
+        std::from_chars(string.data(), string.data() + string.size(), value);
+      if(error != std::errc() || value < 0 || value > cells ||
+         count >= cells) {
+        return false;
+      }
+
+      if(value == 0) {
+        value = cells;
+      }
+      seen |= (u64)1 << (value - 1);
+      configuration[count] = value;
+      count += 1;
+      string.remove_prefix(end - string.data());
+    }
+    return count == cells && seen == ((u64)1 << cells) - 1;
+  }
+
+  [[nodiscard]] static constexpr i32 square_shift(i32 const index) {
+    return (cells - 1 - index) * square_bits;
+  }
+
+  [[nodiscard]] static constexpr i32 get_tile(board_t const board,
+                                              i32 const index) {
+    return (board >> square_shift(index)) & square_mask;
+  }
+
+  [[nodiscard]] static constexpr State
+  pack_configuration(Configuration_View const view) {
+    State state;
+    state.board = hash_configuration(view);
+    for(i32 index = 0; Configuration_Entry const v: view) {
+      if(v == cells) {
+        state.empty = index;
+      }
+      index += 1;
+    }
+    return state;
+  }
+
+  [[nodiscard]] static constexpr Configuration
+  unpack_board(board_t const board) {
+    Configuration configuration = {};
+    for(i32 index = 0; index < cells; index += 1) {
+      i32 const tile = get_tile(board, index);
+      configuration[index] = tile != 0 ? tile : cells;
+    }
+    return configuration;
+  }
+
+  // move_empty
+  // Slide the tile at target into the empty square. target must be adjacent
+  // to the empty square.
+  //
+  [[nodiscard]] static constexpr State move_empty(State const state,
+                                                  i32 const target) {
+    board_t const tile = get_tile(state.board, target);
+    // The empty square is 0, hence the swap reduces to moving the tile.
+    board_t const board = state.board - (tile << square_shift(target)) +
+                          (tile << square_shift(state.empty));
+    return State{board, target};
+  }
+
+  static constexpr Configuration goal_configuration = [] {
+    Configuration configuration = {};
+    for(i32 index = 0; index < cells; index += 1) {
+      configuration[index] = index + 1;
+    }
+    return configuration;
+  }();
+
+  static constexpr State goal_state = pack_configuration(goal_configuration);
+
+  // Index of the square the empty square moves to in every direction from
+  // every square, -1 if the move leaves the board. Directions are 0 - up,
+  // 1 - right, 2 - down, 3 - left.
+  static constexpr std::array<std::array<i8, 4>, cells> successor_targets =
+    [] {
+      std::array<std::array<i8, 4>, cells> table = {};
+      for(i32 index = 0; index < cells; index += 1) {
+        table[index][0] = row(index) > 0 ? index - width : -1;
+        table[index][1] = column(index) < width - 1 ? index + 1 : -1;
+        table[index][2] = row(index) < height - 1 ? index + width : -1;
+        table[index][3] = column(index) > 0 ? index - 1 : -1;
+      }
+      return table;
+    }();
+
+  // successor_target
+  // Calculate the index of the square the empty square moves to.
+  //
+  // Parameters:
+  // empty - index of the empty square.
+  // successor - direction of the move. 0 - up, 1 - right, 2 - down, 3 - left.
+  //
+  // Returns:
+  // Index of the target square or -1 if the move leaves the board.
+  //
+  [[nodiscard]] static constexpr i32 successor_target(i32 const empty,
+                                                      i32 const successor) {
+    return successor_targets[empty][successor];
+  }
+
+  // Legal_Moves
+  // Squares adjacent to a square in the order up, right, down, left. Iterating
+  // over them visits exactly the legal moves without testing board edges.
+  //
+  struct Legal_Moves {
+    std::array<i8, 4> targets = {};
+    i32 count = 0;
+
+    [[nodiscard]] constexpr i8 const* begin() const {
+      return targets.data();
+    }
+
+    [[nodiscard]] constexpr i8 const* end() const {
+      return targets.data() + count;
+    }
+  };
+
+  static constexpr std::array<Legal_Moves, cells> legal_moves = [] {
+    std::array<Legal_Moves, cells> table = {};
+    for(i32 index = 0; index < cells; index += 1) {
+      Legal_Moves& moves = table[index];
+      for(i32 const target: successor_targets[index]) {
+        if(target >= 0) {
+          moves.targets[moves.count] = target;
+          moves.count += 1;
+        }
+      }
+    }
+    return table;
+  }();
+
+  // moves
+  // The squares the empty square at empty may move to. The move undoing the
+  // move from square parent to empty is the one targetting parent.
+  //
+  [[nodiscard]] static constexpr Legal_Moves const& moves(i32 const empty) {
+    return legal_moves[empty];
+  }
+
+  [[nodiscard]] static constexpr bool
+  is_solvable(Configuration_View const c) {
+    // Count the inversions among the tiles, the empty square does not take
+    // part in them.
+    i32 inversions = 0;
+    i32 empty_row = 0;
+    for(i32 i = 0; i < cells; i += 1) {
+      if(c[i] == cells) {
+        empty_row = row(i);
+        continue;
+      }
+
+      for(i32 j = i + 1; j < cells; j += 1) {
+        if(c[j] != cells && c[i] > c[j]) {
+          inversions += 1;
+        }
+      }
+    }
+
+    // Horizontal moves change neither the inversions nor the row of the
+    // empty square. On a board of odd width vertical moves preserve the
+    // parity of the inversions, on a board of even width they change the
+    // parity of both. The goal has no inversions and the empty square in the
+    // last row.
+    if constexpr(width % 2 == 1) {
+      return inversions % 2 == 0;
+    } else {
+      return (inversions + height - 1 - empty_row) % 2 == 0;
+    }
+  }
+
+  static void print(Configuration_View const configuration) {
+    for(i32 n = 0; Configuration_Entry const v: configuration) {
+      if(n > 0 && (n % width) == 0) {
+        printf("\n");
+      }
+      if(v != cells) {
+        printf(" %2d", v);
+      } else {
+        printf(" \033[38;5;9m%2d\033[0m", v);
+      }
+      n += 1;
+    }
+    printf("\n");
+  }
+};
+
+namespace puzzle8 {
+  using Puzzle = Sliding_Puzzle<3, 3>;
+  using Configuration = Puzzle::Configuration;
+  using State = Puzzle::State;
+} // namespace puzzle8
+
+namespace puzzle15 {
+  using Puzzle = Sliding_Puzzle<4, 4>;
+  using Configuration = Puzzle::Configuration;
+  using State = Puzzle::State;
+
+  [[nodiscard]] constexpr Configuration
+  copy_configuration(Configuration_View const view) {
+    return Puzzle::copy_configuration(view);
+  }
+
+  [[nodiscard]] constexpr u64
+  hash_configuration(Configuration_View const view) {
+    return Puzzle::hash_configuration(view);
+  }
+
+  [[nodiscard]] constexpr i32 square_shift(i32 const index) {
+    return Puzzle::square_shift(index);
+  }
+
+  [[nodiscard]] constexpr i32 get_tile(u64 const board, i32 const index) {
+    return Puzzle::get_tile(board, index);
+  }
+
+  [[nodiscard]] constexpr State
+  pack_configuration(Configuration_View const view) {
+    return Puzzle::pack_configuration(view);
+  }
+
+  [[nodiscard]] constexpr Configuration unpack_board(u64 const board) {
+    return Puzzle::unpack_board(board);
+  }
+
+  [[nodiscard]] constexpr State move_empty(State const state,
+                                           i32 const target) {
+    return Puzzle::move_empty(state, target);
+  }
+
+  inline void print(Configuration_View const configuration) {
+    Puzzle::print(configuration);
+  }
+} // namespace puzzle15
+
+namespace puzzle24 {
+  using Puzzle = Sliding_Puzzle<5, 5>;
+  using Configuration = Puzzle::Configuration;
+  using State = Puzzle::State;
+} // namespace puzzle24
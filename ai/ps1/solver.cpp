@@ -1,459 +1,797 @@
 #include <solver.hpp>
 
 #include <algorithm>
-#include <map>
-#include <queue>
-#include <stack>
+#include <atomic>
+#include <optional>
+#include <set>
+#include <type_traits>
 
+#include <arena.hpp>
+#include <bucket_open_list.hpp>
 #include <debug.hpp>
+#include <hash_table.hpp>
 #include <heap.hpp>
+#include <thread_pool.hpp>
+#include <transposition_table.hpp>
 
 constexpr i32 FOUND = -1;
+constexpr i32 CANCELLED = -2;
+
+template<typename Puzzle>
+struct IDAstar_Result {
+  std::vector<typename Puzzle::Configuration> path;
+  i64 depth = 0;
+  i64 explored = 0;
+  Transposition_Table_Statistics table;
+  i32 result = 0;
+};
+
+// Only the boards packed into a single word fit the transposition table.
+template<typename Puzzle>
+constexpr bool transposition_table_supported =
+  std::is_same_v<typename Puzzle::board_t, u64>;
+
+// IDAstar_search
+// Depth first search of the subtree rooted at the last configuration of
+// path bounded by f_cutoff. The move undoing the last move is never made and
+// the successors are searched in the increasing order of the heuristic, so
+// that the last iteration reaches the goal sooner.
+//
+// Parameters:
+// path - configurations from the starting configuration to the root of the
+//        subtree. The root is assumed to be within f_cutoff and not to be
+//        the goal.
+// root_cost - cost of the path to the root of the subtree.
+// root_h - value of the heuristic function at the root.
+// table - optional. The configurations are looked up before being expanded
+//         and the bounds backed up from their subtrees stored, hence a
+//         transposition whose subtree has already failed f_cutoff is not
+//         searched again.
+// generation - index of the deepening iteration.
+// cancel - checked periodically when not nullptr. The search is abandoned
+//          with the result CANCELLED once it becomes true.
+// trace - optional. Not thread-safe, hence must not be shared by workers.
+//
+// Returns:
+// FOUND, CANCELLED or the smallest f value exceeding f_cutoff.
+//
+template<typename Puzzle>
+[[nodiscard]] static IDAstar_Result<Puzzle>
+IDAstar_search(std::vector<typename Puzzle::State> path, i32 const root_cost,
+               i32 const root_h,
+               typename Puzzle::heuristic_t const heuristic,
+               typename Puzzle::heuristic_delta_t const heuristic_delta,
+               i32 const f_cutoff, Transposition_Table* const table,
+               i32 const generation, std::atomic<bool> const* const cancel,
+               Search_Trace* const trace) {
+  using State = typename Puzzle::State;
 
-namespace puzzle15 {
-  bool is_solvable(Configuration_View const c) {
-    i32 inversions = 0;
-    for(i32 i = 1; i < 16; i += 1) {
-      for(i32 j = i + 1; j < 16; j += 1) {
-        if(c[i] < c[j]) {
-          inversions += 1;
+#define RETURN_VALUE(value)                  \
+{                                          \
+  path.pop_back();                         \
+  i32 const local_value = value;           \
+  stack.pop_back();                        \
+  Frame& parent_frame = stack.back();      \
+  parent_frame.return_value = local_value; \
+  parent_frame.returned = true;            \
+  continue;                                \
+}
+
+#define CALL(state, cost, h) \
+{                          \
+  path.push_back(state);   \
+  Frame frame;             \
+  frame.path_cost = cost;  \
+  frame.h_value = h;       \
+  frame.created = true;    \
+  stack.push_back(frame);  \
+  continue;                \
+}
+
+  struct Child {
+    State state;
+    i32 h_value = 0;
+  };
+
+  struct Frame {
+    i32 path_cost = 0;
+    // Value of the heuristic function.
+    i32 h_value = 0;
+    // Successors in the order they are searched in.
+    std::array<Child, 4> children;
+    i32 children_count = 0;
+    i32 successor = 0;
+    i32 min = i32_largest_value;
+    i32 return_value = 0;
+    bool returned = false;
+    bool created = false;
+    bool expanded = false;
+  };
+
+  IDAstar_Result<Puzzle> statistics;
+  std::vector<Frame> stack;
+  {
+    Frame frame;
+    frame.path_cost = root_cost;
+    frame.h_value = root_h;
+    stack.push_back(frame);
+  }
+  while(stack.size() > 0) {
+    Frame& frame = stack.back();
+    i32& path_cost = frame.path_cost;
+    i32& h_value = frame.h_value;
+    std::array<Child, 4>& children = frame.children;
+    i32& children_count = frame.children_count;
+    i32& successor = frame.successor;
+    i32& min = frame.min;
+    i32& return_value = frame.return_value;
+    bool& returned = frame.returned;
+    bool& created = frame.created;
+    bool& expanded = frame.expanded;
+    State const state = path.back();
+
+    if((i64)path.size() > statistics.depth) {
+      statistics.depth = path.size();
+      DEBUG_PRINT("Reached depth %lld\n", statistics.depth);
+    }
+
+    // We have returned from a "recursive call".
+    if(returned) {
+      if(return_value < min) {
+        min = return_value;
+      }
+      returned = false;
+    }
+
+    // New configuration is being explored.
+    if(created) {
+      created = false;
+      statistics.explored += 1;
+      TRACE(trace, expand(path_cost));
+      // Polling every node would make the workers contend on the flag.
+      if(cancel != nullptr && (statistics.explored & 1023) == 0 &&
+         cancel->load(std::memory_order_relaxed)) {
+        statistics.result = CANCELLED;
+        return statistics;
+      }
+
+      // Goal check should appear after f cutoff check, however, this way
+      // we save a few iterations of the search.
+      if(state.board == Puzzle::goal_state.board) {
+        statistics.result = FOUND;
+        for(State const s: path) {
+          statistics.path.push_back(Puzzle::unpack_board(s.board));
+        }
+        return statistics;
+      }
+
+      i32 f_value = path_cost + h_value;
+      if constexpr(transposition_table_supported<Puzzle>) {
+        if(table != nullptr && f_value <= f_cutoff) {
+          statistics.table.probes += 1;
+          Transposition_Entry entry;
+          if(table->find(state.board, entry)) {
+            statistics.table.hits += 1;
+            // The backed up bound exceeds the heuristic whenever the subtree
+            // has already been searched from a configuration at most as far
+            // from the start in this iteration.
+            if(path_cost + entry.bound > f_cutoff) {
+              statistics.table.cutoffs += 1;
+              f_value = path_cost + entry.bound;
+            }
+          }
         }
       }
+      if(f_value > f_cutoff) {
+        RETURN_VALUE(f_value);
+      }
     }
 
-    i32 empty_row = 1;
-    // No need to check the first row. Check 2nd row immediately.
-    if(c[4] == 16 || c[5] == 16 || c[6] == 16 || c[7] == 16) {
-      empty_row = 2;
+    if(!expanded) {
+      expanded = true;
+      i32 const parent_empty =
+        path.size() > 1 ? path[path.size() - 2].empty : -1;
+      for(i32 const target: Puzzle::moves(state.empty)) {
+        TRACE(trace, generate(target == parent_empty));
+        if(target == parent_empty) {
+          continue;
+        }
+
+        State const successor_state = Puzzle::move_empty(state, target);
+        i32 const successor_h =
+          heuristic_delta != nullptr
+            ? h_value + TRACE_HEURISTIC(trace, heuristic_delta(state.board,
+                                                               target,
+                                                               state.empty))
+            : TRACE_HEURISTIC(trace, heuristic(successor_state.board));
+        // Insertion keeping the order of the moves among equal values.
+        i32 position = children_count;
+        while(position > 0 && children[position - 1].h_value > successor_h) {
+          children[position] = children[position - 1];
+          position -= 1;
+        }
+        children[position] = Child{successor_state, successor_h};
+        children_count += 1;
+      }
     }
-    // Check 3rd row.
-    if(c[8] == 16 || c[9] == 16 || c[10] == 16 || c[11] == 16) {
-      empty_row = 3;
+
+    // Search through successors.
+    if(successor < children_count) {
+      Child const child = children[successor];
+      successor += 1;
+      CALL(child.state, path_cost + 1, child.h_value);
     }
-    // Check 4th row.
-    if(c[12] == 16 || c[13] == 16 || c[14] == 16 || c[15] == 16) {
-      empty_row = 4;
+
+    // A subtree without a configuration beyond f_cutoff backs up no bound.
+    if constexpr(transposition_table_supported<Puzzle>) {
+      if(table != nullptr && min != i32_largest_value) {
+        statistics.table.stores += 1;
+        table->store(state.board, Transposition_Entry{
+                                    .g = path_cost,
+                                    .bound = min - path_cost,
+                                    .generation = generation,
+                                  });
+      }
     }
 
-    return (inversions + empty_row) % 2 == 0;
+    // We do not want to pop the last frame with RETURN_VALUE since that
+    // would also remove the last node from the path and we would be unable
+    // to return the minimum.
+    if(stack.size() > 1) {
+      RETURN_VALUE(min);
+    } else {
+      statistics.result = min;
+      return statistics;
+    }
   }
 
-  constexpr Configuration goal_configuration = {
-    1,  2,  3,  4, //
-    5,  6,  7,  8, //
-    9,  10, 11, 12, //
-    13, 14, 15, 16 //
-  };
+  __builtin_unreachable();
+#undef RETURN_VALUE
+#undef CALL
+}
+
+// IDAstar_Task
+// Subtree of a deepening iteration searched by a single worker.
+//
+template<typename Puzzle>
+struct IDAstar_Task {
+  // Configurations from the starting configuration to the root of the
+  // subtree.
+  std::vector<typename Puzzle::State> path;
+  i32 h_value = 0;
+};
+
+// expand_frontier
+// Enumerate the configurations at split_depth below the starting
+// configuration that lie within f_cutoff. Configurations beyond f_cutoff
+// encountered on the way contribute to statistics.result as in
+// IDAstar_search.
+//
+// Parameters:
+// path - configurations from the starting configuration to the one being
+//        expanded.
+// h_value - value of the heuristic function at the last configuration of
+//           path.
+//
+template<typename Puzzle>
+static void
+expand_frontier(std::vector<typename Puzzle::State>& path, i32 const h_value,
+                typename Puzzle::heuristic_t const heuristic,
+                typename Puzzle::heuristic_delta_t const heuristic_delta,
+                i32 const f_cutoff, i32 const split_depth,
+                std::vector<IDAstar_Task<Puzzle>>& frontier,
+                IDAstar_Result<Puzzle>& statistics) {
+  using State = typename Puzzle::State;
+  i32 const path_cost = path.size() - 1;
+  if((i64)path.size() > statistics.depth) {
+    statistics.depth = path.size();
+  }
 
-  static constexpr u64 goal_configuration_hash =
-    hash_configuration(goal_configuration);
+  if(path_cost >= split_depth) {
+    frontier.push_back(
+      IDAstar_Task<Puzzle>{.path = path, .h_value = h_value});
+    return;
+  }
 
-  [[nodiscard]] static std::optional<Configuration>
-  generate_successor(Configuration_View const configuration,
-                     i32 const successor) {
-    i32 empty_index = 0;
-    while(configuration[empty_index] != 16) {
-      empty_index += 1;
+  State const state = path.back();
+  i32 const parent_empty = path.size() > 1 ? path[path.size() - 2].empty : -1;
+  for(i32 const target: Puzzle::moves(state.empty)) {
+    if(target == parent_empty) {
+      continue;
     }
 
-    switch(successor) {
-      case 0: {
-        // Check top row.
-        if(empty_index >= 4) {
-          Configuration node = copy_configuration(configuration);
-          std::swap(node[empty_index], node[empty_index - 4]);
-          return node;
-        }
-        return std::nullopt;
+    State const successor_state = Puzzle::move_empty(state, target);
+    statistics.explored += 1;
+    path.push_back(successor_state);
+    if(successor_state.board == Puzzle::goal_state.board) {
+      statistics.result = FOUND;
+      for(State const s: path) {
+        statistics.path.push_back(Puzzle::unpack_board(s.board));
       }
+      return;
+    }
 
-      case 1: {
-        i32 const empty_x = empty_index % 4;
-        // Check rightmost row.
-        if(empty_x < 3) {
-          Configuration node = copy_configuration(configuration);
-          std::swap(node[empty_index], node[empty_index + 1]);
-          return node;
-        }
-        return std::nullopt;
+    i32 const successor_h =
+      heuristic_delta != nullptr
+        ? h_value + heuristic_delta(state.board, target, state.empty)
+        : heuristic(successor_state.board);
+    i32 const f_value = path_cost + 1 + successor_h;
+    if(f_value > f_cutoff) {
+      if(f_value < statistics.result) {
+        statistics.result = f_value;
       }
-
-      case 2: {
-        // Check bottom row.
-        if(empty_index < 12) {
-          Configuration node = copy_configuration(configuration);
-          std::swap(node[empty_index], node[empty_index + 4]);
-          return node;
-        }
-        return std::nullopt;
+    } else {
+      expand_frontier<Puzzle>(path, successor_h, heuristic, heuristic_delta,
+                              f_cutoff, split_depth, frontier, statistics);
+      if(statistics.result == FOUND) {
+        return;
       }
+    }
+    path.pop_back();
+  }
+}
 
-      case 3: {
-        i32 const empty_x = empty_index % 4;
-        // Check leftmost row.
-        if(empty_x > 0) {
-          Configuration node = copy_configuration(configuration);
-          std::swap(node[empty_index], node[empty_index - 1]);
-          return node;
-        }
-        return std::nullopt;
+static void atomic_min(std::atomic<i32>& target, i32 const value) {
+  i32 current = target.load(std::memory_order_relaxed);
+  while(value < current &&
+        !target.compare_exchange_weak(current, value,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+// IDAstar_parallel_search
+// Single deepening iteration distributed over the workers of pool. The
+// tree is expanded sequentially down to split_depth and the subtrees rooted
+// at the frontier are searched as independent tasks. The first worker to
+// find the goal cancels the others. Since all subtrees are bounded by the
+// same f_cutoff, any goal found is optimal.
+//
+template<typename Puzzle>
+[[nodiscard]] static IDAstar_Result<Puzzle>
+IDAstar_parallel_search(typename Puzzle::State const starting_state,
+                        Sliding_IDAstar_Parameters<Puzzle> const& p,
+                        i32 const f_cutoff, i32 const split_depth,
+                        Transposition_Table* const table,
+                        i32 const generation, Work_Stealing_Pool& pool) {
+  IDAstar_Result<Puzzle> statistics;
+  statistics.result = i32_largest_value;
+  std::vector<IDAstar_Task<Puzzle>> frontier;
+  {
+    std::vector<typename Puzzle::State> path = {starting_state};
+    i32 const h_value = p.heuristic(starting_state.board);
+    expand_frontier<Puzzle>(path, h_value, p.heuristic, p.heuristic_delta,
+                            f_cutoff, split_depth, frontier, statistics);
+  }
+
+  if(statistics.result == FOUND) {
+    return statistics;
+  }
+
+  DEBUG_PRINT("IDA* f_cutoff %d; %lld tasks\n", f_cutoff,
+              (i64)frontier.size());
+  std::atomic<bool> found = false;
+  std::atomic<i32> min_overflow = statistics.result;
+  std::vector<i64> explored(pool.size(), 0);
+  std::vector<i64> depth(pool.size(), 0);
+  std::vector<Transposition_Table_Statistics> table_statistics(pool.size());
+  pool.run(frontier.size(), [&](i32 const worker, i64 const task) {
+    if(found.load(std::memory_order_relaxed)) {
+      return;
+    }
+
+    IDAstar_Task<Puzzle>& t = frontier[task];
+    i32 const root_cost = t.path.size() - 1;
+    IDAstar_Result<Puzzle> result = IDAstar_search<Puzzle>(
+      std::move(t.path), root_cost, t.h_value, p.heuristic, p.heuristic_delta,
+      f_cutoff, table, generation, &found, nullptr);
+    explored[worker] += result.explored;
+    table_statistics[worker].accumulate(result.table);
+    if(result.depth > depth[worker]) {
+      depth[worker] = result.depth;
+    }
+
+    if(result.result == FOUND) {
+      // Only the first worker to find the goal publishes its path.
+      if(!found.exchange(true)) {
+        statistics.path = std::move(result.path);
       }
+    } else if(result.result != CANCELLED) {
+      atomic_min(min_overflow, result.result);
+    }
+  });
 
-      default:
-        return std::nullopt;
+  for(i32 worker = 0; worker < pool.size(); worker += 1) {
+    statistics.explored += explored[worker];
+    statistics.table.accumulate(table_statistics[worker]);
+    if(depth[worker] > statistics.depth) {
+      statistics.depth = depth[worker];
     }
   }
+  statistics.result = found ? FOUND : min_overflow.load();
+  return statistics;
+}
+
+// sliding_IDAstar_solver
+// IDA* on the puzzle of any size. See puzzle15::IDAstar_solver.
+//
+template<typename Puzzle>
+[[nodiscard]] static Solution<typename Puzzle::Configuration>
+sliding_IDAstar_solver(Sliding_IDAstar_Parameters<Puzzle> const p) {
+  TRACE(p.trace, begin("IDA*"));
+  typename Puzzle::State const state =
+    Puzzle::pack_configuration(p.starting_configuration);
+  i32 const h_value = p.heuristic(state.board);
+  i32 f_cutoff = p.initial_f_cutoff;
+  if(f_cutoff <= 0) {
+    f_cutoff = h_value;
+  }
+  // Cap max iterations at 1 million if not provided.
+  i32 const max_iterations =
+    p.max_iterations > 0 ? p.max_iterations : (1 << 20);
+  i32 const split_depth =
+    p.split_depth > 0 ? p.split_depth : IDAstar_default_split_depth;
+  // The pool is only needed by the parallel search.
+  std::optional<Work_Stealing_Pool> pool;
+  if(p.threads > 1) {
+    pool.emplace(p.threads);
+  }
+  Solution<typename Puzzle::Configuration> solution;
+  std::optional<Transposition_Table> table;
+  if(transposition_table_supported<Puzzle> &&
+     p.transposition_table_bytes > 0) {
+    table.emplace(p.transposition_table_bytes);
+    solution.transposition_table.capacity = table->capacity();
+    solution.transposition_table.bytes = table->bytes();
+  }
+  Transposition_Table* const table_pointer = table ? &*table : nullptr;
+  // The search never checks its root against the goal.
+  if(state.board == Puzzle::goal_state.board) {
+    solution.found = true;
+    solution.depth = 1;
+    solution.path.push_back(Puzzle::unpack_board(state.board));
+    TRACE(p.trace, end());
+    return solution;
+  }
 
-  struct IDAstar_Result {
-    std::vector<Configuration> path;
-    i64 depth = 0;
-    i64 explored = 0;
-    i32 result = 0;
+  solution.iterations = max_iterations;
+  for(i32 i = 0; i < max_iterations; i += 1) {
+    TRACE(p.trace, begin_iteration(f_cutoff));
+    IDAstar_Result<Puzzle> statistics;
+    if(pool) {
+      statistics = IDAstar_parallel_search<Puzzle>(
+        state, p, f_cutoff, split_depth, table_pointer, i, *pool);
+    } else {
+      statistics = IDAstar_search<Puzzle>(
+        {state}, 0, h_value, p.heuristic, p.heuristic_delta, f_cutoff,
+        table_pointer, i, nullptr, p.trace);
+    }
+    TRACE(p.trace, end_iteration(statistics.explored));
+    DEBUG_PRINT(
+      "IDA* i %d; f_cutoff %d; result %d; depth %lld; explored "
+      "%lld\n",
+      i, f_cutoff, statistics.result, statistics.depth, statistics.explored);
+    // Report the work done by all deepening iterations.
+    solution.explored += statistics.explored;
+    solution.transposition_table.accumulate(statistics.table);
+    if(statistics.result == FOUND) {
+      solution.found = true;
+      solution.iterations = i;
+      solution.depth = statistics.depth;
+      solution.path = std::move(statistics.path);
+      break;
+    } else {
+      f_cutoff = statistics.result;
+    }
+  }
+  TRACE(p.trace, end());
+  return solution;
+}
+
+namespace puzzle15 {
+  bool is_solvable(Configuration_View const c) {
+    return Puzzle::is_solvable(c);
+  }
+
+  static constexpr State goal_state = Puzzle::goal_state;
+
+  [[nodiscard]] static i32 successor_target(i32 const empty,
+                                            i32 const successor) {
+    return Puzzle::successor_target(empty, successor);
+  }
+
+  Solution IDAstar_solver(IDAstar_Parameters const p) {
+    return sliding_IDAstar_solver<Puzzle>(p);
+  }
+
+  // Search_Node
+  // Node of the A* search trees. The configuration is stored packed, which
+  // together with the arena handle keeps the node at 16 bytes.
+  //
+  struct Search_Node {
+    u64 board = 0;
+    arena_handle_t parent = null_arena_handle;
+    // Value of the path cost function.
+    i16 g = 0;
+    // Value of the heuristic function.
+    u8 f = 0;
+    // Index of the empty square.
+    u8 empty : 4 = 0;
+    // Whether the node has been extracted from the open list.
+    u8 closed : 1 = false;
   };
 
-  [[nodiscard]] static IDAstar_Result
-  IDAstar_search(Configuration const& starting_configuration,
-                 heuristic_t const heuristic, i32 const f_cutoff) {
-#define RETURN_VALUE(value)                  \
-  {                                          \
-    path.pop_back();                         \
-    i32 const local_value = value;           \
-    stack.pop();                             \
-    Frame& parent_frame = stack.top();       \
-    parent_frame.return_value = local_value; \
-    parent_frame.returned = true;            \
-    continue;                                \
-  }
-
-#define CALL(conf, hash, cost)             \
-  {                                        \
-    path.push_back(Path_Node{conf, hash}); \
-    Frame frame;                           \
-    frame.path_cost = cost;                \
-    frame.created = true;                  \
-    stack.push(frame);                     \
-    continue;                              \
-  }
-
-    struct Path_Node {
-      Configuration configuration;
-      u64 id = 0;
-    };
+  static_assert(sizeof(Search_Node) == 16);
+
+  // reconstruct_path
+  // Append the configurations on the path from node to the root of its search
+  // tree to path.
+  //
+  static void reconstruct_path(std::vector<Configuration>& path,
+                               Arena<Search_Node> const& nodes,
+                               arena_handle_t const node) {
+    for(arena_handle_t h = node; h != null_arena_handle; h = nodes[h].parent) {
+      path.push_back(unpack_board(nodes[h].board));
+    }
+  }
 
-    struct Frame {
-      i32 path_cost = 0;
-      i32 successor = 0;
-      i32 min = i32_largest_value;
-      i32 return_value = 0;
-      bool returned = false;
-      bool created = false;
-    };
+  // Open lists of the A* solvers. Both order the nodes by the f value and
+  // break ties in favour of the larger g value. The priority of a node in the
+  // list may only be lowered by updating the node and then calling decrease.
 
-    IDAstar_Result statistics;
-    std::stack<Frame> stack;
-    std::vector<Path_Node> path;
-    {
-      Frame frame;
-      stack.push(frame);
-      u64 const hash = hash_configuration(starting_configuration);
-      path.push_back(Path_Node{starting_configuration, hash});
-    }
-    while(stack.size() > 0) {
-      Frame& frame = stack.top();
-      i32& path_cost = frame.path_cost;
-      i32& successor = frame.successor;
-      i32& min = frame.min;
-      i32& return_value = frame.return_value;
-      bool& returned = frame.returned;
-      bool& created = frame.created;
-      auto const& [configuration, configuration_hash] = path.back();
-
-      if((i64)path.size() > statistics.depth) {
-        statistics.depth = path.size();
-        DEBUG_PRINT("Reached depth %lld\n", statistics.depth);
-      }
-
-      // We have returned from a "recursive call".
-      if(returned) {
-        if(return_value < min) {
-          min = return_value;
-        }
-        returned = false;
-      }
-
-      // New configuration is being explored.
-      if(created) {
-        created = false;
-        statistics.explored += 1;
-        // Goal check should appear after f cutoff check, however, this way
-        // we save a few iterations of the search.
-        if(configuration_hash == goal_configuration_hash) {
-          statistics.result = FOUND;
-          for(auto const& [c, _]: path) {
-            statistics.path.push_back(c);
-          }
-          return statistics;
-        }
+  struct Search_Node_Compare {
+    Arena<Search_Node> const* nodes;
 
-        i32 const f_value = path_cost + heuristic(configuration);
-        if(f_value > f_cutoff) {
-          RETURN_VALUE(f_value);
-        }
-      }
+    [[nodiscard]] bool operator()(arena_handle_t const lhs_handle,
+                                  arena_handle_t const rhs_handle) const {
+      Search_Node const& lhs = (*nodes)[lhs_handle];
+      Search_Node const& rhs = (*nodes)[rhs_handle];
+      bool const less = (lhs.g + lhs.f) < (rhs.g + rhs.f);
+      bool const equal = (lhs.g + lhs.f) == (rhs.g + rhs.f);
+      return less || (equal && lhs.f < rhs.f);
+    }
+  };
 
-      // Search through successors.
-      if(successor < 4) {
-        std::optional<Configuration> successor_node =
-          generate_successor(configuration, successor);
-        successor += 1;
-        if(!successor_node) {
-          continue;
-        }
-        // Search through the path to verify that we have not been in
-        // this configuration yet.
-        u64 const successor_id = hash_configuration(successor_node.value());
-        bool contains = false;
-        for(auto const& [configuration, id]: path) {
-          if(id == successor_id) {
-            contains = true;
-            break;
-          }
-        }
+  struct Search_Node_Compare_ID {
+    Arena<Search_Node> const* nodes;
 
-        if(!contains) {
-          CALL(std::move(successor_node.value()), successor_id, path_cost + 1);
-        } else {
-          continue;
-        }
-      }
+    [[nodiscard]] bool operator()(arena_handle_t const lhs,
+                                  arena_handle_t const rhs) const {
+      return (*nodes)[lhs].board < (*nodes)[rhs].board;
+    }
 
-      // We do not want to pop the last frame with RETURN_VALUE since that
-      // would also remove the last node from the path and we would be unable
-      // to return the minimum.
-      if(stack.size() > 1) {
-        RETURN_VALUE(min);
-      } else {
-        statistics.result = min;
-        return statistics;
-      }
+    [[nodiscard]] bool operator()(arena_handle_t const lhs,
+                                  u64 const rhs) const {
+      return (*nodes)[lhs].board < rhs;
     }
 
-    __builtin_unreachable();
-  }
+    [[nodiscard]] bool operator()(u64 const lhs,
+                                  arena_handle_t const rhs) const {
+      return lhs < (*nodes)[rhs].board;
+    }
+  };
 
-  Solution IDAstar_solver(IDAstar_Parameters const p) {
-    i32 f_cutoff = p.initial_f_cutoff;
-    if(f_cutoff <= 0) {
-      f_cutoff = p.heuristic(p.starting_configuration);
+  struct Search_Node_Priority {
+    Arena<Search_Node> const* nodes;
+
+    [[nodiscard]] Open_List_Priority
+    operator()(arena_handle_t const handle) const {
+      Search_Node const& node = (*nodes)[handle];
+      return Open_List_Priority{.f = node.g + node.f, .g = node.g};
     }
-    // Cap max iterations at 1 million if not provided.
-    i32 const max_iterations =
-      p.max_iterations > 0 ? p.max_iterations : (1 << 20);
-    Solution solution;
-    solution.iterations = max_iterations;
-    Configuration const configuration =
-      copy_configuration(p.starting_configuration);
-    for(i32 i = 0; i < max_iterations; i += 1) {
-      IDAstar_Result const statistics =
-        IDAstar_search(configuration, p.heuristic, f_cutoff);
-      DEBUG_PRINT(
-        "IDA* i %d; f_cutoff %d; result %d; depth %lld; explored "
-        "%lld\n",
-        i, f_cutoff, statistics.result, statistics.depth, statistics.explored);
-      if(statistics.result == FOUND) {
-        solution.found = true;
-        solution.iterations = i;
-        solution.explored = statistics.explored;
-        solution.depth = statistics.depth;
-        solution.path = std::move(statistics.path);
-        break;
-      } else {
-        f_cutoff = statistics.result;
-      }
+  };
+
+  struct Heap_Open_List {
+    private:
+    Heap<arena_handle_t, Search_Node_Compare, Search_Node_Compare_ID> heap;
+    Arena<Search_Node> const* nodes;
+
+    public:
+    explicit Heap_Open_List(Arena<Search_Node> const& nodes)
+      : heap(Search_Node_Compare{&nodes}, Search_Node_Compare_ID{&nodes}),
+        nodes(&nodes) {}
+
+    void insert(arena_handle_t const handle) {
+      heap.insert(handle);
     }
-    return solution;
-  }
 
-  Solution Astar_solver(Astar_Parameters const p) {
-    struct Node {
-      Configuration configuration;
-      Node* parent = nullptr;
-      u64 id = 0;
-      // Value of the path cost function.
-      i32 g = 0;
-      // Value of the heuristic function.
-      i32 f = 0;
-    };
+    [[nodiscard]] arena_handle_t extract() {
+      return heap.extract();
+    }
 
-    auto compare_priority = [](Node const* lhs, Node const* rhs) {
-      bool const less = (lhs->g + lhs->f) < (rhs->g + rhs->f);
-      bool const equal = (lhs->g + lhs->f) == (rhs->g + rhs->f);
-      return less || (equal && lhs->f < rhs->f);
-    };
+    void decrease(arena_handle_t const handle) {
+      heap.decrease(heap.find((*nodes)[handle].board));
+    }
 
-    struct Compare_ID {
-      [[nodiscard]] bool operator()(Node const* lhs, Node const* rhs) {
-        return lhs->id < rhs->id;
-      }
+    [[nodiscard]] i64 size() const {
+      return heap.size();
+    }
+  };
 
-      [[nodiscard]] bool operator()(Node const* lhs, u64 const rhs) {
-        return lhs->id < rhs;
-      }
+  struct Buckets_Open_List
+    : Bucket_Open_List<arena_handle_t, Search_Node_Priority> {
+    explicit Buckets_Open_List(Arena<Search_Node> const& nodes)
+      : Bucket_Open_List(Search_Node_Priority{&nodes}) {}
+  };
 
-      [[nodiscard]] bool operator()(u64 const lhs, Node const* rhs) {
-        return lhs < rhs->id;
+  // expand_successor
+  // Record the successor state reached from the node parent in the closed set
+  // and the open list or lower the cost of the already known node.
+  //
+  // Returns:
+  // Handle to the successor node if it has been created by the call,
+  // null_arena_handle otherwise.
+  //
+  template<typename Open_List>
+  [[nodiscard]] static arena_handle_t
+  expand_successor(Arena<Search_Node>& nodes,
+                   Hash_Table<arena_handle_t>& closed, Open_List& open,
+                   arena_handle_t const parent, State const state) {
+    i32 const new_g = nodes[parent].g + 1;
+    auto const [slot, inserted] = closed.insert(state.board, null_arena_handle);
+    if(!inserted) {
+      arena_handle_t const handle = *slot;
+      Search_Node& successor = nodes[handle];
+      if(new_g < successor.g) {
+        successor.parent = parent;
+        successor.g = new_g;
+        // Only possible with an inconsistent heuristic.
+        if(successor.closed) {
+          successor.closed = false;
+          open.insert(handle);
+        } else {
+          open.decrease(handle);
+        }
       }
-    };
+      return null_arena_handle;
+    }
+
+    arena_handle_t const handle = nodes.allocate();
+    *slot = handle;
+    Search_Node& successor = nodes[handle];
+    successor.parent = parent;
+    successor.board = state.board;
+    successor.empty = state.empty;
+    successor.g = new_g;
+    return handle;
+  }
+
+  template<typename Open_List>
+  [[nodiscard]] static Solution Astar_search(Astar_Parameters const& p) {
+    using Node = Search_Node;
 
-    using heap_t = Heap<Node*, decltype(compare_priority), Compare_ID>;
-    using heap_iterator = heap_t::iterator;
-    heap_t frontier(compare_priority, Compare_ID{});
+    TRACE(p.trace, begin("A*"));
+    Arena<Node> nodes;
+    Open_List frontier(nodes);
     // Populate frontier with the starting node.
     {
-      Node* const node = new Node();
-      node->configuration = copy_configuration(p.starting_configuration);
-      node->id = hash_configuration(node->configuration);
-      // There's no need to calculate the f value since the starting node is
-      // the only one in the frontier and will be removed from it in the first
-      // iteration.
-      frontier.insert(node);
-    }
-
-    // Random number of buckets.
-    std::map<u64, Node*> expanded;
-    // expanded.max_load_factor(0.7f);
+      State const state = pack_configuration(p.starting_configuration);
+      arena_handle_t const handle = nodes.allocate();
+      Node& node = nodes[handle];
+      node.board = state.board;
+      node.empty = state.empty;
+      // The starting node is the only one in the frontier and will be removed
+      // from it in the first iteration, hence the f value is only needed as
+      // the base for the incremental evaluation.
+      if(p.heuristic_delta != nullptr) {
+        node.f = p.heuristic(state.board);
+      }
+      frontier.insert(handle);
+    }
+
+    // Every generated node is recorded in expanded, hence a lookup tells us
+    // whether a configuration is either in the frontier or already expanded.
+    Hash_Table<arena_handle_t> expanded;
     Solution solution;
     while(frontier.size() > 0) {
-      Node* const node = frontier.extract();
-      if(node->g > solution.depth) {
-        solution.depth = node->g;
+      arena_handle_t const node_handle = frontier.extract();
+      // Arena chunks never move, so the reference stays valid as we allocate
+      // the successors.
+      Node& node = nodes[node_handle];
+      node.closed = true;
+      TRACE(p.trace, expand(node.g, [&] {
+              return Trace_Sample{.open = frontier.size(),
+                                  .closed = expanded.size(),
+                                  .bytes = nodes.statistics().bytes +
+                                           expanded.statistics().bytes};
+            }));
+      if(node.g > solution.depth) {
+        solution.depth = node.g;
         DEBUG_PRINT("A* depth %lld, explored %lld, %lld frontier\n",
                     solution.depth, (i64)expanded.size(), (i64)frontier.size());
       }
 
-      if(node->id == goal_configuration_hash) {
+      if(node.board == goal_state.board) {
         solution.found = true;
-        Node* path_node = node;
-        while(path_node != nullptr) {
-          solution.path.push_back(std::move(path_node->configuration));
-          path_node = path_node->parent;
-        }
+        reconstruct_path(solution.path, nodes, node_handle);
         std::reverse(solution.path.begin(), solution.path.end());
         break;
       }
 
-      for(i32 i = 0; i < 4; i += 1) {
-        std::optional<Configuration> result =
-          generate_successor(node->configuration, i);
-        if(!result) {
-          continue;
-        }
-
-        Configuration& configuration = result.value();
-        u64 const new_id = hash_configuration(configuration);
-        i32 const new_g = node->g + 1;
-
-        {
-          heap_iterator const i = frontier.find(new_id);
-          if(i != frontier.end()) {
-            if(new_g < i->g) {
-              i->parent = node;
-              i->g = new_g;
-              frontier.decrease(i);
-            }
-            continue;
+      for(i32 const target: Puzzle::moves(node.empty)) {
+        State const state = move_empty(State{node.board, node.empty}, target);
+        arena_handle_t const successor_handle =
+          expand_successor(nodes, expanded, frontier, node_handle, state);
+        TRACE(p.trace, generate(successor_handle == null_arena_handle));
+        if(successor_handle != null_arena_handle) {
+          Node& successor = nodes[successor_handle];
+          if(p.heuristic_delta != nullptr) {
+            successor.f =
+              node.f + TRACE_HEURISTIC(p.trace,
+                                       p.heuristic_delta(node.board, target,
+                                                         node.empty));
+          } else {
+            successor.f = TRACE_HEURISTIC(p.trace, p.heuristic(state.board));
           }
-        }
-
-        auto const iterator = expanded.find(new_id);
-        bool const in_expanded = iterator != expanded.end();
-        if(!in_expanded) {
-          Node* const successor = new Node();
-          successor->parent = node;
-          successor->configuration = std::move(configuration);
-          successor->id = new_id;
-          successor->g = new_g;
-          successor->f = p.heuristic(successor->configuration);
-          expanded.emplace(successor->id, successor);
-          frontier.insert(successor);
+          frontier.insert(successor_handle);
         }
       }
     }
 
     solution.explored = expanded.size();
-
-    // TODO: Free all nodes. Use a bump allocator and scratch all memory.
-    for(auto [_, node]: expanded) {
-      delete node;
-    }
-
+    solution.closed_set = expanded.statistics();
+    solution.arena = nodes.statistics();
+    TRACE(p.trace, end());
     return solution;
   }
 
-  Solution Bidirectional_Astar_solver(Bidirectional_Astar_Parameters const p) {
-    struct Node {
-      Configuration configuration;
-      Node* parent = nullptr;
-      u64 id = 0;
-      // Value of the path cost function.
-      i32 g = 0;
-      // Value of the heuristic function.
-      i32 f = 0;
-    };
-
-    auto compare_priority = [](Node const* lhs, Node const* rhs) {
-      bool const less = (lhs->g + lhs->f) < (rhs->g + rhs->f);
-      bool const equal = (lhs->g + lhs->f) == (rhs->g + rhs->f);
-      return less || (equal && lhs->f < rhs->f);
-    };
-
-    struct Compare_ID {
-      [[nodiscard]] bool operator()(Node const* lhs, Node const* rhs) {
-        return lhs->id < rhs->id;
-      }
-
-      [[nodiscard]] bool operator()(Node const* lhs, u64 const rhs) {
-        return lhs->id < rhs;
-      }
+  Solution Astar_solver(Astar_Parameters const p) {
+    switch(p.open_list) {
+      case Open_List_Kind::heap:
+        return Astar_search<Heap_Open_List>(p);
+      case Open_List_Kind::buckets:
+        return Astar_search<Buckets_Open_List>(p);
+    }
+    __builtin_unreachable();
+  }
 
-      [[nodiscard]] bool operator()(u64 const lhs, Node const* rhs) {
-        return lhs < rhs->id;
-      }
-    };
+  template<typename Open_List>
+  [[nodiscard]] static Solution
+  Bidirectional_Astar_search(Bidirectional_Astar_Parameters const& p) {
+    using Node = Search_Node;
 
-    Configuration const start_configuration =
-      copy_configuration(p.starting_configuration);
-    u64 const start_configuration_hash =
-      hash_configuration(p.starting_configuration);
+    TRACE(p.trace, begin("BA*"));
+    // Both searches allocate from the same arena.
+    Arena<Node> nodes;
+    State const start_state = pack_configuration(p.starting_configuration);
 
-    using heap_t = Heap<Node*, decltype(compare_priority), Compare_ID>;
-    using heap_iterator = heap_t::iterator;
-    heap_t forward_frontier(compare_priority, Compare_ID{});
-    heap_t backward_frontier(compare_priority, Compare_ID{});
+    Open_List forward_frontier(nodes);
+    Open_List backward_frontier(nodes);
     // Populate forward_frontier with the starting node.
     {
-      Node* const node = new Node();
-      node->configuration = start_configuration;
-      node->id = start_configuration_hash;
+      arena_handle_t const handle = nodes.allocate();
+      Node& node = nodes[handle];
+      node.board = start_state.board;
+      node.empty = start_state.empty;
       // There's no need to calculate the f value since the starting node is the
       // only one in the forward_frontier and will be removed from it in the
       // first iteration.
-      forward_frontier.insert(node);
+      forward_frontier.insert(handle);
     }
     // Populate backward_frontier with the goal (starting) node.
     {
-      Node* const node = new Node();
-      node->configuration = goal_configuration;
-      node->id = goal_configuration_hash;
+      arena_handle_t const handle = nodes.allocate();
+      Node& node = nodes[handle];
+      node.board = goal_state.board;
+      node.empty = goal_state.empty;
       // There's no need to calculate the f value since the starting node is the
       // only one in the backward_frontier and will be removed from it in the
       // first iteration.
-      backward_frontier.insert(node);
+      backward_frontier.insert(handle);
     }
 
-    // Random number of buckets.
-    std::map<u64, Node*> forward_expanded;
-    std::map<u64, Node*> backward_expanded;
+    // The backward search heads towards the starting configuration.
+    Goal_Remap const start_remap = make_goal_remap(start_state.board);
+    Hash_Table<arena_handle_t> forward_expanded;
+    Hash_Table<arena_handle_t> backward_expanded;
+    // Both searches are sampled together.
+    auto const snapshot = [&] {
+      return Trace_Sample{
+        .open = forward_frontier.size() + backward_frontier.size(),
+        .closed = forward_expanded.size() + backward_expanded.size(),
+        .bytes = nodes.statistics().bytes +
+                 forward_expanded.statistics().bytes +
+                 backward_expanded.statistics().bytes};
+    };
     Solution solution;
     bool forward = false;
     i64 counter = 0;
@@ -468,174 +806,103 @@ namespace puzzle15 {
       counter += 1;
 
       if(forward) {
-        Node* const node = forward_frontier.extract();
-        // printf("Exploring forward configuration, g = %d, f = %d\n", node->g,
-        //        node->f);
-        // print(node->configuration);
-        if(node->g > forward_depth) {
-          forward_depth = node->g;
+        arena_handle_t const node_handle = forward_frontier.extract();
+        Node& node = nodes[node_handle];
+        node.closed = true;
+        TRACE(p.trace, expand(node.g, snapshot));
+        if(node.g > forward_depth) {
+          forward_depth = node.g;
           DEBUG_PRINT(
             "A* forward depth %d, explored %lld, %lld forward_frontier\n",
             forward_depth, (i64)forward_expanded.size(),
             (i64)forward_frontier.size());
         }
 
-        if(node->id == goal_configuration_hash) {
+        if(node.board == goal_state.board) {
           solution.found = true;
-          Node* path_node = node;
-          while(path_node != nullptr) {
-            solution.path.push_back(std::move(path_node->configuration));
-            path_node = path_node->parent;
-          }
+          reconstruct_path(solution.path, nodes, node_handle);
           std::reverse(solution.path.begin(), solution.path.end());
           break;
         }
 
-        for(i32 i = 0; i < 4; i += 1) {
-          std::optional<Configuration> result =
-            generate_successor(node->configuration, i);
-          if(!result) {
+        for(i32 const target: Puzzle::moves(node.empty)) {
+          State const state =
+            move_empty(State{node.board, node.empty}, target);
+          arena_handle_t const successor_handle = expand_successor(
+            nodes, forward_expanded, forward_frontier, node_handle, state);
+          TRACE(p.trace, generate(successor_handle == null_arena_handle));
+          if(successor_handle == null_arena_handle) {
             continue;
           }
 
-          Configuration& configuration = result.value();
-          u64 const new_id = hash_configuration(configuration);
-          i32 const new_g = node->g + 1;
-
-          {
-            heap_iterator const i = forward_frontier.find(new_id);
-            if(i != forward_frontier.end()) {
-              if(new_g < i->g) {
-                i->parent = node;
-                i->g = new_g;
-                forward_frontier.decrease(i);
-              }
-              continue;
-            }
+          arena_handle_t const* const meeting =
+            backward_expanded.find(state.board);
+          // Check whether we have met the opposide side search.
+          if(meeting != nullptr) {
+            solution.found = true;
+            // Reconstruct the solution by joining the forward and backward
+            // parts. The forward part is reconstructed in reverse, while the
+            // backward part in the correct order.
+            reconstruct_path(solution.path, nodes, node_handle);
+            std::reverse(solution.path.begin(), solution.path.end());
+            reconstruct_path(solution.path, nodes, *meeting);
+            break;
           }
 
-          auto const forward_iterator = forward_expanded.find(new_id);
-          bool const in_expanded = forward_iterator != forward_expanded.end();
-          if(!in_expanded) {
-            auto const iterator = backward_expanded.find(new_id);
-            // Check whether we have met the opposide side search.
-            if(iterator != backward_expanded.end()) {
-              solution.found = true;
-              // Reconstruct the solution by joining the forward and backward
-              // parts. The forward part is reconstructed in reverse, while the
-              // backward part in the correct order.
-              Node* forward_node = node;
-              while(forward_node != nullptr) {
-                solution.path.push_back(std::move(forward_node->configuration));
-                forward_node = forward_node->parent;
-              }
-              std::reverse(solution.path.begin(), solution.path.end());
-
-              Node* backward_node = iterator->second;
-              while(backward_node != nullptr) {
-                solution.path.push_back(
-                  std::move(backward_node->configuration));
-                backward_node = backward_node->parent;
-              }
-              break;
-            }
-
-            Node* const successor = new Node();
-            successor->parent = node;
-            successor->configuration = std::move(configuration);
-            successor->id = new_id;
-            successor->g = new_g;
-            successor->f = p.forward_heuristic(successor->configuration);
-            forward_expanded.emplace(successor->id, successor);
-            forward_frontier.insert(successor);
-          }
+          nodes[successor_handle].f =
+            TRACE_HEURISTIC(p.trace, p.forward_heuristic(state.board));
+          forward_frontier.insert(successor_handle);
         }
 
         if(solution.found) {
           break;
         }
       } else {
-        Node* const node = backward_frontier.extract();
-        // printf("Exploring backward configuration, g = %d, f = %d\n", node->g,
-        //        node->f);
-        // print(node->configuration);
-        if(node->g > backward_depth) {
-          backward_depth = node->g;
+        arena_handle_t const node_handle = backward_frontier.extract();
+        Node& node = nodes[node_handle];
+        node.closed = true;
+        TRACE(p.trace, expand(node.g, snapshot));
+        if(node.g > backward_depth) {
+          backward_depth = node.g;
           DEBUG_PRINT(
             "A* backward depth %d, explored %lld, %lld backward_frontier\n",
             backward_depth, (i64)backward_expanded.size(),
             (i64)backward_frontier.size());
         }
 
-        if(node->id == start_configuration_hash) {
+        if(node.board == start_state.board) {
           solution.found = true;
-          Node* path_node = node;
-          while(path_node != nullptr) {
-            solution.path.push_back(std::move(path_node->configuration));
-            path_node = path_node->parent;
-          }
+          reconstruct_path(solution.path, nodes, node_handle);
           break;
         }
 
-        for(i32 i = 0; i < 4; i += 1) {
-          std::optional<Configuration> result =
-            generate_successor(node->configuration, i);
-          if(!result) {
+        for(i32 const target: Puzzle::moves(node.empty)) {
+          State const state =
+            move_empty(State{node.board, node.empty}, target);
+          arena_handle_t const successor_handle = expand_successor(
+            nodes, backward_expanded, backward_frontier, node_handle, state);
+          TRACE(p.trace, generate(successor_handle == null_arena_handle));
+          if(successor_handle == null_arena_handle) {
             continue;
           }
 
-          Configuration& configuration = result.value();
-          u64 const new_id = hash_configuration(configuration);
-          i32 const new_g = node->g + 1;
-
-          {
-            heap_iterator const i = backward_frontier.find(new_id);
-            if(i != backward_frontier.end()) {
-              if(new_g < i->g) {
-                i->parent = node;
-                i->g = new_g;
-                backward_frontier.decrease(i);
-              }
-              continue;
-            }
+          arena_handle_t const* const meeting =
+            forward_expanded.find(state.board);
+          // Check whether we have met the opposide side search.
+          if(meeting != nullptr) {
+            solution.found = true;
+            // Reconstruct the solution by joining the forward and backward
+            // parts. The forward part is reconstructed in reverse, while the
+            // backward part in the correct order.
+            reconstruct_path(solution.path, nodes, *meeting);
+            std::reverse(solution.path.begin(), solution.path.end());
+            reconstruct_path(solution.path, nodes, node_handle);
+            break;
           }
 
-          auto const backward_iterator = backward_expanded.find(new_id);
-          bool const in_expanded = backward_iterator != backward_expanded.end();
-          if(!in_expanded) {
-            auto const iterator = forward_expanded.find(new_id);
-            // Check whether we have met the opposide side search.
-            if(iterator != forward_expanded.end()) {
-              solution.found = true;
-              // Reconstruct the solution by joining the forward and backward
-              // parts. The forward part is reconstructed in reverse, while the
-              // backward part in the correct order.
-              Node* forward_node = iterator->second;
-              while(forward_node != nullptr) {
-                solution.path.push_back(std::move(forward_node->configuration));
-                forward_node = forward_node->parent;
-              }
-              std::reverse(solution.path.begin(), solution.path.end());
-
-              Node* backward_node = node;
-              while(backward_node != nullptr) {
-                solution.path.push_back(
-                  std::move(backward_node->configuration));
-                backward_node = backward_node->parent;
-              }
-              break;
-            }
-
-            Node* const successor = new Node();
-            successor->parent = node;
-            successor->configuration = std::move(configuration);
-            successor->id = new_id;
-            successor->g = new_g;
-            successor->f = p.backward_heuristic(successor->configuration,
-                                                start_configuration);
-            backward_expanded.emplace(successor->id, successor);
-            backward_frontier.insert(successor);
-          }
+          nodes[successor_handle].f = TRACE_HEURISTIC(
+            p.trace, p.backward_heuristic(state.board, start_remap));
+          backward_frontier.insert(successor_handle);
         }
 
         if(solution.found) {
@@ -647,12 +914,575 @@ namespace puzzle15 {
     solution.explored = forward_expanded.size() + backward_expanded.size();
     solution.depth =
       forward_depth > backward_depth ? forward_depth : backward_depth;
+    solution.closed_set = forward_expanded.statistics();
+    solution.closed_set.accumulate(backward_expanded.statistics());
+    solution.arena = nodes.statistics();
+    TRACE(p.trace, end());
+    return solution;
+  }
+
+  Solution Bidirectional_Astar_solver(Bidirectional_Astar_Parameters const p) {
+    switch(p.open_list) {
+      case Open_List_Kind::heap:
+        return Bidirectional_Astar_search<Heap_Open_List>(p);
+      case Open_List_Kind::buckets:
+        return Bidirectional_Astar_search<Buckets_Open_List>(p);
+    }
+    __builtin_unreachable();
+  }
+
+  // Perimeter
+  // Configurations within depth moves of the goal with their exact distances
+  // to the goal. The frontier holds the configurations at exactly depth
+  // moves, every path from the outside to the goal passes through one of
+  // them.
+  //
+  struct Perimeter {
+    Hash_Table<u8> distances;
+    // Prepared as goals of the perimeter heuristic.
+    std::vector<Goal_Remap> frontier;
+    i32 depth = 0;
+  };
+
+  [[nodiscard]] static Perimeter build_perimeter(i32 const depth) {
+    Perimeter perimeter;
+    perimeter.depth = depth;
+    perimeter.distances.insert(goal_state.board, 0);
+    std::vector<State> layer = {goal_state};
+    for(i32 distance = 1; distance <= depth; distance += 1) {
+      std::vector<State> next_layer;
+      for(State const state: layer) {
+        for(i32 const target: Puzzle::moves(state.empty)) {
+          State const successor = move_empty(state, target);
+          if(perimeter.distances.insert(successor.board, distance).inserted) {
+            next_layer.push_back(successor);
+          }
+        }
+      }
+      layer = std::move(next_layer);
+    }
+
+    perimeter.frontier.reserve(layer.size());
+    for(State const state: layer) {
+      perimeter.frontier.push_back(make_goal_remap(state.board));
+    }
+    return perimeter;
+  }
+
+  struct Perimeter_Search {
+    Perimeter& perimeter;
+    heuristic_t heuristic;
+    heuristic_delta_t heuristic_delta;
+    generic_heuristic_t perimeter_heuristic;
+    std::vector<State> path;
+    // Frontier configuration which bounded the last evaluation. Neighbouring
+    // configurations tend to be close to the same frontier configuration,
+    // hence the next evaluation starts from it.
+    i64 last_closest = 0;
+    i64 depth = 0;
+    i64 explored = 0;
+    i32 f_cutoff = 0;
+  };
+
+  // perimeter_bound
+  // Lower bound of the distance to the goal of a configuration outside of the
+  // perimeter.
+  //
+  // Parameters:
+  // h - value of the heuristic function towards the goal.
+  // limit - the evaluation stops as soon as the bound is known not to exceed
+  //         limit. The bound is exact if it exceeds limit.
+  //
+  [[nodiscard]] static i32 perimeter_bound(Perimeter_Search& search,
+                                           u64 const board, i32 const h,
+                                           i32 const limit) {
+    Perimeter const& perimeter = search.perimeter;
+    // The configuration is further than the perimeter depth, otherwise it
+    // would be in the perimeter.
+    i32 const bound = std::max(h, perimeter.depth + 1);
+    if(bound > limit) {
+      return bound;
+    }
+
+    // The front-to-front estimate costs an evaluation per frontier
+    // configuration, hence it is evaluated only when the cheap bounds do not
+    // suffice.
+    i64 const count = perimeter.frontier.size();
+    i32 closest = i32_largest_value;
+    for(i64 i = 0, index = search.last_closest; i < count; i += 1) {
+      i32 const value =
+        search.perimeter_heuristic(board, perimeter.frontier[index]);
+      if(value < closest) {
+        closest = value;
+        search.last_closest = index;
+        if(closest + perimeter.depth <= limit) {
+          break;
+        }
+      }
+
+      index += 1;
+      if(index == count) {
+        index = 0;
+      }
+    }
+    return std::max(bound, closest + perimeter.depth);
+  }
 
-    // TODO: Free all nodes. Use a bump allocator and scratch all memory.
-    for(auto [_, node]: forward_expanded) {
-      delete node;
+  // perimeter_search
+  // Depth first search of the subtree rooted at the last configuration of
+  // the search path bounded by f_cutoff.
+  //
+  // Parameters:
+  // g - cost of the search path.
+  // h - value of the heuristic function towards the goal at the root of the
+  //     subtree. Only used when heuristic_delta is not nullptr.
+  //
+  // Returns:
+  // FOUND or the smallest f value exceeding f_cutoff.
+  //
+  [[nodiscard]] static i32 perimeter_search(Perimeter_Search& search,
+                                            i32 const g, i32 const h) {
+    search.explored += 1;
+    if((i64)search.path.size() > search.depth) {
+      search.depth = search.path.size();
     }
 
+    i32 min = i32_largest_value;
+    State const state = search.path.back();
+    i64 const size = search.path.size();
+    i32 const parent_empty = size > 1 ? search.path[size - 2].empty : -1;
+    for(i32 const target: Puzzle::moves(state.empty)) {
+      // Moving the tile back only leads to the configuration we came from.
+      if(target == parent_empty) {
+        continue;
+      }
+
+      State const successor = move_empty(state, target);
+
+      i32 f_value = 0;
+      u8 const* const distance =
+        search.perimeter.distances.find(successor.board);
+      if(distance != nullptr) {
+        // Within the perimeter the distance is exact.
+        f_value = g + 1 + *distance;
+        if(f_value <= search.f_cutoff) {
+          search.path.push_back(successor);
+          return FOUND;
+        }
+      } else {
+        i32 const successor_h =
+          search.heuristic_delta != nullptr
+            ? h + search.heuristic_delta(state.board, target, state.empty)
+            : search.heuristic(successor.board);
+        f_value = g + 1 +
+                  perimeter_bound(search, successor.board, successor_h,
+                                  search.f_cutoff - g - 1);
+        if(f_value <= search.f_cutoff) {
+          search.path.push_back(successor);
+          f_value = perimeter_search(search, g + 1, successor_h);
+          if(f_value == FOUND) {
+            return FOUND;
+          }
+          search.path.pop_back();
+        }
+      }
+
+      if(f_value < min) {
+        min = f_value;
+      }
+    }
+    return min;
+  }
+
+  Solution
+  Perimeter_IDAstar_solver(Perimeter_IDAstar_Parameters const p) {
+    i32 const depth =
+      p.perimeter_depth > 0 ? p.perimeter_depth : perimeter_default_depth;
+    Perimeter perimeter = build_perimeter(depth);
+    State const start_state = pack_configuration(p.starting_configuration);
+    Perimeter_Search search = {.perimeter = perimeter,
+                               .heuristic = p.heuristic,
+                               .heuristic_delta = p.heuristic_delta,
+                               .perimeter_heuristic = p.perimeter_heuristic,
+                               .path = {start_state}};
+
+    Solution solution;
+    solution.perimeter = perimeter.distances.size();
+    bool found = perimeter.distances.find(start_state.board) != nullptr;
+    i32 const h_value = p.heuristic(start_state.board);
+    if(!found) {
+      search.f_cutoff =
+        perimeter_bound(search, start_state.board, h_value, -1);
+    }
+    // Cap max iterations at 1 million.
+    i32 const max_iterations = 1 << 20;
+    solution.iterations = max_iterations;
+    for(i32 i = 0; i < max_iterations && !found; i += 1) {
+      i32 const result = perimeter_search(search, 0, h_value);
+      DEBUG_PRINT("PIDA* i %d; f_cutoff %d; result %d; explored %lld\n", i,
+                  search.f_cutoff, result, search.explored);
+      if(result == FOUND) {
+        found = true;
+        solution.iterations = i;
+      } else {
+        search.f_cutoff = result;
+      }
+    }
+
+    solution.explored = search.explored;
+    solution.depth = search.depth;
+    if(!found) {
+      return solution;
+    }
+
+    // Walk down the perimeter distances from where the search entered the
+    // perimeter.
+    State state = search.path.back();
+    i32 distance = *perimeter.distances.find(state.board);
+    while(distance > 0) {
+      for(i32 const target: Puzzle::moves(state.empty)) {
+        State const successor = move_empty(state, target);
+        u8 const* const d = perimeter.distances.find(successor.board);
+        if(d != nullptr && *d == distance - 1) {
+          state = successor;
+          break;
+        }
+      }
+      search.path.push_back(state);
+      distance -= 1;
+    }
+
+    solution.found = true;
+    for(State const s: search.path) {
+      solution.path.push_back(unpack_board(s.board));
+    }
+    return solution;
+  }
+
+  // SMA_Node
+  // Node of the SMA* search tree. Children are indexed by the direction of
+  // the move that generated them (see successor_target).
+  //
+  struct SMA_Node {
+    u64 board = 0;
+    u32 parent = u32_largest_value;
+    u32 children[4] = {u32_largest_value, u32_largest_value,
+                       u32_largest_value, u32_largest_value};
+    // Backed up f values of the forgotten children.
+    i16 forgotten_f[4] = {};
+    i16 g = 0;
+    // Backed up value of the evaluation function.
+    i16 f = 0;
+    // Value of the heuristic function.
+    u8 h = 0;
+    u8 empty = 0;
+    // Directions of the children currently in memory.
+    u8 generated = 0;
+    // Directions of the children that have been pruned and must be
+    // regenerated before the subtree is searched again.
+    u8 forgotten = 0;
+  };
+
+  struct SMA_Open_Key {
+    i16 f;
+    i16 g;
+    u32 node;
+
+    // Lowest f first, then the deepest node.
+    [[nodiscard]] bool operator<(SMA_Open_Key const& other) const {
+      if(f != other.f) {
+        return f < other.f;
+      }
+      if(g != other.g) {
+        return g > other.g;
+      }
+      return node < other.node;
+    }
+  };
+
+  Solution SMAstar_solver(SMAstar_Parameters const p) {
+    constexpr u32 null_node = u32_largest_value;
+    constexpr i16 infinity = 0x7FFF;
+    // Estimate of a std::set node holding an SMA_Open_Key: colour, 3 links and
+    // the key. Every node may be in both the open list and the leaves and
+    // needs a slot in the free list.
+    constexpr i64 set_entry_bytes = 4 * sizeof(void*) + sizeof(SMA_Open_Key);
+    constexpr i64 node_bytes =
+      sizeof(SMA_Node) + 2 * set_entry_bytes + sizeof(u32);
+
+    Solution solution;
+    i64 const capacity_limit = p.memory_budget / node_bytes;
+    u32 const capacity = capacity_limit < (i64)null_node ? capacity_limit
+                                                         : null_node - 1;
+    // The root and at least one child.
+    if(capacity < 2) {
+      return solution;
+    }
+
+    // Reserved upfront, but grown only as the search needs more nodes.
+    std::vector<SMA_Node> nodes;
+    nodes.reserve(capacity);
+    // Slots of the forgotten nodes.
+    std::vector<u32> free_nodes;
+    // Leaves and the nodes with children not in memory.
+    std::set<SMA_Open_Key> open;
+    // Nodes without children in memory, the candidates for pruning.
+    std::set<SMA_Open_Key> leaves;
+    i64 resident = 0;
+    auto const allocate_node = [&nodes, &free_nodes] {
+      if(free_nodes.size() > 0) {
+        u32 const n = free_nodes.back();
+        free_nodes.pop_back();
+        return n;
+      }
+
+      nodes.emplace_back();
+      return (u32)(nodes.size() - 1);
+    };
+    auto const key = [&nodes](u32 const n) {
+      return SMA_Open_Key{nodes[n].f, nodes[n].g, n};
+    };
+    auto const update_counters = [&] {
+      if(resident > solution.peak_resident_nodes) {
+        solution.peak_resident_nodes = resident;
+        solution.peak_resident_bytes = resident * node_bytes;
+      }
+      if(p.counters != nullptr) {
+        p.counters->resident_nodes.store(resident, std::memory_order_relaxed);
+        p.counters->resident_bytes.store(resident * node_bytes,
+                                         std::memory_order_relaxed);
+      }
+    };
+    // Directions of the successors of n excluding the move back to its
+    // parent.
+    auto const successor_mask = [&nodes](u32 const n) {
+      SMA_Node const& node = nodes[n];
+      u32 mask = 0;
+      for(i32 d = 0; d < 4; d += 1) {
+        i32 const target = successor_target(node.empty, d);
+        if(target < 0) {
+          continue;
+        }
+
+        State const successor =
+          move_empty(State{node.board, node.empty}, target);
+        if(node.parent != null_node &&
+           nodes[node.parent].board == successor.board) {
+          continue;
+        }
+        mask |= 1u << d;
+      }
+      return mask;
+    };
+    // Whether every successor of n has been generated at least once.
+    auto const is_completed = [&nodes, &successor_mask](u32 const n) {
+      return (nodes[n].generated | nodes[n].forgotten) == successor_mask(n);
+    };
+    auto const is_open = [&nodes, &is_completed](u32 const n) {
+      return nodes[n].forgotten != 0 || !is_completed(n);
+    };
+    // Back up the f value of n from its children and propagate the change
+    // to the ancestors. Only completed nodes are backed up.
+    auto const back_up = [&](u32 n) {
+      while(n != null_node && is_completed(n)) {
+        SMA_Node& node = nodes[n];
+        i16 f = infinity;
+        for(i32 d = 0; d < 4; d += 1) {
+          u32 const c = node.children[d];
+          if(c != null_node && nodes[c].f < f) {
+            f = nodes[c].f;
+          }
+          if((node.forgotten & (1u << d)) && node.forgotten_f[d] < f) {
+            f = node.forgotten_f[d];
+          }
+        }
+        if(f == node.f) {
+          break;
+        }
+
+        bool const open_node = is_open(n);
+        if(open_node) {
+          open.erase(key(n));
+        }
+        node.f = f;
+        if(open_node) {
+          open.insert(key(n));
+        }
+        n = node.parent;
+      }
+    };
+
+    {
+      State const state = pack_configuration(p.starting_configuration);
+      u32 const root = allocate_node();
+      SMA_Node& node = nodes[root];
+      node = SMA_Node{};
+      node.board = state.board;
+      node.empty = state.empty;
+      node.h = p.heuristic(state.board);
+      node.f = node.h;
+      open.insert(key(root));
+      leaves.insert(key(root));
+      resident += 1;
+      update_counters();
+    }
+
+    // Maximum depth of a node such that the path from the root fits in
+    // memory.
+    i32 const max_depth = capacity - 1;
+    while(open.size() > 0) {
+      u32 const best = open.begin()->node;
+      if(nodes[best].f >= infinity) {
+        break;
+      }
+
+      if(nodes[best].board == goal_state.board) {
+        solution.found = true;
+        for(u32 n = best; n != null_node; n = nodes[n].parent) {
+          solution.path.push_back(unpack_board(nodes[n].board));
+        }
+        std::reverse(solution.path.begin(), solution.path.end());
+        break;
+      }
+
+      if(free_nodes.size() == 0 && nodes.size() == capacity) {
+        // Forget the shallowest leaf with the highest f value. Neither best
+        // nor its ancestors are ever chosen, nor the root once all its
+        // children have been forgotten.
+        auto i = leaves.end();
+        u32 worst = null_node;
+        while(i != leaves.begin()) {
+          --i;
+          if(i->node != best && nodes[i->node].parent != null_node) {
+            worst = i->node;
+            break;
+          }
+        }
+
+        // Every node in memory is on the path to best.
+        if(worst == null_node) {
+          break;
+        }
+
+        leaves.erase(i);
+        open.erase(key(worst));
+        u32 const parent = nodes[worst].parent;
+        SMA_Node& parent_node = nodes[parent];
+        if(is_open(parent)) {
+          open.erase(key(parent));
+        }
+        for(i32 d = 0; d < 4; d += 1) {
+          if(parent_node.children[d] == worst) {
+            parent_node.children[d] = null_node;
+            parent_node.generated &= ~(1u << d);
+            parent_node.forgotten |= 1u << d;
+            parent_node.forgotten_f[d] = nodes[worst].f;
+          }
+        }
+        open.insert(key(parent));
+        if(parent_node.generated == 0) {
+          leaves.insert(key(parent));
+        }
+        free_nodes.push_back(worst);
+        resident -= 1;
+        solution.pruned += 1;
+      }
+
+      // Generate the successors not generated yet before regenerating the
+      // forgotten one with the lowest backed up value.
+      SMA_Node& node = nodes[best];
+      u32 const available = successor_mask(best);
+      u32 const remaining =
+        available & ~(u32)(node.generated | node.forgotten);
+      i32 direction = 0;
+      if(remaining != 0) {
+        direction = __builtin_ctz(remaining);
+      } else {
+        i32 lowest_f = infinity + 1;
+        for(i32 d = 0; d < 4; d += 1) {
+          if((node.forgotten & (1u << d)) && node.forgotten_f[d] < lowest_f) {
+            direction = d;
+            lowest_f = node.forgotten_f[d];
+          }
+        }
+      }
+      i32 const target = successor_target(node.empty, direction);
+      State const state = move_empty(State{node.board, node.empty}, target);
+
+      u32 const child = allocate_node();
+      resident += 1;
+      SMA_Node& child_node = nodes[child];
+      child_node = SMA_Node{};
+      child_node.board = state.board;
+      child_node.empty = state.empty;
+      child_node.parent = best;
+      child_node.g = node.g + 1;
+      if(p.heuristic_delta != nullptr) {
+        child_node.h =
+          node.h + p.heuristic_delta(node.board, target, node.empty);
+      } else {
+        child_node.h = p.heuristic(state.board);
+      }
+      // A regenerated child remembers the value backed up before it has
+      // been forgotten.
+      if(state.board != goal_state.board && child_node.g >= max_depth) {
+        child_node.f = infinity;
+      } else {
+        i32 f = child_node.g + child_node.h;
+        if(node.f > f) {
+          f = node.f;
+        }
+        if((node.forgotten & (1u << direction)) &&
+           node.forgotten_f[direction] > f) {
+          f = node.forgotten_f[direction];
+        }
+        child_node.f = f;
+      }
+      solution.explored += 1;
+      if(child_node.g > solution.depth) {
+        solution.depth = child_node.g;
+      }
+      open.insert(key(child));
+      leaves.insert(key(child));
+      update_counters();
+
+      open.erase(key(best));
+      if(node.generated == 0) {
+        leaves.erase(key(best));
+      }
+      node.children[direction] = child;
+      node.generated |= 1u << direction;
+      node.forgotten &= ~(1u << direction);
+      back_up(best);
+      if(is_open(best)) {
+        open.insert(key(best));
+      }
+    }
+
+    if(p.counters != nullptr) {
+      p.counters->resident_nodes.store(0, std::memory_order_relaxed);
+      p.counters->resident_bytes.store(0, std::memory_order_relaxed);
+    }
     return solution;
   }
 } // namespace puzzle15
+
+namespace puzzle8 {
+  bool is_solvable(Configuration_View const c) {
+    return Puzzle::is_solvable(c);
+  }
+
+  Solution IDAstar_solver(IDAstar_Parameters const p) {
+    return sliding_IDAstar_solver<Puzzle>(p);
+  }
+} // namespace puzzle8
+
+namespace puzzle24 {
+  bool is_solvable(Configuration_View const c) {
+    return Puzzle::is_solvable(c);
+  }
+
+  Solution IDAstar_solver(IDAstar_Parameters const p) {
+    return sliding_IDAstar_solver<Puzzle>(p);
+  }
+} // namespace puzzle24
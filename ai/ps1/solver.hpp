@@ -1,45 +1,131 @@
 #pragma once
 
+#include <atomic>
 #include <optional>
 #include <span>
 #include <vector>
 
+#include <arena.hpp>
+#include <hash_table.hpp>
 #include <heuristic.hpp>
+#include <sliding_puzzle.hpp>
+#include <trace.hpp>
+#include <transposition_table.hpp>
 #include <types.hpp>
 
+namespace puzzle8 {
+  [[nodiscard]] bool is_solvable(Configuration_View configuration);
+}
+
 namespace puzzle15 {
   [[nodiscard]] bool is_solvable(Configuration_View configuration);
 }
 
+namespace puzzle24 {
+  [[nodiscard]] bool is_solvable(Configuration_View configuration);
+}
+
 template<typename Configuration>
 struct Solution {
   std::vector<Configuration> path;
   i64 iterations = 0;
   i64 depth = 0;
   i64 explored = 0;
+  // Closed set and node storage statistics. Only populated by the solvers
+  // which maintain a closed set.
+  Hash_Table_Statistics closed_set;
+  Arena_Statistics arena;
+  // Peak memory usage and the number of nodes discarded to stay within the
+  // budget. Only populated by the memory bounded solvers.
+  i64 peak_resident_nodes = 0;
+  i64 peak_resident_bytes = 0;
+  i64 pruned = 0;
+  // Number of configurations within the perimeter. Only populated by the
+  // perimeter search.
+  i64 perimeter = 0;
+  // Only populated by IDA* with a transposition table.
+  Transposition_Table_Statistics transposition_table;
   bool found = false;
 };
 
+namespace puzzle8 {
+  using Solution = Solution<Configuration>;
+}
+
 namespace puzzle15 {
   using Solution = Solution<Configuration>;
 }
 
-struct IDAstar_Parameters {
+namespace puzzle24 {
+  using Solution = Solution<Configuration>;
+}
+
+template<typename Puzzle>
+struct Sliding_IDAstar_Parameters {
   Configuration_View starting_configuration;
-  heuristic_t heuristic;
+  typename Puzzle::heuristic_t heuristic;
+  // Optional incremental version of heuristic. When provided, heuristic is
+  // only evaluated for the starting configuration.
+  typename Puzzle::heuristic_delta_t heuristic_delta = nullptr;
   i32 initial_f_cutoff = 0;
   // Maximum number of deepenings iterations. 0 means unlimited.
   i32 max_iterations = 0;
+  // Number of threads searching each deepening iteration. Values greater than
+  // 1 select the parallel search.
+  i32 threads = 1;
+  // Depth at which the parallel search splits the tree into independent
+  // subtrees. 0 selects IDAstar_default_split_depth.
+  i32 split_depth = 0;
+  // Size of the transposition table shared by the deepening iterations and
+  // the workers in bytes. 0 disables the table. Only the boards packed into
+  // 64 bits support it, the others ignore the size.
+  i64 transposition_table_bytes = 0;
+  // Optional. The parallel search only records the deepening iterations.
+  Search_Trace* trace = nullptr;
 };
 
+constexpr i32 IDAstar_default_split_depth = 12;
+
+using IDAstar_Parameters = Sliding_IDAstar_Parameters<puzzle15::Puzzle>;
+
+namespace puzzle8 {
+  using IDAstar_Parameters = Sliding_IDAstar_Parameters<Puzzle>;
+
+  // Empty square is the one with the largest value.
+  [[nodiscard]] Solution IDAstar_solver(IDAstar_Parameters parameters);
+} // namespace puzzle8
+
 namespace puzzle15 {
   // Empty square is the one with the largest value.
   [[nodiscard]] Solution IDAstar_solver(IDAstar_Parameters parameters);
 } // namespace puzzle15
 
+namespace puzzle24 {
+  using IDAstar_Parameters = Sliding_IDAstar_Parameters<Puzzle>;
+
+  // Empty square is the one with the largest value.
+  [[nodiscard]] Solution IDAstar_solver(IDAstar_Parameters parameters);
+} // namespace puzzle24
+
+// Open_List_Kind
+// Data structure of the open list of the A* solvers.
+//
+enum struct Open_List_Kind {
+  // Binary heap with a search tree for decrease-key (heap.hpp).
+  heap,
+  // Array of LIFO stacks indexed by f and g (bucket_open_list.hpp).
+  buckets,
+};
+
 struct Astar_Parameters {
   Configuration_View starting_configuration;
   heuristic_t heuristic;
+  // Optional incremental version of heuristic. When provided, heuristic is
+  // only evaluated for the starting configuration.
+  heuristic_delta_t heuristic_delta = nullptr;
+  Open_List_Kind open_list = Open_List_Kind::buckets;
+  // Optional.
+  Search_Trace* trace = nullptr;
 };
 
 namespace puzzle15 {
@@ -51,10 +137,78 @@ struct Bidirectional_Astar_Parameters {
   Configuration_View starting_configuration;
   heuristic_t forward_heuristic;
   generic_heuristic_t backward_heuristic;
+  Open_List_Kind open_list = Open_List_Kind::buckets;
+  // Optional.
+  Search_Trace* trace = nullptr;
 };
 
 namespace puzzle15 {
   // Empty square is denoted by 16.
   [[nodiscard]] Solution
   Bidirectional_Astar_solver(Bidirectional_Astar_Parameters parameters);
-} // namespace puzzle15
\ No newline at end of file
+} // namespace puzzle15
+
+struct Perimeter_IDAstar_Parameters {
+  Configuration_View starting_configuration;
+  heuristic_t heuristic;
+  // Optional incremental version of heuristic. When provided, heuristic is
+  // only evaluated for the starting configuration.
+  heuristic_delta_t heuristic_delta = nullptr;
+  // Heuristic towards the configurations on the perimeter.
+  generic_heuristic_t perimeter_heuristic;
+  // Number of moves from the goal covered by the perimeter. 0 selects
+  // perimeter_default_depth.
+  i32 perimeter_depth = 0;
+};
+
+constexpr i32 perimeter_default_depth = 2;
+// The perimeter grows roughly 2.1 times with every move.
+constexpr i32 perimeter_max_depth = 16;
+
+namespace puzzle15 {
+  // Perimeter_IDAstar_solver
+  // Perimeter search. A breadth-first search from the goal records the exact
+  // distance of every configuration within perimeter_depth moves. IDA* from
+  // the starting configuration then stops as soon as it enters the
+  // perimeter and estimates the distance of the configurations outside by the
+  // closest configuration on the edge of the perimeter, which every path to
+  // the goal has to cross.
+  //
+  [[nodiscard]] Solution
+  Perimeter_IDAstar_solver(Perimeter_IDAstar_Parameters parameters);
+} // namespace puzzle15
+
+// Memory_Counters
+// Memory currently held by a running solver. Updated as the search
+// progresses, hence may be read concurrently, e.g. to monitor several solvers
+// sharing a host.
+//
+struct Memory_Counters {
+  std::atomic<i64> resident_nodes = 0;
+  std::atomic<i64> resident_bytes = 0;
+};
+
+struct SMAstar_Parameters {
+  Configuration_View starting_configuration;
+  heuristic_t heuristic;
+  // Optional incremental version of heuristic. When provided, heuristic is
+  // only evaluated for the starting configuration.
+  heuristic_delta_t heuristic_delta = nullptr;
+  // Upper bound of the memory used by the search tree and the open list in
+  // bytes.
+  i64 memory_budget = 0;
+  // Optional.
+  Memory_Counters* counters = nullptr;
+};
+
+namespace puzzle15 {
+  // SMAstar_solver
+  // Simplified Memory-bounded A*. Once the budget is exhausted, the search
+  // forgets the shallowest leaf with the highest f value to make room for new
+  // nodes. The f values of fully expanded nodes are backed up from their
+  // children, hence the forgotten subtrees are regenerated only once the rest
+  // of the tree looks worse. The solution is optimal if the budget fits the
+  // nodes of the solution path, otherwise the search reports failure.
+  //
+  [[nodiscard]] Solution SMAstar_solver(SMAstar_Parameters parameters);
+} // namespace puzzle15
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <types.hpp>
+
+// Work_Stealing_Pool
+// Fixed size pool of threads executing batches of independent tasks. Each
+// worker owns a deque of task indices. A worker takes tasks from the back of
+// its own deque and, once it runs dry, steals from the front of the deques of
+// the other workers. The calling thread participates in run as worker 0.
+//
+struct Work_Stealing_Pool {
+  private:
+  struct Worker_Queue {
+    std::mutex mutex;
+    std::deque<i64> tasks;
+  };
+
+  std::vector<std::thread> threads;
+  std::unique_ptr<Worker_Queue[]> queues;
+  std::function<void(i32, i64)> job;
+  std::mutex mutex;
+  std::condition_variable start_condition;
+  std::condition_variable done_condition;
+  i64 generation = 0;
+  i64 steals = 0;
+  i32 worker_count = 0;
+  i32 running = 0;
+  bool stopping = false;
+
+  public:
+  // Work_Stealing_Pool
+  //
+  // Parameters:
+  // workers - number of workers including the calling thread. Values smaller
+  //           than 1 are treated as 1.
+  //
+  explicit Work_Stealing_Pool(i32 const workers) {
+    worker_count = workers > 1 ? workers : 1;
+    queues = std::make_unique<Worker_Queue[]>(worker_count);
+    for(i32 worker = 1; worker < worker_count; worker += 1) {
+      threads.emplace_back([this, worker] { thread_main(worker); });
+    }
+  }
+
+  Work_Stealing_Pool(Work_Stealing_Pool const&) = delete;
+  Work_Stealing_Pool& operator=(Work_Stealing_Pool const&) = delete;
+
+  ~Work_Stealing_Pool() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    start_condition.notify_all();
+    for(std::thread& thread: threads) {
+      thread.join();
+    }
+  }
+
+  // run
+  // Execute tasks 0 to task_count - 1 and wait for all of them to finish.
+  // Tasks are initially split into contiguous blocks, one per worker.
+  //
+  // Parameters:
+  // task_count - number of tasks.
+  //         fn - invoked as fn(worker, task). Workers are numbered from 0.
+  //
+  void run(i64 const task_count, std::function<void(i32, i64)> fn) {
+    for(i32 worker = 0; worker < worker_count; worker += 1) {
+      i64 const begin = task_count * worker / worker_count;
+      i64 const end = task_count * (worker + 1) / worker_count;
+      Worker_Queue& queue = queues[worker];
+      std::lock_guard lock(queue.mutex);
+      for(i64 task = begin; task < end; task += 1) {
+        queue.tasks.push_back(task);
+      }
+    }
+
+    {
+      std::lock_guard lock(mutex);
+      job = std::move(fn);
+      generation += 1;
+      running = worker_count;
+    }
+    start_condition.notify_all();
+    work(0);
+    std::unique_lock lock(mutex);
+    done_condition.wait(lock, [this] { return running == 0; });
+    job = nullptr;
+  }
+
+  [[nodiscard]] i32 size() const {
+    return worker_count;
+  }
+
+  // stolen_tasks
+  //
+  // Returns:
+  // Number of tasks executed by a worker other than the one they were
+  // initially assigned to.
+  //
+  [[nodiscard]] i64 stolen_tasks() {
+    std::lock_guard lock(mutex);
+    return steals;
+  }
+
+  private:
+  [[nodiscard]] bool pop(i32 const worker, i64& task, bool& stolen) {
+    {
+      Worker_Queue& queue = queues[worker];
+      std::lock_guard lock(queue.mutex);
+      if(queue.tasks.size() > 0) {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        stolen = false;
+        return true;
+      }
+    }
+
+    for(i32 offset = 1; offset < worker_count; offset += 1) {
+      Worker_Queue& queue = queues[(worker + offset) % worker_count];
+      std::lock_guard lock(queue.mutex);
+      if(queue.tasks.size() > 0) {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        stolen = true;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void work(i32 const worker) {
+    // Tasks are never added while a batch runs, hence a worker that finds all
+    // queues empty may leave.
+    i64 local_steals = 0;
+    i64 task = 0;
+    bool stolen = false;
+    while(pop(worker, task, stolen)) {
+      local_steals += stolen;
+      job(worker, task);
+    }
+
+    std::lock_guard lock(mutex);
+    steals += local_steals;
+    running -= 1;
+    if(running == 0) {
+      done_condition.notify_all();
+    }
+  }
+
+  void thread_main(i32 const worker) {
+    i64 seen_generation = 0;
+    while(true) {
+      {
+        std::unique_lock lock(mutex);
+        start_condition.wait(lock, [this, seen_generation] {
+          return stopping || generation != seen_generation;
+        });
+        if(stopping) {
+          return;
+        }
+        seen_generation = generation;
+      }
+      work(worker);
+    }
+  }
+};
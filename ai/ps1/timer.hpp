@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+
+#include <types.hpp>
+
+struct Timer {
+  private:
+  std::chrono::high_resolution_clock::time_point start_time;
+
+  public:
+  void start() {
+    start_time = std::chrono::high_resolution_clock::now();
+  }
+
+  [[nodiscard]] i64 end_ns() {
+    auto const end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end_time -
+                                                                start_time)
+      .count();
+  }
+
+  [[nodiscard]] i64 end_ms() {
+    auto const end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                                 start_time)
+      .count();
+  }
+};
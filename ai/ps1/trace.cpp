@@ -0,0 +1,109 @@
+#include <trace.hpp>
+
+#include <stdio.h>
+
+static void write_json(Search_Trace const& trace, FILE* const file) {
+  i64 const heuristic_ns = trace.heuristic_estimated_ns();
+  fprintf(file, "{\n");
+  fprintf(file, "  \"solver\": \"%s\",\n", trace.solver);
+  fprintf(file, "  \"duration_ns\": %lld,\n", trace.duration_ns);
+  fprintf(file, "  \"expanded\": %lld,\n", trace.expanded);
+  fprintf(file, "  \"generated\": %lld,\n", trace.generated);
+  fprintf(file, "  \"duplicates\": %lld,\n", trace.duplicates);
+  fprintf(file, "  \"duplicate_rate\": %.6f,\n",
+          trace.generated > 0 ? (double)trace.duplicates / trace.generated
+                              : 0.0);
+  fprintf(file, "  \"heuristic\": {\n");
+  fprintf(file, "    \"calls\": %lld,\n", trace.heuristic_calls);
+  fprintf(file, "    \"timed_calls\": %lld,\n", trace.heuristic_timed_calls);
+  fprintf(file, "    \"timed_ns\": %lld,\n", trace.heuristic_timed_ns);
+  fprintf(file, "    \"clock_overhead_ns\": %lld,\n",
+          trace.clock_overhead_ns);
+  fprintf(file, "    \"estimated_ns\": %lld,\n", heuristic_ns);
+  fprintf(file, "    \"time_share\": %.6f\n",
+          trace.duration_ns > 0 ? (double)heuristic_ns / trace.duration_ns
+                                : 0.0);
+  fprintf(file, "  },\n");
+
+  fprintf(file, "  \"iterations\": [");
+  for(i64 i = 0; Trace_Iteration const& iteration: trace.iterations) {
+    fprintf(file,
+            "%s\n    {\"f_cutoff\": %d, \"start_ns\": %lld, "
+            "\"duration_ns\": %lld, \"explored\": %lld}",
+            i > 0 ? "," : "", iteration.f_cutoff, iteration.start_ns,
+            iteration.duration_ns, iteration.explored);
+    i += 1;
+  }
+  fprintf(file, "%s],\n", trace.iterations.size() > 0 ? "\n  " : "");
+
+  fprintf(file, "  \"samples\": [");
+  for(i64 i = 0; Trace_Sample const& sample: trace.samples) {
+    fprintf(file,
+            "%s\n    {\"time_ns\": %lld, \"expanded\": %lld, \"open\": %lld, "
+            "\"closed\": %lld, \"bytes\": %lld}",
+            i > 0 ? "," : "", sample.time_ns, sample.expanded, sample.open,
+            sample.closed, sample.bytes);
+    i += 1;
+  }
+  fprintf(file, "%s],\n", trace.samples.size() > 0 ? "\n  " : "");
+
+  fprintf(file, "  \"depth_histogram\": [");
+  for(i64 i = 0; i64 const count: trace.depth_histogram) {
+    fprintf(file, "%s%lld", i > 0 ? ", " : "", count);
+    i += 1;
+  }
+  fprintf(file, "]\n");
+  fprintf(file, "}\n");
+}
+
+static void write_chrome(Search_Trace const& trace, FILE* const file) {
+  // Timestamps of the Trace Event Format are in microseconds.
+  fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  fprintf(file,
+          "  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, "
+          "\"ts\": 0, \"dur\": %.3f, \"args\": {\"expanded\": %lld, "
+          "\"generated\": %lld, \"duplicates\": %lld, "
+          "\"heuristic_calls\": %lld}}",
+          trace.solver, trace.duration_ns / 1000.0, trace.expanded,
+          trace.generated, trace.duplicates, trace.heuristic_calls);
+  for(Trace_Iteration const& iteration: trace.iterations) {
+    fprintf(file,
+            ",\n  {\"name\": \"f %d\", \"ph\": \"X\", \"pid\": 1, \"tid\": 2, "
+            "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"f_cutoff\": %d, "
+            "\"explored\": %lld}}",
+            iteration.f_cutoff, iteration.start_ns / 1000.0,
+            iteration.duration_ns / 1000.0, iteration.f_cutoff,
+            iteration.explored);
+  }
+  for(Trace_Sample const& sample: trace.samples) {
+    fprintf(file,
+            ",\n  {\"name\": \"sets\", \"ph\": \"C\", \"pid\": 1, "
+            "\"ts\": %.3f, \"args\": {\"open\": %lld, \"closed\": %lld}}",
+            sample.time_ns / 1000.0, sample.open, sample.closed);
+    fprintf(file,
+            ",\n  {\"name\": \"memory\", \"ph\": \"C\", \"pid\": 1, "
+            "\"ts\": %.3f, \"args\": {\"bytes\": %lld}}",
+            sample.time_ns / 1000.0, sample.bytes);
+  }
+  fprintf(file, "\n]}\n");
+}
+
+bool write_trace(Search_Trace const& trace, Trace_Format const format,
+                 char const* const path) {
+  FILE* const file = fopen(path, "w");
+  if(file == nullptr) {
+    return false;
+  }
+
+  switch(format) {
+    case Trace_Format::json:
+      write_json(trace, file);
+      break;
+    case Trace_Format::chrome:
+      write_chrome(trace, file);
+      break;
+  }
+
+  bool const failed = ferror(file) != 0;
+  return fclose(file) == 0 && !failed;
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <vector>
+
+#include <timer.hpp>
+#include <types.hpp>
+
+// The solvers feed an optional Search_Trace through the TRACE macros. Unless
+// ENABLE_TRACE is 1 the macros expand to nothing, hence builds that do not
+// need the instrumentation do not pay even for the nullptr checks.
+
+#if defined(ENABLE_TRACE) && ENABLE_TRACE == 1
+
+constexpr bool trace_enabled = true;
+
+  // TRACE
+  // Invoke a member function of trace unless trace is nullptr.
+  #define TRACE(trace, ...)    \
+    do {                       \
+      if((trace) != nullptr) { \
+        (trace)->__VA_ARGS__;  \
+      }                        \
+    } while(0)
+
+  // TRACE_HEURISTIC
+  // Evaluate expression, a call of a heuristic function, and record the call
+  // in trace unless trace is nullptr.
+  #define TRACE_HEURISTIC(trace, expression)                          \
+    ((trace) != nullptr                                               \
+       ? (trace)->heuristic_call([&]() -> i32 { return expression; }) \
+       : (expression))
+
+#else
+
+constexpr bool trace_enabled = false;
+
+  // The call is still compiled, so that the variables used only by the
+  // instrumentation do not trigger unused warnings, but never executed.
+  #define TRACE(trace, ...)    \
+    do {                       \
+      if(false) {              \
+        (trace)->__VA_ARGS__;  \
+      }                        \
+    } while(0)
+
+  #define TRACE_HEURISTIC(trace, expression) (expression)
+
+#endif
+
+// Trace_Iteration
+// Deepening iteration of IDA*.
+//
+struct Trace_Iteration {
+  // Relative to the start of the search.
+  i64 start_ns = 0;
+  i64 duration_ns = 0;
+  i64 explored = 0;
+  i32 f_cutoff = 0;
+};
+
+// Trace_Sample
+// Sizes of the sets of a best-first search at some point of the search.
+//
+struct Trace_Sample {
+  // Relative to the start of the search.
+  i64 time_ns = 0;
+  i64 expanded = 0;
+  i64 open = 0;
+  i64 closed = 0;
+  // Bytes held by the node storage and the closed set.
+  i64 bytes = 0;
+};
+
+// Search_Trace
+// Counters, histograms and samples collected over a single search.
+//
+struct Search_Trace {
+  // Only every heuristic_sample_period-th heuristic call is timed, reading
+  // the clock costs more than evaluating most heuristics.
+  static constexpr i64 heuristic_sample_period = 64;
+  // Number of expansions between the samples of the best-first searches.
+  static constexpr i64 sample_period = 1 << 14;
+
+  char const* solver = "";
+  i64 duration_ns = 0;
+  std::vector<Trace_Iteration> iterations;
+  std::vector<Trace_Sample> samples;
+  // Number of expanded nodes by depth.
+  std::vector<i64> depth_histogram;
+  i64 expanded = 0;
+  i64 generated = 0;
+  // Generated nodes that had already been known, i.e. found in the closed set
+  // or undoing the last move of IDA*.
+  i64 duplicates = 0;
+  i64 heuristic_calls = 0;
+  i64 heuristic_timed_calls = 0;
+  i64 heuristic_timed_ns = 0;
+  // Cost of reading the clock twice, included in every timed call.
+  i64 clock_overhead_ns = 0;
+
+  private:
+  Timer timer;
+
+  public:
+  void begin(char const* const name) {
+    solver = name;
+    clock_overhead_ns = i64_largest_value;
+    for(i32 i = 0; i < 64; i += 1) {
+      Timer empty;
+      empty.start();
+      i64 const overhead = empty.end_ns();
+      if(overhead < clock_overhead_ns) {
+        clock_overhead_ns = overhead;
+      }
+    }
+    timer.start();
+  }
+
+  void end() {
+    duration_ns = timer.end_ns();
+  }
+
+  void begin_iteration(i32 const f_cutoff) {
+    iterations.push_back(
+      Trace_Iteration{.start_ns = timer.end_ns(), .f_cutoff = f_cutoff});
+  }
+
+  void end_iteration(i64 const explored) {
+    Trace_Iteration& iteration = iterations.back();
+    iteration.duration_ns = timer.end_ns() - iteration.start_ns;
+    iteration.explored = explored;
+  }
+
+  void expand(i64 const depth) {
+    if(depth >= (i64)depth_histogram.size()) {
+      depth_histogram.resize(depth + 1, 0);
+    }
+    depth_histogram[depth] += 1;
+    expanded += 1;
+  }
+
+  // expand
+  //
+  // Parameters:
+  // snapshot - invoked as snapshot() every sample_period expansions. Returns
+  //            a Trace_Sample with open, closed and bytes filled in.
+  //
+  template<typename Snapshot>
+  void expand(i64 const depth, Snapshot&& snapshot) {
+    expand(depth);
+    if((expanded & (sample_period - 1)) == 0) {
+      Trace_Sample sample = snapshot();
+      sample.time_ns = timer.end_ns();
+      sample.expanded = expanded;
+      samples.push_back(sample);
+    }
+  }
+
+  void generate(bool const duplicate) {
+    generated += 1;
+    duplicates += duplicate;
+  }
+
+  template<typename Evaluate>
+  [[nodiscard]] i32 heuristic_call(Evaluate&& evaluate) {
+    heuristic_calls += 1;
+    if(heuristic_calls % heuristic_sample_period != 0) {
+      return evaluate();
+    }
+
+    Timer call_timer;
+    call_timer.start();
+    i32 const value = evaluate();
+    heuristic_timed_ns += call_timer.end_ns();
+    heuristic_timed_calls += 1;
+    return value;
+  }
+
+  // Estimated time spent in the heuristic calls extrapolated from the timed
+  // calls.
+  [[nodiscard]] i64 heuristic_estimated_ns() const {
+    i64 const timed_ns =
+      heuristic_timed_ns - heuristic_timed_calls * clock_overhead_ns;
+    if(heuristic_timed_calls == 0 || timed_ns <= 0) {
+      return 0;
+    }
+    return (double)timed_ns * heuristic_calls / heuristic_timed_calls;
+  }
+};
+
+enum struct Trace_Format {
+  // Counters, histograms and samples as a single JSON object.
+  json,
+  // Chrome Trace Event Format, viewable in chrome://tracing or Perfetto.
+  chrome,
+};
+
+// write_trace
+//
+// Returns:
+// Whether the file could be written.
+//
+[[nodiscard]] bool write_trace(Search_Trace const& trace,
+                               Trace_Format format, char const* path);
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <types.hpp>
+
+struct Transposition_Table_Statistics {
+  i64 capacity = 0;
+  i64 bytes = 0;
+  i64 probes = 0;
+  i64 hits = 0;
+  // Hits whose stored bound pruned the configuration.
+  i64 cutoffs = 0;
+  i64 stores = 0;
+
+  void accumulate(Transposition_Table_Statistics const& other) {
+    probes += other.probes;
+    hits += other.hits;
+    cutoffs += other.cutoffs;
+    stores += other.stores;
+  }
+};
+
+// Transposition_Entry
+// What the search knows about a configuration.
+//
+struct Transposition_Entry {
+  // Smallest cost of a path to the configuration the subtree has been
+  // searched from.
+  i32 g = 0;
+  // Lower bound of the cost of the remaining path to the goal backed up from
+  // the subtree.
+  i32 bound = 0;
+  // Deepening iteration the entry has been stored in.
+  i32 generation = 0;
+};
+
+// Transposition_Table
+// Fixed size, lossy table of Transposition_Entry keyed on packed board
+// configurations (see hash_configuration). Every key maps to a single slot,
+// colliding keys replace each other.
+//
+// The table may be shared by threads without locking. A slot holds the
+// packed entry and the key xored with it, both written with separate relaxed
+// stores. A slot torn by concurrent stores fails the key check and reads as
+// empty, hence a lookup never returns the entry of a different key.
+//
+// The empty slot holds 0 in both words, which never checks against a key
+// because a packed configuration is never 0.
+//
+struct Transposition_Table {
+  private:
+  struct Slot {
+    std::atomic<u64> check;
+    std::atomic<u64> data;
+  };
+
+  std::vector<Slot> slots;
+  i64 mask = 0;
+  u32 shift = 0;
+
+  public:
+  // Transposition_Table
+  //
+  // Parameters:
+  // bytes - upper bound of the memory used by the table. Rounded down to the
+  //         power of 2 slots, at least two slots.
+  //
+  explicit Transposition_Table(i64 const bytes) {
+    i64 capacity = 2;
+    while(capacity * 2 * (i64)sizeof(Slot) <= bytes) {
+      capacity *= 2;
+    }
+    slots = std::vector<Slot>(capacity);
+    mask = capacity - 1;
+    shift = 64;
+    for(i64 c = capacity; c > 1; c >>= 1) {
+      shift -= 1;
+    }
+  }
+
+  [[nodiscard]] i64 capacity() const {
+    return mask + 1;
+  }
+
+  [[nodiscard]] i64 bytes() const {
+    return capacity() * sizeof(Slot);
+  }
+
+  // find
+  //
+  // Returns:
+  // Whether an entry of key is present. entry is only written when it is.
+  //
+  [[nodiscard]] bool find(u64 const key, Transposition_Entry& entry) const {
+    Slot const& slot = slots[index(key)];
+    u64 const data = slot.data.load(std::memory_order_relaxed);
+    u64 const check = slot.check.load(std::memory_order_relaxed);
+    if((check ^ data) != key) {
+      return false;
+    }
+
+    entry = unpack(data);
+    return true;
+  }
+
+  // store
+  // Merge entry with the one already stored for key. Otherwise replace the
+  // entry of another key if it comes from an earlier iteration or has been
+  // searched from a deeper configuration, shallower entries root larger
+  // subtrees.
+  //
+  void store(u64 const key, Transposition_Entry entry) {
+    Slot& slot = slots[index(key)];
+    u64 const data = slot.data.load(std::memory_order_relaxed);
+    u64 const check = slot.check.load(std::memory_order_relaxed);
+    Transposition_Entry const stored = unpack(data);
+    if((check ^ data) == key) {
+      // Both bounds hold, but a g from an earlier iteration is stale.
+      if(stored.generation == entry.generation && stored.g < entry.g) {
+        entry.g = stored.g;
+      }
+      if(stored.bound > entry.bound) {
+        entry.bound = stored.bound;
+      }
+    } else if(data != 0 && stored.generation == entry.generation &&
+              stored.g < entry.g) {
+      return;
+    }
+
+    u64 const packed = pack(entry);
+    slot.data.store(packed, std::memory_order_relaxed);
+    slot.check.store(key ^ packed, std::memory_order_relaxed);
+  }
+
+  private:
+  [[nodiscard]] i64 index(u64 const key) const {
+    // Fibonacci hashing, see Hash_Table::slot.
+    return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+  }
+
+  [[nodiscard]] static u64 pack(Transposition_Entry const entry) {
+    return (u64)(u16)entry.g | ((u64)(u16)entry.bound << 16) |
+           ((u64)(u32)entry.generation << 32);
+  }
+
+  [[nodiscard]] static Transposition_Entry unpack(u64 const data) {
+    return Transposition_Entry{.g = (u16)data,
+                               .bound = (u16)(data >> 16),
+                               .generation = (i32)(data >> 32)};
+  }
+};
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <stdio.h>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <bitboard.hpp>
+#include <bot.hpp>
+#include <configuration.hpp>
+#include <heuristic.hpp>
+#include <transposition_table.hpp>
+#include <types.hpp>
+
+// Midgame position with 15 empty squares and no line of 3 on the board, x to
+// move. Deep enough for the counts at depth 10 to reach hundreds of millions.
+static constexpr char const* benchmark_position[] = {
+  "xo..x", //
+  ".x...", //
+  "oxo..", //
+  "..o..", //
+  "x...o",
+};
+
+static constexpr i32 minimum_depth = 6;
+static constexpr i32 maximum_depth = 10;
+
+static Configuration make_benchmark_configuration() {
+  Configuration c;
+  for(i32 y = 0; y < Configuration::height; y += 1) {
+    for(i32 x = 0; x < Configuration::width; x += 1) {
+      char const square = benchmark_position[y][x];
+      if(square == 'x') {
+        c(x, y) = State::x;
+      } else if(square == 'o') {
+        c(x, y) = State::o;
+      }
+    }
+  }
+  return c;
+}
+
+[[nodiscard]] static i64 elapsed_ns(
+  std::chrono::steady_clock::time_point const start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - start)
+    .count();
+}
+
+// perft
+// Count the positions depth moves away from board. Terminal positions are not
+// expanded and count as a single position regardless of the remaining depth.
+//
+[[nodiscard]] static i64 perft(Bitboard const board, Player const turn,
+                               i32 const depth) {
+  if(depth == 0) {
+    return 1;
+  }
+
+  i64 nodes = 0;
+  u32 empty = ~board.occupied() & Bitboard::full_mask;
+  while(empty != 0) {
+    i32 const index = __builtin_ctz(empty);
+    empty &= empty - 1;
+    Bitboard child = board;
+    child.place(index, turn);
+    if(child.check_move(index, turn) || child.check_draw()) {
+      nodes += 1;
+    } else {
+      nodes += perft(child, OPPONENT(turn), depth - 1);
+    }
+  }
+  return nodes;
+}
+
+static void benchmark_perft() {
+  Bitboard const board = make_benchmark_configuration().to_bitboard();
+  for(i32 depth = minimum_depth; depth <= maximum_depth; depth += 1) {
+    auto const start = std::chrono::steady_clock::now();
+    i64 const nodes = perft(board, Player::x, depth);
+    i64 const time = elapsed_ns(start);
+    printf("depth %2d %12lld nodes %10.1fms %14.0f nodes/s\n", depth, nodes,
+           time / 1000000.0, time > 0 ? nodes * 1000000000.0 / time : 0.0);
+  }
+}
+
+static void benchmark_minmax() {
+  constexpr i64 table_bytes = 16 << 20;
+  Configuration const c = make_benchmark_configuration();
+  struct Variant {
+    char const* name;
+    bool table;
+    bool symmetries;
+  };
+  constexpr Variant variants[] = {
+    {"plain", false, false},
+    {"table", true, false},
+    {"symmetric", true, true},
+  };
+  for(Variant const variant: variants) {
+    for(i32 depth = minimum_depth; depth <= maximum_depth; depth += 1) {
+      // A fresh table for every search, entries of the shallower searches
+      // would otherwise help the deeper ones.
+      std::optional<Transposition_Table> table;
+      if(variant.table) {
+        table.emplace(table_bytes);
+      }
+      MINMAX_Statistics statistics;
+      auto const start = std::chrono::steady_clock::now();
+      MINMAX_Result const result =
+        minmax_search(MINMAX_Parameters{.c = c,
+                                        .player = Player::x,
+                                        .turn = Player::x,
+                                        .depth = 0,
+                                        .max_depth = depth,
+                                        .alpha = minimum_i32,
+                                        .beta = maximum_i32,
+                                        .table = table ? &*table : nullptr,
+                                        .symmetries = variant.symmetries,
+                                        .statistics = &statistics});
+      i64 const time = elapsed_ns(start);
+      Transposition_Table_Statistics const& t = statistics.table;
+      printf("%-9s depth %2d value %7d move (%d, %d) %10lld nodes %10.1fms "
+             "hits %5.1f%% saved %10lld\n",
+             variant.name, depth, result.value, result.x, result.y,
+             statistics.nodes, time / 1000000.0,
+             t.probes > 0 ? 100.0 * t.hits / t.probes : 0.0, t.nodes_saved);
+    }
+  }
+}
+
+static void benchmark_deepening() {
+  constexpr i64 table_bytes = 16 << 20;
+  Configuration const c = make_benchmark_configuration();
+  for(i32 depth = minimum_depth; depth <= maximum_depth; depth += 1) {
+    Transposition_Table table(table_bytes);
+    MINMAX_Statistics statistics;
+    auto const start = std::chrono::steady_clock::now();
+    MINMAX_Result const result = iterative_deepening_search(
+      Iterative_Deepening_Parameters{.c = c,
+                                     .player = Player::x,
+                                     .max_depth = depth,
+                                     .table = &table,
+                                     .statistics = &statistics});
+    i64 const time = elapsed_ns(start);
+    printf("depth %2d value %7d move (%d, %d) %10lld nodes %10.1fms\n",
+           depth, result.value, result.x, result.y, statistics.nodes,
+           time / 1000000.0);
+  }
+
+  constexpr i64 budgets_ms[] = {1, 10, 100, 1000};
+  for(i64 const budget: budgets_ms) {
+    Transposition_Table table(table_bytes);
+    MINMAX_Statistics statistics;
+    auto const start = std::chrono::steady_clock::now();
+    MINMAX_Result const result = iterative_deepening_search(
+      Iterative_Deepening_Parameters{.c = c,
+                                     .player = Player::x,
+                                     .max_depth = Bitboard::squares,
+                                     .time_budget_ms = budget,
+                                     .table = &table,
+                                     .statistics = &statistics});
+    i64 const time = elapsed_ns(start);
+    printf("budget %4lldms depth %2d value %7d move (%d, %d) %10lld nodes "
+           "%10.1fms\n",
+           budget, statistics.depth, result.value, result.x, result.y,
+           statistics.nodes, time / 1000000.0);
+  }
+}
+
+static void benchmark_threads() {
+  constexpr i64 table_bytes = 16 << 20;
+  constexpr i64 budget_ms = 1000;
+  Configuration c;
+  i32 const max_threads = std::max<i32>(std::thread::hardware_concurrency(), 1);
+  for(i32 threads = 1; threads <= max_threads; threads *= 2) {
+    Transposition_Table table(table_bytes);
+    MINMAX_Statistics statistics;
+    auto const start = std::chrono::steady_clock::now();
+    MINMAX_Result const result = iterative_deepening_search(
+      Iterative_Deepening_Parameters{.c = c,
+                                     .player = Player::x,
+                                     .max_depth = Bitboard::squares,
+                                     .time_budget_ms = budget_ms,
+                                     .threads = threads,
+                                     .table = &table,
+                                     .statistics = &statistics});
+    i64 const time = elapsed_ns(start);
+    printf("threads %2d depth %2d value %7d move (%d, %d) %10lld nodes "
+           "%10.1fms\n",
+           threads, statistics.depth, result.value, result.x, result.y,
+           statistics.nodes, time / 1000000.0);
+  }
+}
+
+static void benchmark_evaluation() {
+  constexpr i32 games = 100000;
+  // Positions along random games, stopped at the first line.
+  std::vector<Bitboard> positions;
+  std::vector<i32> moves;
+  std::vector<i32> lengths;
+  std::mt19937 random(0x5EED);
+  for(i32 game = 0; game < games; game += 1) {
+    Bitboard board;
+    i32 length = 0;
+    for(Player turn = Player::x; !board.check_draw(); turn = OPPONENT(turn)) {
+      u32 const empty = ~board.occupied() & Bitboard::full_mask;
+      i32 choice = random() % std::popcount(empty);
+      i32 index = 0;
+      for(u32 squares = empty;; squares &= squares - 1) {
+        index = std::countr_zero(squares);
+        if(choice == 0) {
+          break;
+        }
+        choice -= 1;
+      }
+
+      board.place(index, turn);
+      positions.push_back(board);
+      moves.push_back(index);
+      length += 1;
+      if(board.check_move(index, turn)) {
+        break;
+      }
+    }
+    lengths.push_back(length);
+  }
+
+  auto const report = [&positions](char const* const name, i64 const time,
+                                    i64 const checksum) {
+    i64 const count = positions.size();
+    printf("%-11s %10lld evaluations %8.1fms %12.0f evaluations/s "
+           "(checksum %lld)\n",
+           name, count, time / 1000000.0,
+           time > 0 ? count * 1000000000.0 / time : 0.0, checksum);
+  };
+
+  {
+    i64 checksum = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for(Bitboard const& board: positions) {
+      checksum += heuristic(board, Player::x);
+    }
+    report("full", elapsed_ns(start), checksum);
+  }
+
+  {
+    i64 checksum = 0;
+    auto const start = std::chrono::steady_clock::now();
+    i64 position = 0;
+    for(i32 const length: lengths) {
+      Evaluation evaluation(Bitboard{}, Player::x);
+      for(i32 i = 0; i < length; i += 1) {
+        evaluation.place(positions[position], moves[position]);
+        checksum += evaluation.value();
+        position += 1;
+      }
+    }
+    report("incremental", elapsed_ns(start), checksum);
+  }
+}
+
+static void help(char const* const name) {
+  printf("Usage: %s BENCHMARK\n", name);
+  printf("\n");
+  printf("BENCHMARK\n");
+  printf("  perft\n");
+  printf("    Number of positions reachable from a fixed midgame position at "
+         "depths %d to %d and the nodes per second of the bitboard move "
+         "generation.\n",
+         minimum_depth, maximum_depth);
+  printf("  minmax\n");
+  printf("    Value, move, nodes and time of minmax_search from the same "
+         "position at depths %d to %d without a transposition table, with "
+         "one and with one shared by symmetric positions.\n",
+         minimum_depth, maximum_depth);
+  printf("  deepening\n");
+  printf("    Value, move, nodes and time of iterative_deepening_search from "
+         "the same position up to depths %d to %d and under time budgets.\n",
+         minimum_depth, maximum_depth);
+  printf("  evaluation\n");
+  printf("    Evaluations per second of the heuristic over the positions of "
+         "random games evaluated in full and incrementally.\n");
+  printf("  threads\n");
+  printf("    Depth and nodes reached by iterative_deepening_search from the "
+         "empty board within 1s with 1, 2, 4, ... threads up to the number of "
+         "hardware threads.\n");
+}
+
+int main(int const argc, char** const argv) {
+  constexpr i32 RETURN_SUCCESS = 0;
+  constexpr i32 RETURN_ERROR = 1;
+  constexpr i32 RETURN_HELP = 2;
+
+  if(argc < 2) {
+    help(argv[0]);
+    return RETURN_HELP;
+  }
+
+  std::string_view const benchmark(argv[1]);
+  if(benchmark == "-h" || benchmark == "--help") {
+    help(argv[0]);
+    return RETURN_HELP;
+  }
+
+  if(make_benchmark_configuration().check_winner()) {
+    printf("error: benchmark position is terminal\n");
+    return RETURN_ERROR;
+  }
+
+  if(benchmark == "perft") {
+    benchmark_perft();
+  } else if(benchmark == "minmax") {
+    benchmark_minmax();
+  } else if(benchmark == "deepening") {
+    benchmark_deepening();
+  } else if(benchmark == "evaluation") {
+    benchmark_evaluation();
+  } else if(benchmark == "threads") {
+    benchmark_threads();
+  } else {
+    printf("error: unrecognised benchmark: %s\n", argv[1]);
+    return RETURN_ERROR;
+  }
+
+  return RETURN_SUCCESS;
+}
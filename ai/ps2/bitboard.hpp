@@ -0,0 +1,179 @@
+#pragma once
+
+#include <types.hpp>
+
+#include <array>
+#include <optional>
+
+// Bitboard_Lines
+// Windows of 4 and 3 squares in a line on the 5x5 board as masks of the bits
+// y * 5 + x. There are 28 and 48 of them respectively.
+//
+struct Bitboard_Lines {
+  std::array<u32, 28> fours = {};
+  std::array<u32, 48> threes = {};
+  i32 four_count = 0;
+  i32 three_count = 0;
+};
+
+// Bitboard_Square_Lines
+// Windows passing through a single square. The center is covered by the most
+// of them, 8 windows of 4 squares and 12 windows of 3 squares.
+//
+struct Bitboard_Square_Lines {
+  std::array<u32, 8> fours = {};
+  std::array<u32, 12> threes = {};
+  i32 four_count = 0;
+  i32 three_count = 0;
+};
+
+constexpr Bitboard_Lines bitboard_lines = [] {
+  constexpr i32 size = 5;
+  constexpr Point directions[] = {{1, 0}, {0, 1}, {1, 1}, {-1, 1}};
+  Bitboard_Lines lines;
+  for(auto const [dx, dy]: directions) {
+    for(i32 y = 0; y < size; y += 1) {
+      for(i32 x = 0; x < size; x += 1) {
+        u32 mask = 0;
+        for(i32 i = 0; i < 4; i += 1) {
+          i32 const px = x + i * dx;
+          i32 const py = y + i * dy;
+          if(px < 0 || px >= size || py < 0 || py >= size) {
+            mask = 0;
+            break;
+          }
+
+          mask |= 1u << (py * size + px);
+          // The first 3 squares of a window are a window of 3 on their own.
+          if(i == 2) {
+            lines.threes[lines.three_count] = mask;
+            lines.three_count += 1;
+          }
+        }
+
+        if(mask != 0) {
+          lines.fours[lines.four_count] = mask;
+          lines.four_count += 1;
+        }
+      }
+    }
+  }
+  return lines;
+}();
+
+static_assert(bitboard_lines.four_count == 28);
+static_assert(bitboard_lines.three_count == 48);
+
+constexpr std::array<Bitboard_Square_Lines, 25> bitboard_square_lines = [] {
+  std::array<Bitboard_Square_Lines, 25> table = {};
+  for(i32 index = 0; index < 25; index += 1) {
+    Bitboard_Square_Lines& square = table[index];
+    for(u32 const mask: bitboard_lines.fours) {
+      if(mask & (1u << index)) {
+        square.fours[square.four_count] = mask;
+        square.four_count += 1;
+      }
+    }
+    for(u32 const mask: bitboard_lines.threes) {
+      if(mask & (1u << index)) {
+        square.threes[square.three_count] = mask;
+        square.three_count += 1;
+      }
+    }
+  }
+  return table;
+}();
+
+// Bitboard
+// Board packed into a mask of the occupied squares per player, the square
+// (x, y) being the bit y * width + x. A player wins by placing 4 pieces in a
+// line and loses by placing 3 pieces in a line, hence terminal positions are
+// recognised by masking the pieces with the precomputed windows.
+//
+struct Bitboard {
+public:
+  static constexpr i32 width = 5;
+  static constexpr i32 height = 5;
+  static constexpr i32 squares = width * height;
+  static constexpr u32 full_mask = (1u << squares) - 1;
+
+public:
+  std::array<u32, 2> pieces = {};
+
+public:
+  [[nodiscard]] static constexpr i32 index(i32 const x, i32 const y) {
+    return y * width + x;
+  }
+
+  [[nodiscard]] u32 occupied() const {
+    return pieces[0] | pieces[1];
+  }
+
+  [[nodiscard]] bool is_empty(i32 const index) const {
+    return (occupied() & (1u << index)) == 0;
+  }
+
+  void place(i32 const index, Player const player) {
+    pieces[static_cast<i32>(player)] |= 1u << index;
+  }
+
+  // check_winner
+  // Check every window. As with Configuration::check_winner, we rely on only
+  // one player having a line since the game ends with the first line placed.
+  //
+  [[nodiscard]] std::optional<Player> check_winner() const {
+    // Check 4-in-a-line first to determine whether anyone has won.
+    for(Player const player: {Player::x, Player::o}) {
+      u32 const mine = pieces[static_cast<i32>(player)];
+      for(u32 const mask: bitboard_lines.fours) {
+        if((mine & mask) == mask) {
+          return player;
+        }
+      }
+    }
+
+    // Now check 3-in-a-line to determine whether anyone has lost.
+    for(Player const player: {Player::x, Player::o}) {
+      u32 const mine = pieces[static_cast<i32>(player)];
+      for(u32 const mask: bitboard_lines.threes) {
+        if((mine & mask) == mask) {
+          return OPPONENT(player);
+        }
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  // check_move
+  // Check only the windows through the square at index. Equivalent to
+  // check_winner when the square has just been taken by player and the
+  // position before the move has not been terminal.
+  //
+  [[nodiscard]] std::optional<Player> check_move(i32 const index,
+                                                 Player const player) const {
+    u32 const mine = pieces[static_cast<i32>(player)];
+    Bitboard_Square_Lines const& square = bitboard_square_lines[index];
+    for(i32 i = 0; i < square.four_count; i += 1) {
+      if((mine & square.fours[i]) == square.fours[i]) {
+        return player;
+      }
+    }
+
+    for(i32 i = 0; i < square.three_count; i += 1) {
+      if((mine & square.threes[i]) == square.threes[i]) {
+        return OPPONENT(player);
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  // check_draw
+  // Verify all squares are occupied. To be used in conjunction with
+  // Bitboard::check_winner or Bitboard::check_move.
+  //
+  [[nodiscard]] bool check_draw() const {
+    return occupied() == full_mask;
+  }
+};
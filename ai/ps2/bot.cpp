@@ -1,11 +1,19 @@
 #include <bot.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <functional>
 #include <optional>
 #include <stdio.h>
+#include <thread>
+#include <vector>
 
 #include <configuration.hpp>
 #include <heuristic.hpp>
+#include <transposition_table.hpp>
 
 // Spiral starting at the center unfolding right.
 static constexpr Point board_order[] = {
@@ -44,86 +52,516 @@ static constexpr Point board_order[] = {
 
 static constexpr i32 game_won_score = 100000;
 
-MINMAX_Result minmax_search(MINMAX_Parameters const p) {
-  bool const maximising_player = p.turn == p.player;
+// Squares of board_order as bitboard indices.
+static constexpr std::array<i32, 25> board_order_indices = [] {
+  std::array<i32, 25> indices = {};
+  for(i32 i = 0; auto const [x, y]: board_order) {
+    indices[i] = Bitboard::index(x, y);
+    i += 1;
+  }
+  return indices;
+}();
+
+// Move_Ordering
+// Killer moves and history scores collected by the searches, kept over the
+// iterations of iterative deepening.
+//
+struct Move_Ordering {
+  // Last 2 distinct moves that caused a cutoff at every depth.
+  std::array<std::array<i32, 2>, 26> killers;
+  // Sum of the squared remaining depths of the cutoffs caused by a move of a
+  // player.
+  std::array<std::array<i64, 25>, 2> history = {};
+
+  Move_Ordering() {
+    for(std::array<i32, 2>& k: killers) {
+      k = {-1, -1};
+    }
+  }
+
+  void cutoff(i32 const index, Player const turn, i32 const depth,
+              i32 const remaining_depth) {
+    history[static_cast<i32>(turn)][index] += remaining_depth * remaining_depth;
+    std::array<i32, 2>& k = killers[depth];
+    if(k[0] != index) {
+      k[1] = k[0];
+      k[0] = index;
+    }
+  }
+};
+
+// Search_Context
+// State shared by all nodes of a single search.
+//
+struct Search_Context {
+  Player player;
+  i32 max_depth;
+  Transposition_Table* table;
+  // nullptr unless the side to move of the root is implied by the pieces, the
+  // tablebase assumes so.
+  Position_Table const* tablebase;
+  MINMAX_Statistics& statistics;
+  Move_Ordering& ordering;
+  // Move searched first at the root or -1.
+  i32 root_move = -1;
+  // The search is abandoned once the deadline passes or stop is set.
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  std::atomic<bool> const* stop;
+  bool aborted = false;
+  // Rotates the order of the moves of equal scores, so that the threads of a
+  // parallel search diverge.
+  i32 tie_rotation = 0;
+};
+
+struct Search_Node {
+  Bitboard board;
+  Zobrist_Hash hash;
+  // heuristic of board for the maximising player.
+  Evaluation evaluation;
+  // Index of the square taken by the last move or -1 if the position is the
+  // root of the search.
+  i32 last_move;
+  Player turn;
+  i32 depth;
+  i32 alpha;
+  i32 beta;
+};
+
+// tablebase_score
+//
+// Returns:
+// Value of a solved position for the maximising player.
+//
+[[nodiscard]] static i32 tablebase_score(Tablebase_Entry const entry,
+                                         bool const maximising_player) {
+  i32 score = 0;
+  if(entry.outcome == Outcome::win) {
+    score = game_won_score;
+  } else if(entry.outcome == Outcome::loss) {
+    score = -game_won_score;
+  }
+  return maximising_player ? score : -score;
+}
+
+// Number of nodes between the reads of the clock and the stop flag.
+static constexpr i64 deadline_check_period = 64;
+
+// search
+// minmax_search of the position of node. When context.aborted is set upon
+// return, the result is meaningless.
+//
+[[nodiscard]] static MINMAX_Result search(Search_Context& context,
+                                          Search_Node const& node) {
+  context.statistics.nodes += 1;
+  if(context.statistics.nodes % deadline_check_period == 0) {
+    if(context.deadline &&
+       std::chrono::steady_clock::now() >= context.deadline.value()) {
+      context.aborted = true;
+    }
+    if(context.stop != nullptr &&
+       context.stop->load(std::memory_order_relaxed)) {
+      context.aborted = true;
+    }
+  }
+  if(context.aborted) {
+    return MINMAX_Result{0, -1, -1};
+  }
+
+  Player const player = context.player;
+  i32 const max_depth = context.max_depth;
+  bool const maximising_player = node.turn == player;
   // Terminal node.
-  if(p.depth <= p.max_depth) {
-    std::optional<Player> winner = p.c.check_winner();
+  if(node.depth <= max_depth) {
+    // Only the last move may have ended the game, hence it suffices to check
+    // the lines through it.
+    std::optional<Player> const winner =
+      node.last_move != -1
+        ? node.board.check_move(node.last_move, OPPONENT(node.turn))
+        : node.board.check_winner();
     if(winner) {
-      bool const opponent_won = winner.value() != p.player;
+      bool const opponent_won = winner.value() != player;
       i32 const score = opponent_won ? -game_won_score : game_won_score;
       return MINMAX_Result{score, -1, -1};
     }
 
-    bool const draw = p.c.check_draw();
+    bool const draw = node.board.check_draw();
     if(draw) {
       return MINMAX_Result{0, -1, -1};
     }
   }
 
-  // Leaf node of our search.
-  if(p.depth >= p.max_depth) {
-    i32 const h = heuristic(p.c, p.player);
-    return MINMAX_Result{h, -1, -1};
+  // Solved position. The root has to produce a move, hence it is searched.
+  if(context.tablebase != nullptr && node.last_move != -1 &&
+     empty_squares(node.board) <= context.tablebase->depth) {
+    std::optional<u64> const payload =
+      context.tablebase->find(canonicalise(node.board).key);
+    if(payload) {
+      context.statistics.tablebase_hits += 1;
+      Tablebase_Entry const entry = unpack_tablebase_entry(payload.value());
+      return MINMAX_Result{tablebase_score(entry, maximising_player), -1, -1};
+    }
   }
 
-  Player const next_player = OPPONENT(p.turn);
-  State const player_state = PLAYER_TO_STATE(p.turn);
-  i32 alpha = p.alpha;
-  i32 beta = p.beta;
-  i32 best_x = -1;
-  i32 best_y = -1;
-  if(maximising_player) {
-    for(auto const [x, y]: board_order) {
-      if(p.c(x, y) != State::empty) {
-        continue;
+  i32 alpha = node.alpha;
+  i32 beta = node.beta;
+  i32 const remaining_depth = max_depth - node.depth;
+  u64 const key = node.hash.key();
+  // Best move of an earlier search of the position, searched first.
+  i32 hash_move = node.last_move == -1 ? context.root_move : -1;
+  // The root has to produce a move, hence it is always searched.
+  if(context.table != nullptr && node.last_move != -1) {
+    Transposition_Table_Statistics& statistics = context.statistics.table;
+    statistics.probes += 1;
+    Transposition_Entry entry;
+    bool const found = context.table->find(key, entry);
+    // Moves are not canonicalised, the move of a symmetric position is a
+    // different square.
+    if(found && node.hash.symmetries == 1) {
+      hash_move = entry.move;
+    }
+
+    if(found && entry.depth >= remaining_depth) {
+      statistics.hits += 1;
+      if(entry.bound == Bound::exact) {
+        statistics.cutoffs += 1;
+        statistics.nodes_saved += entry.nodes;
+        return MINMAX_Result{entry.value, -1, -1};
       }
 
-      MINMAX_Parameters m{.c = p.c,
-                          .player = p.player,
-                          .turn = next_player,
-                          .depth = p.depth + 1,
-                          .max_depth = p.max_depth,
-                          .alpha = alpha,
-                          .beta = beta};
-      m.c(x, y) = player_state;
-      MINMAX_Result const result = minmax_search(m);
-      if(result.value > alpha) {
-        alpha = result.value;
-        best_x = x;
-        best_y = y;
+      if(entry.bound == Bound::lower && entry.value > alpha) {
+        alpha = entry.value;
+      } else if(entry.bound == Bound::upper && entry.value < beta) {
+        beta = entry.value;
       }
 
       if(alpha >= beta) {
-        return MINMAX_Result{alpha, best_x, best_y};
+        statistics.cutoffs += 1;
+        statistics.nodes_saved += entry.nodes;
+        return MINMAX_Result{entry.value, -1, -1};
       }
     }
-    return MINMAX_Result{alpha, best_x, best_y};
-  } else {
-    for(auto const [x, y]: board_order) {
-      if(p.c(x, y) != State::empty) {
-        continue;
-      }
+  }
+
+  i64 const nodes_before = context.statistics.nodes;
+  auto const store = [&context, &node, key, remaining_depth,
+                      nodes_before](i32 const value, i32 const move) {
+    if(context.table == nullptr) {
+      return;
+    }
+
+    Bound bound = Bound::exact;
+    if(value <= node.alpha) {
+      bound = Bound::upper;
+    } else if(value >= node.beta) {
+      bound = Bound::lower;
+    }
+    i64 const nodes = context.statistics.nodes - nodes_before;
+    context.table->store(
+      key, Transposition_Entry{
+             .value = value,
+             .nodes = nodes < maximum_i32 ? (i32)nodes : maximum_i32,
+             .depth = remaining_depth,
+             .bound = bound,
+             .move = move,
+           });
+    context.statistics.table.stores += 1;
+  };
+
+  // Leaf node of our search.
+  if(node.depth >= max_depth) {
+    i32 const h = node.evaluation.value();
+    store(h, -1);
+    return MINMAX_Result{h, -1, -1};
+  }
+
+  // Order the moves by the hash move, the killer moves and the history
+  // scores, ties broken by board_order.
+  struct Move {
+    i32 index;
+    i64 score;
+  };
+
+  std::array<Move, 25> moves;
+  i32 move_count = 0;
+  std::array<i32, 2> const& killers = context.ordering.killers[node.depth];
+  std::array<i64, 25> const& history =
+    context.ordering.history[static_cast<i32>(node.turn)];
+  for(i32 i = 0; i < 25; i += 1) {
+    i32 const index = board_order_indices[i];
+    if(!node.board.is_empty(index)) {
+      continue;
+    }
+
+    i64 score = history[index] * 32 + (24 + context.tie_rotation - i) % 25;
+    if(index == hash_move) {
+      score = maximum_i64;
+    } else if(index == killers[0]) {
+      score = maximum_i64 - 2;
+    } else if(index == killers[1]) {
+      score = maximum_i64 - 3;
+    }
+
+    Move const move{index, score};
+    i32 j = move_count;
+    for(; j > 0 && moves[j - 1].score < score; j -= 1) {
+      moves[j] = moves[j - 1];
+    }
+    moves[j] = move;
+    move_count += 1;
+  }
 
-      MINMAX_Parameters m{.c = p.c,
-                          .player = p.player,
-                          .turn = next_player,
-                          .depth = p.depth + 1,
-                          .max_depth = p.max_depth,
-                          .alpha = alpha,
-                          .beta = beta};
-      m.c(x, y) = player_state;
-      MINMAX_Result const result = minmax_search(m);
+  Player const next_player = OPPONENT(node.turn);
+  i32 best_move = -1;
+  for(i32 i = 0; i < move_count; i += 1) {
+    i32 const index = moves[i].index;
+    Search_Node child{.board = node.board,
+                      .hash = node.hash,
+                      .evaluation = node.evaluation,
+                      .last_move = index,
+                      .turn = next_player,
+                      .depth = node.depth + 1,
+                      .alpha = alpha,
+                      .beta = beta};
+    child.board.place(index, node.turn);
+    child.hash.place(index, node.turn);
+    child.evaluation.place(child.board, index);
+    MINMAX_Result const result = search(context, child);
+    if(context.aborted) {
+      return MINMAX_Result{0, -1, -1};
+    }
+
+    if(maximising_player) {
+      if(result.value > alpha) {
+        alpha = result.value;
+        best_move = index;
+      }
+    } else {
       if(result.value < beta) {
         beta = result.value;
-        best_x = x;
-        best_y = y;
+        best_move = index;
       }
+    }
 
-      if(alpha >= beta) {
-        return MINMAX_Result{beta, best_x, best_y};
+    if(alpha >= beta) {
+      context.ordering.cutoff(index, node.turn, node.depth, remaining_depth);
+      break;
+    }
+  }
+
+  i32 const value = maximising_player ? alpha : beta;
+  store(value, best_move);
+  if(best_move == -1) {
+    return MINMAX_Result{value, -1, -1};
+  }
+  return MINMAX_Result{value, best_move % Bitboard::width,
+                       best_move / Bitboard::width};
+}
+
+MINMAX_Result minmax_search(MINMAX_Parameters const p) {
+  MINMAX_Statistics statistics;
+  Move_Ordering ordering;
+  if(p.table != nullptr) {
+    p.table->generation += 1;
+  }
+
+  Bitboard const board = p.c.to_bitboard();
+  Search_Context context{.player = p.player,
+                         .max_depth = p.max_depth,
+                         .table = p.table,
+                         .tablebase = side_to_move(board) == p.turn
+                                        ? p.tablebase
+                                        : nullptr,
+                         .statistics = statistics,
+                         .ordering = ordering,
+                         .root_move = -1,
+                         .deadline = std::nullopt,
+                         .stop = nullptr,
+                         .aborted = false,
+                         .tie_rotation = 0};
+  Search_Node const root{.board = board,
+                         .hash = Zobrist_Hash(board, p.turn, p.player,
+                                              p.symmetries),
+                         .evaluation = Evaluation(board, p.player, p.weights),
+                         .last_move = -1,
+                         .turn = p.turn,
+                         .depth = p.depth,
+                         .alpha = p.alpha,
+                         .beta = p.beta};
+  MINMAX_Result const result = search(context, root);
+  statistics.depth = p.max_depth - p.depth;
+  if(p.statistics != nullptr) {
+    *p.statistics = statistics;
+  }
+  return result;
+}
+
+// Deepening_Worker
+// A thread of iterative_deepening_search.
+//
+struct Deepening_Worker {
+  MINMAX_Result best{0, -1, -1};
+  MINMAX_Statistics statistics;
+};
+
+// deepen
+// Iterative deepening of a single thread. The helper threads start at depth 2
+// every other thread so that the threads spread over the depths, and share
+// their results only through the transposition table.
+//
+// Parameters:
+// helper - index of the helper thread or 0 for the main thread. Only the main
+//          thread completes its first iteration regardless of the deadline,
+//          the main thread is never stopped.
+//
+static void deepen(Iterative_Deepening_Parameters const& p,
+                   std::atomic<bool>& stop,
+                   std::chrono::steady_clock::time_point const start,
+                   i32 const helper, Deepening_Worker& worker) {
+  Move_Ordering ordering;
+  Bitboard const board = p.c.to_bitboard();
+  Search_Context context{.player = p.player,
+                         .max_depth = 0,
+                         .table = p.table,
+                         .tablebase = side_to_move(board) == p.player
+                                        ? p.tablebase
+                                        : nullptr,
+                         .statistics = worker.statistics,
+                         .ordering = ordering,
+                         .root_move = -1,
+                         .deadline = std::nullopt,
+                         .stop = &stop,
+                         .aborted = false,
+                         .tie_rotation = (helper * 7) % 25};
+  Search_Node const root{.board = board,
+                         .hash = Zobrist_Hash(board, p.player, p.player,
+                                              p.symmetries),
+                         .evaluation = Evaluation(board, p.player, p.weights),
+                         .last_move = -1,
+                         .turn = p.player,
+                         .depth = 0,
+                         .alpha = minimum_i32,
+                         .beta = maximum_i32};
+  i32 const first_depth = 1 + helper % 2;
+  // Every line ends within the depth, deeper iterations find nothing new.
+  i32 const last_depth =
+    std::min(p.max_depth, Bitboard::squares - std::popcount(board.occupied()));
+  for(i32 depth = first_depth; depth <= last_depth; depth += 1) {
+    if((helper != 0 || depth > 1) && p.time_budget_ms > 0) {
+      context.deadline = start + std::chrono::milliseconds(p.time_budget_ms);
+    }
+    context.max_depth = depth;
+    MINMAX_Result const result = search(context, root);
+    if(context.aborted) {
+      break;
+    }
+
+    worker.best = result;
+    worker.statistics.depth = depth;
+    context.root_move = result.x != -1 ? Bitboard::index(result.x, result.y)
+                                       : -1;
+  }
+}
+
+// probe_tables
+// Look the root up in the opening book and the tablebase.
+//
+// Returns:
+// The move of the book or the best move of the tablebase or std::nullopt if
+// the root is in neither.
+//
+[[nodiscard]] static std::optional<MINMAX_Result>
+probe_tables(Iterative_Deepening_Parameters const& p, Bitboard const& board) {
+  // Both tables assume the side to move is implied by the pieces.
+  if(side_to_move(board) != p.player) {
+    return std::nullopt;
+  }
+
+  i32 const played = Bitboard::squares - empty_squares(board);
+  if(p.book != nullptr && played < p.book->depth) {
+    Canonical_Position const canonical = canonicalise(board);
+    std::optional<u64> const move = p.book->find(canonical.key);
+    if(move) {
+      // The move is a square of the canonical image.
+      std::array<i32, 25> const& image = symmetry_squares[canonical.symmetry];
+      i32 const index = std::find(image.begin(), image.end(), (i32)*move) -
+                        image.begin();
+      if(index < Bitboard::squares && board.is_empty(index)) {
+        return MINMAX_Result{0, index % Bitboard::width,
+                             index / Bitboard::width};
       }
     }
-    return MINMAX_Result{beta, best_x, best_y};
   }
+
+  if(p.tablebase != nullptr && empty_squares(board) > 0 &&
+     empty_squares(board) <= p.tablebase->depth &&
+     !board.check_winner()) {
+    bool complete = true;
+    Solved_Move const solved =
+      solve_position(board, [&p, &complete](u64 const key) {
+        std::optional<u64> const payload = p.tablebase->find(key);
+        complete = complete && payload.has_value();
+        return payload ? unpack_tablebase_entry(payload.value())
+                       : Tablebase_Entry{};
+      });
+    if(complete) {
+      return MINMAX_Result{tablebase_score(solved.entry, true),
+                           solved.index % Bitboard::width,
+                           solved.index / Bitboard::width};
+    }
+  }
+
+  return std::nullopt;
+}
+
+MINMAX_Result iterative_deepening_search(
+  Iterative_Deepening_Parameters const p) {
+  std::optional<MINMAX_Result> const known =
+    probe_tables(p, p.c.to_bitboard());
+  if(known) {
+    if(p.statistics != nullptr) {
+      MINMAX_Statistics statistics;
+      statistics.book_move = true;
+      *p.statistics = statistics;
+    }
+    return known.value();
+  }
+
+  if(p.table != nullptr) {
+    p.table->generation += 1;
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+  std::atomic<bool> stop = false;
+  i32 const threads = std::max(p.threads, 1);
+  std::vector<Deepening_Worker> workers(threads);
+  std::vector<std::thread> helpers;
+  for(i32 helper = 1; helper < threads; helper += 1) {
+    helpers.emplace_back(deepen, std::cref(p), std::ref(stop), start, helper,
+                         std::ref(workers[helper]));
+  }
+  deepen(p, stop, start, 0, workers[0]);
+  stop.store(true, std::memory_order_relaxed);
+  for(std::thread& thread: helpers) {
+    thread.join();
+  }
+
+  // Play the move of the deepest completed iteration, preferring the main
+  // thread.
+  Deepening_Worker const* best = &workers[0];
+  MINMAX_Statistics statistics;
+  for(Deepening_Worker const& worker: workers) {
+    if(worker.best.x != -1 &&
+       worker.statistics.depth > best->statistics.depth) {
+      best = &worker;
+    }
+    statistics.nodes += worker.statistics.nodes;
+    statistics.tablebase_hits += worker.statistics.tablebase_hits;
+    statistics.table.accumulate(worker.statistics.table);
+  }
+  statistics.depth = best->statistics.depth;
+
+  if(p.statistics != nullptr) {
+    *p.statistics = statistics;
+  }
+  return best->best;
 }
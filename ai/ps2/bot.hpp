@@ -1,6 +1,9 @@
 #pragma once
 
 #include <configuration.hpp>
+#include <heuristic.hpp>
+#include <tablebase.hpp>
+#include <transposition_table.hpp>
 #include <types.hpp>
 
 struct MINMAX_Result {
@@ -11,6 +14,19 @@ struct MINMAX_Result {
   i32 y;
 };
 
+struct MINMAX_Statistics {
+  // Positions visited including the root.
+  i64 nodes = 0;
+  // Depth of the last completed search.
+  i32 depth = 0;
+  // Positions solved by the tablebase.
+  i64 tablebase_hits = 0;
+  // Whether the move has been taken from the opening book or the tablebase
+  // without a search.
+  bool book_move = false;
+  Transposition_Table_Statistics table;
+};
+
 struct MINMAX_Parameters {
   Configuration c;
   Player player;
@@ -19,7 +35,58 @@ struct MINMAX_Parameters {
   i32 max_depth;
   i32 alpha;
   i32 beta;
+  // Optional. Kept between the searches of a game.
+  Transposition_Table* table = nullptr;
+  // Whether the table shares the entries of symmetric positions.
+  bool symmetries = false;
+  Heuristic_Weights weights = {};
+  // Optional. Consulted for the positions with few empty squares.
+  Position_Table const* tablebase = nullptr;
+  // Optional. Written at the end of the search.
+  MINMAX_Statistics* statistics = nullptr;
 };
 
 [[nodiscard]] MINMAX_Result minmax_search(MINMAX_Parameters p);
 
+struct Iterative_Deepening_Parameters {
+  Configuration c;
+  // Player to move, the search maximises for them.
+  Player player;
+  i32 max_depth;
+  // Wall-clock time after which the search stops. 0 means no limit.
+  i64 time_budget_ms = 0;
+  // Number of threads searching the position concurrently over the shared
+  // table (Lazy SMP). Without a table the threads only duplicate the work.
+  i32 threads = 1;
+  // Optional. Kept between the searches of a game.
+  Transposition_Table* table = nullptr;
+  // Whether the table shares the entries of symmetric positions.
+  bool symmetries = false;
+  Heuristic_Weights weights = {};
+  // Optional. Consulted for the positions with few empty squares.
+  Position_Table const* tablebase = nullptr;
+  // Optional. Consulted for the root before searching.
+  Position_Table const* book = nullptr;
+  // Optional. Written at the end of the search.
+  MINMAX_Statistics* statistics = nullptr;
+};
+
+// iterative_deepening_search
+// Search to the depths 1, 2, ... up to max_depth or until the time budget is
+// exhausted. Every iteration searches the best move of the previous one first
+// and orders the remaining moves by the killer moves and the history scores
+// collected so far.
+//
+// With multiple threads every thread deepens on its own, starting at different
+// depths and breaking the ties of the move ordering differently, and the
+// threads pick up each other's results from the transposition table.
+//
+// The root is not searched when it is in the opening book or the tablebase.
+//
+// Returns:
+// The result of the deepest completed iteration. The first iteration always
+// completes regardless of the time budget.
+//
+[[nodiscard]] MINMAX_Result
+iterative_deepening_search(Iterative_Deepening_Parameters p);
+
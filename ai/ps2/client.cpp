@@ -42,22 +42,54 @@ static void print_board(Configuration const& c) {
   printf("\n");
 }
 
-void play_local(Player const human_player, i32 const max_depth) {
+static void print_statistics(MINMAX_Statistics const& statistics) {
+  if(statistics.book_move) {
+    printf("Move from the opening book or the tablebase\n");
+    return;
+  }
+
+  Transposition_Table_Statistics const& table = statistics.table;
+  printf("Depth: %d, nodes: %lld, table hits: %lld/%lld (%.1f%%), cutoffs: "
+         "%lld, nodes saved: %lld, tablebase hits: %lld\n",
+         statistics.depth, statistics.nodes, table.hits, table.probes,
+         table.probes > 0 ? 100.0 * table.hits / table.probes : 0.0,
+         table.cutoffs, table.nodes_saved, statistics.tablebase_hits);
+}
+
+// make_table
+//
+// Returns:
+// Transposition table requested by bot or std::nullopt if it is disabled.
+//
+static std::optional<Transposition_Table> make_table(Bot_Options const& bot) {
+  if(bot.table_bytes <= 0) {
+    return std::nullopt;
+  }
+  return Transposition_Table(bot.table_bytes);
+}
+
+void play_local(Player const human_player, Bot_Options const& bot) {
+  std::optional<Transposition_Table> table = make_table(bot);
+  MINMAX_Statistics statistics;
   Configuration c;
   print_board(c);
   Player const ai_player = OPPONENT(human_player);
   while(true) {
     {
-      MINMAX_Parameters p{
+      Iterative_Deepening_Parameters p{
         .c = c,
         .player = human_player,
-        .turn = human_player,
-        .depth = 0,
-        .max_depth = max_depth,
-        .alpha = minimum_i32,
-        .beta = maximum_i32,
+        .max_depth = bot.max_depth,
+        .time_budget_ms = bot.time_budget_ms,
+        .threads = bot.threads,
+        .table = table ? &table.value() : nullptr,
+        .symmetries = bot.symmetries,
+        .tablebase = bot.tablebase,
+        .book = bot.book,
+        .statistics = &statistics,
       };
-      MINMAX_Result const result = minmax_search(p);
+      MINMAX_Result const result = iterative_deepening_search(p);
+      print_statistics(statistics);
       c(result.x, result.y) = PLAYER_TO_STATE(human_player);
       print_board(c);
 
@@ -79,16 +111,20 @@ void play_local(Player const human_player, i32 const max_depth) {
       }
     }
     {
-      MINMAX_Parameters p{
+      Iterative_Deepening_Parameters p{
         .c = c,
         .player = ai_player,
-        .turn = ai_player,
-        .depth = 0,
-        .max_depth = max_depth,
-        .alpha = minimum_i32,
-        .beta = maximum_i32,
+        .max_depth = bot.max_depth,
+        .time_budget_ms = bot.time_budget_ms,
+        .threads = bot.threads,
+        .table = table ? &table.value() : nullptr,
+        .symmetries = bot.symmetries,
+        .tablebase = bot.tablebase,
+        .book = bot.book,
+        .statistics = &statistics,
       };
-      MINMAX_Result const result = minmax_search(p);
+      MINMAX_Result const result = iterative_deepening_search(p);
+      print_statistics(statistics);
       c(result.x, result.y) = PLAYER_TO_STATE(ai_player);
       print_board(c);
 
@@ -113,7 +149,7 @@ void play_local(Player const human_player, i32 const max_depth) {
 }
 
 void play_online(std::string_view const ip, std::string_view const port,
-                 Player const player, i32 const max_depth) {
+                 Player const player, Bot_Options const& bot) {
   // Author: Maciej Gębala
   // License: CC BY-NC 4.0
   // Modifications (Piotr Kocia):
@@ -163,6 +199,8 @@ void play_online(std::string_view const ip, std::string_view const port,
     return;
   }
 
+  std::optional<Transposition_Table> table = make_table(bot);
+  MINMAX_Statistics statistics;
   Configuration c;
   while(true) {
     memset(server_message, '\0', sizeof(server_message));
@@ -183,16 +221,20 @@ void play_online(std::string_view const ip, std::string_view const port,
     }
 
     if((kind == 0) || (kind == 6)) {
-      MINMAX_Parameters p{
+      Iterative_Deepening_Parameters p{
         .c = c,
         .player = player,
-        .turn = player,
-        .depth = 0,
-        .max_depth = max_depth,
-        .alpha = minimum_i32,
-        .beta = maximum_i32,
+        .max_depth = bot.max_depth,
+        .time_budget_ms = bot.time_budget_ms,
+        .threads = bot.threads,
+        .table = table ? &table.value() : nullptr,
+        .symmetries = bot.symmetries,
+        .tablebase = bot.tablebase,
+        .book = bot.book,
+        .statistics = &statistics,
       };
-      MINMAX_Result const result = minmax_search(p);
+      MINMAX_Result const result = iterative_deepening_search(p);
+      print_statistics(statistics);
       c(result.x, result.y) = PLAYER_TO_STATE(player);
       print_board(c);
 
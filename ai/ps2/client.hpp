@@ -1,9 +1,24 @@
 #pragma once
 
+#include <tablebase.hpp>
 #include <types.hpp>
 
 #include <string_view>
 
-void play_local(Player first_player, i32 max_depth);
+struct Bot_Options {
+  i32 max_depth = 0;
+  // Time of a single move after which the bot plays the best move of the
+  // deepest completed search. 0 means no limit.
+  i64 time_budget_ms = 0;
+  i32 threads = 1;
+  // Size of the transposition table kept over the game. 0 disables the table.
+  i64 table_bytes = 0;
+  bool symmetries = false;
+  // Optional. Mapped at startup and kept for the whole game.
+  Position_Table const* tablebase = nullptr;
+  Position_Table const* book = nullptr;
+};
+
+void play_local(Player first_player, Bot_Options const& bot);
 void play_online(std::string_view ip, std::string_view port, Player player,
-                 i32 max_depth);
+                 Bot_Options const& bot);
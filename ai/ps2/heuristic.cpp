@@ -1,316 +1,337 @@
 #include <heuristic.hpp>
 
-#include <span>
-#include <vector>
-
-static constexpr i32 score_open_cross = 200;
-static constexpr i32 score_closed_cross = 500;
-static constexpr i32 score_skew_cross = 1000;
-static constexpr i32 score_skew_right_cross = 1000;
-static constexpr i32 score_skew_left_cross = 1000;
-static constexpr i32 score_open_4 = 50;
-static constexpr i32 score_open_5 = -800;
-static constexpr i32 score_opponent_open_4 = 10000;
-static constexpr i32 score_opponent_open_5 = -300;
-static constexpr i32 score_opponent_closed_cross = 10000;
-static constexpr i32 score_opponent_open_cross = 1000;
-static constexpr i32 score_opponent_skew_cross = 10000;
-static constexpr i32 score_opponent_skew_right_cross = 10000;
-static constexpr i32 score_opponent_skew_left_cross = 10000;
+#include <array>
+#include <bit>
 
 // TODO: Open cross with an option to set up.
 
-i32 heuristic(Configuration const& c, Player const player) {
-  // Nomenclature:
-  // - open 4
-  //   3 pieces in a line separated by an empty square allowing to play
-  //   4-in-a-line.
-  //   Example: X|X| |X
-  // - open cross
-  //   2 pieces intersecting at a square with opponent's open 3.
-  //   Example:
-  //
-  // - open 5
-  //   Unfavourable position for us forcing us to play 3-in-a-line if things get
-  //   messy. Open 5 will be counted twice, hence we have to adjust its score
-  //   accordingly.
-  //   Example:
-  //   X| |X| |X
-  //
-  // We choose to be pessimistic in our approach and assume that the opponent is
-  // smart and will play to the best of their abilities. Therefore, we try to
-  // avoid single-move threats and try to prevent zugzwang on our side.
-  // - Positions which force us to place 3-in-a-line are highly unfavourable for
-  //   us and must be prevented at all cost. Those are the highest priority for
-  //   us.
-  // - Positions in which the opponent has an open 3 are equally disadvantageous
-  //   as they will result in our loss in the very next turn. Along with the
-  //   above, those are the highest priority for us.
-  // - Positions in which we have multiple threats are highly favourable for us
-  //   allowing us to attack from multiple sides and eventually win.
-  // - We do not want to block opponent's bad moves, e.g. placing 3 in a line.
-  // - Positions in which we have an open 3 are somewhat favourable, but we
-  //   assume the opponent will block our move the very next turn, hence we
-  //   score them 0.
-  // - If there are no immediate threats or better moves for us, we want to
-  //   block any attempts at setting up open 3s while ensuring we do not make
-  //   tragic moves ourselves.
-  // - We want to build up multiple 2-in-a-line as that expands our capabilities
-  //   to later play open 3s and set up threats.
-
-  Player const opponent = OPPONENT(player);
-  State const player_state = PLAYER_TO_STATE(player);
-  State const opponent_state = PLAYER_TO_STATE(opponent);
-  std::vector<Point> available_moves;
-  for(i32 y = 0; y < Configuration::height; y += 1) {
-    for(i32 x = 0; x < Configuration::width; x += 1) {
-      if(c(x, y) == State::empty) {
-        available_moves.push_back(Point{x, y});
+// Nomenclature:
+// - open 4
+//   3 pieces in a line separated by an empty square allowing to play
+//   4-in-a-line.
+//   Example: X|X| |X
+// - open cross
+//   2 pieces intersecting at a square with opponent's open 3.
+//   Example:
+//
+// - open 5
+//   Unfavourable position for us forcing us to play 3-in-a-line if things get
+//   messy. Open 5 will be counted twice, hence we have to adjust its score
+//   accordingly.
+//   Example:
+//   X| |X| |X
+//
+// We choose to be pessimistic in our approach and assume that the opponent is
+// smart and will play to the best of their abilities. Therefore, we try to
+// avoid single-move threats and try to prevent zugzwang on our side.
+// - Positions which force us to place 3-in-a-line are highly unfavourable for
+//   us and must be prevented at all cost. Those are the highest priority for
+//   us.
+// - Positions in which the opponent has an open 3 are equally disadvantageous
+//   as they will result in our loss in the very next turn. Along with the
+//   above, those are the highest priority for us.
+// - Positions in which we have multiple threats are highly favourable for us
+//   allowing us to attack from multiple sides and eventually win.
+// - We do not want to block opponent's bad moves, e.g. placing 3 in a line.
+// - Positions in which we have an open 3 are somewhat favourable, but we
+//   assume the opponent will block our move the very next turn, hence we
+//   score them 0.
+// - If there are no immediate threats or better moves for us, we want to
+//   block any attempts at setting up open 3s while ensuring we do not make
+//   tragic moves ourselves.
+// - We want to build up multiple 2-in-a-line as that expands our capabilities
+//   to later play open 3s and set up threats.
+//
+// Every pattern is matched around an empty square. A pattern consists of
+// squares relative to the empty one taken by one side, taken by the other side
+// or empty, and is matched in 16 orientations: the 8 rotations by 45deg, the
+// diagonal ones stretching the pattern along the diagonals, and their
+// reflections. The orientations of every pattern around every square that fit
+// on the board are precomputed as masks of the bitboard.
+
+enum struct Role : u8 {
+  // Pieces of the side whose pattern it is.
+  own,
+  // Pieces of the other side.
+  other,
+  empty,
+};
+
+struct Pattern_Element {
+  Role role;
+  i32 dx;
+  i32 dy;
+};
+
+// Pattern_Window
+// A single orientation of a pattern around a square.
+//
+struct Pattern_Window {
+  u32 own = 0;
+  u32 other = 0;
+  u32 empty = 0;
+
+  [[nodiscard]] bool matches(u32 const own_pieces, u32 const other_pieces,
+                             u32 const occupied) const {
+    return (own_pieces & own) == own && (other_pieces & other) == other &&
+           (occupied & empty) == 0;
+  }
+};
+
+// Pattern_Windows
+// Orientations of a pattern around a square that fit on the board. Duplicate
+// orientations are stored once.
+//
+struct Pattern_Windows {
+  std::array<Pattern_Window, 16> windows = {};
+  i32 count = 0;
+
+  [[nodiscard]] bool matches(u32 const own_pieces, u32 const other_pieces,
+                             u32 const occupied) const {
+    for(i32 i = 0; i < count; i += 1) {
+      if(windows[i].matches(own_pieces, other_pieces, occupied)) {
+        return true;
       }
     }
+    return false;
   }
+};
 
-  struct Pattern_Element {
-    State state;
-    i32 dx;
-    i32 dy;
-  };
+enum Pattern_Kind : i32 {
+  pattern_open_cross,
+  pattern_closed_cross,
+  pattern_skew_cross,
+  pattern_skew_left_cross,
+  pattern_skew_right_cross,
+  pattern_open_4,
+  pattern_open_5,
+  pattern_count,
+};
+
+using Pattern_Table =
+  std::array<std::array<Pattern_Windows, 25>, pattern_count>;
+
+template<i32 N>
+static constexpr void add_pattern(Pattern_Table& table, Pattern_Kind const kind,
+                                  Pattern_Element const (&pattern)[N]) {
+  constexpr i32 size = 5;
+  for(i32 y = 0; y < size; y += 1) {
+    for(i32 x = 0; x < size; x += 1) {
+      Pattern_Windows& windows = table[kind][y * size + x];
+      for(i32 orientation = 0; orientation < 16; orientation += 1) {
+        Pattern_Window window;
+        bool fits = true;
+        for(auto const [role, dx, dy]: pattern) {
+          Point const offsets[16] = {
+            {dx, dy},           {dx - dy, dx + dy},   {dy, dx},
+            {-dx - dy, dx - dy}, {-dx, -dy},          {-dx + dy, -dx - dy},
+            {-dy, -dx},         {dx + dy, -dx + dy},  {-dx, dy},
+            {-dx - dy, -dx + dy}, {dy, -dx},          {dx - dy, -dx - dy},
+            {dx, -dy},          {dx + dy, dx - dy},   {-dy, dx},
+            {-dx + dy, dx + dy},
+          };
+          i32 const px = x + offsets[orientation].x;
+          i32 const py = y + offsets[orientation].y;
+          if(px >= size || px < 0 || py >= size || py < 0) {
+            fits = false;
+            break;
+          }
+
+          u32 const bit = 1u << (py * size + px);
+          switch(role) {
+            case Role::own:
+              window.own |= bit;
+              break;
+            case Role::other:
+              window.other |= bit;
+              break;
+            case Role::empty:
+              window.empty |= bit;
+              break;
+          }
+        }
+        if(!fits) {
+          continue;
+        }
 
-  auto check_pattern =
-    [](Configuration const& c, i32 const x, i32 const y,
-       std::span<Pattern_Element const> const pattern) -> bool {
-#define CHECK_ROTATION(x_expr, y_expr)            \
-  {                                               \
-    bool found = true;                            \
-    for(auto const [state, dx, dy]: pattern) {    \
-      i32 const px = x + x_expr;                  \
-      i32 const py = y + y_expr;                  \
-      if(px >= Configuration::width || px < 0 ||  \
-         py >= Configuration::height || py < 0) { \
-        found = false;                            \
-        break;                                    \
-      }                                           \
-                                                  \
-      State const s = c(px, py);                  \
-      if(s != state) {                            \
-        found = false;                            \
-        break;                                    \
-      }                                           \
-    }                                             \
-    if(found) {                                   \
-      return true;                                \
-    }                                             \
+        bool duplicate = false;
+        for(i32 i = 0; i < windows.count; i += 1) {
+          Pattern_Window const& w = windows.windows[i];
+          if(w.own == window.own && w.other == window.other &&
+             w.empty == window.empty) {
+            duplicate = true;
+            break;
+          }
+        }
+        if(!duplicate) {
+          windows.windows[windows.count] = window;
+          windows.count += 1;
+        }
+      }
+    }
   }
-    // 0deg
-    CHECK_ROTATION(dx, dy);
-    // 45deg
-    CHECK_ROTATION(dx - dy, dx + dy);
-    // 90deg
-    CHECK_ROTATION(dy, dx);
-    // 135deg
-    CHECK_ROTATION(-dx - dy, dx - dy);
-    // 180deg
-    CHECK_ROTATION(-dx, -dy);
-    // 225deg
-    CHECK_ROTATION(-dx + dy, -dx - dy);
-    // 270deg
-    CHECK_ROTATION(-dy, -dx);
-    // 315deg
-    CHECK_ROTATION(dx + dy, -dx + dy);
-
-    // Horizontal reflection.
-    // 0deg
-    CHECK_ROTATION(-dx, dy);
-    // 45deg
-    CHECK_ROTATION(-dx - dy, -dx + dy);
-    // 90deg
-    CHECK_ROTATION(dy, -dx);
-    // 135deg
-    CHECK_ROTATION(dx - dy, -dx - dy);
-    // 180deg
-    CHECK_ROTATION(dx, -dy);
-    // 225deg
-    CHECK_ROTATION(dx + dy, dx - dy);
-    // 270deg
-    CHECK_ROTATION(-dy, dx);
-    // 315deg
-    CHECK_ROTATION(-dx + dy, dx + dy);
+}
 
-    return false;
-#undef CHECK_ROTATION
-  };
+static constexpr Pattern_Table pattern_table = [] {
+  using enum Role;
+  Pattern_Table table = {};
+  Pattern_Element const open_cross[] = {
+    {own, 0, 1}, {own, 0, 2}, {other, 1, 0}, {other, -1, 0}};
+  Pattern_Element const closed_cross[] = {
+    {own, 0, 1}, {own, 0, 2}, {own, 0, -1}, {other, 1, 0}, {other, -1, 0}};
+  Pattern_Element const skew_cross[] = {
+    {own, -1, -1}, {own, 1, 1}, {own, 2, 2}, {other, -1, 0}, {other, 1, 0}};
+  Pattern_Element const skew_left_cross[] = {
+    {own, -1, -1}, {own, 1, 1}, {own, 2, 2}, {other, -1, 0}, {other, -1, 0}};
+  Pattern_Element const skew_right_cross[] = {
+    {own, -1, -1}, {own, 1, 1}, {own, 2, 2}, {other, 1, 0}, {other, 2, 0}};
+  Pattern_Element const open_4[] = {{own, 2, 0}, {own, 1, 0}, {own, -1, 0}};
+  Pattern_Element const open_5[] = {
+    {own, -1, 0}, {own, 1, 0}, {empty, 2, 0}, {own, 3, 0}};
+  add_pattern(table, pattern_open_cross, open_cross);
+  add_pattern(table, pattern_closed_cross, closed_cross);
+  add_pattern(table, pattern_skew_cross, skew_cross);
+  add_pattern(table, pattern_skew_left_cross, skew_left_cross);
+  add_pattern(table, pattern_skew_right_cross, skew_right_cross);
+  add_pattern(table, pattern_open_4, open_4);
+  add_pattern(table, pattern_open_5, open_5);
+  return table;
+}();
 
-  Pattern_Element pattern_open_cross[] = {{player_state, 0, 1},
-                                          {player_state, 0, 2},
-                                          {opponent_state, 1, 0},
-                                          {opponent_state, -1, 0}};
-  Pattern_Element pattern_opponent_open_cross[] = {{opponent_state, 0, 1},
-                                                   {opponent_state, 0, 2},
-                                                   {player_state, 1, 0},
-                                                   {player_state, -1, 0}};
-  Pattern_Element pattern_closed_cross[] = {{player_state, 0, 1},
-                                            {player_state, 0, 2},
-                                            {player_state, 0, -1},
-                                            {opponent_state, 1, 0},
-                                            {opponent_state, -1, 0}};
-  Pattern_Element pattern_opponent_closed_cross[] = {{opponent_state, 0, 1},
-                                                     {opponent_state, 0, 2},
-                                                     {opponent_state, 0, -1},
-                                                     {player_state, 1, 0},
-                                                     {player_state, -1, 0}};
-  Pattern_Element pattern_skew_cross[] = {{player_state, -1, -1},
-                                          {player_state, 1, 1},
-                                          {player_state, 2, 2},
-                                          {opponent_state, -1, 0},
-                                          {opponent_state, 1, 0}};
-  Pattern_Element pattern_opponent_skew_cross[] = {{opponent_state, -1, -1},
-                                                   {opponent_state, 1, 1},
-                                                   {opponent_state, 2, 2},
-                                                   {player_state, -1, 0},
-                                                   {player_state, 1, 0}};
-  Pattern_Element pattern_skew_left_cross[] = {{player_state, -1, -1},
-                                               {player_state, 1, 1},
-                                               {player_state, 2, 2},
-                                               {opponent_state, -1, 0},
-                                               {opponent_state, -1, 0}};
-  Pattern_Element pattern_opponent_skew_left_cross[] = {
-    {opponent_state, -1, -1},
-    {opponent_state, 1, 1},
-    {opponent_state, 2, 2},
-    {player_state, -1, 0},
-    {player_state, -1, 0}};
-  Pattern_Element pattern_skew_right_cross[] = {{player_state, -1, -1},
-                                                {player_state, 1, 1},
-                                                {player_state, 2, 2},
-                                                {opponent_state, 1, 0},
-                                                {opponent_state, 2, 0}};
-  Pattern_Element pattern_opponent_skew_right_cross[] = {
-    {opponent_state, -1, -1},
-    {opponent_state, 1, 1},
-    {opponent_state, 2, 2},
-    {player_state, 1, 0},
-    {player_state, 2, 0}};
-  Pattern_Element pattern_open_4[] = {
-    {player_state, 2, 0},
-    {player_state, 1, 0},
-    {player_state, -1, 0},
-  };
-  Pattern_Element pattern_opponent_open_4[] = {
-    {opponent_state, 2, 0},
-    {opponent_state, 1, 0},
-    {opponent_state, -1, 0},
+i32 heuristic_square(Bitboard const& board, Player const player,
+                     i32 const index, Heuristic_Weights const& weights) {
+  u32 const mine = board.pieces[static_cast<i32>(player)];
+  u32 const theirs = board.pieces[static_cast<i32>(OPPONENT(player))];
+  u32 const occupied = mine | theirs;
+  auto const ours = [&](Pattern_Kind const kind) -> bool {
+    return pattern_table[kind][index].matches(mine, theirs, occupied);
   };
-  Pattern_Element pattern_open_5[] = {
-    {player_state, -1, 0},
-    {player_state, 1, 0},
-    {State::empty, 2, 0},
-    {player_state, 3, 0},
-  };
-  Pattern_Element pattern_opponent_open_5[] = {
-    {opponent_state, -1, 0},
-    {opponent_state, 1, 0},
-    {State::empty, 2, 0},
-    {opponent_state, 3, 0},
+  auto const opponents = [&](Pattern_Kind const kind) -> bool {
+    return pattern_table[kind][index].matches(theirs, mine, occupied);
   };
 
-  i32 score = 0;
-  for(auto const [x, y]: available_moves) {
-    bool const opponent_closed_cross =
-      check_pattern(c, x, y, pattern_opponent_closed_cross);
-    if(opponent_closed_cross) {
-      score -= score_opponent_closed_cross;
-      continue;
-    }
+  if(opponents(pattern_closed_cross)) {
+    return -weights.opponent_closed_cross;
+  }
 
-    bool const opponent_open_4 =
-      check_pattern(c, x, y, pattern_opponent_open_4);
-    if(opponent_open_4) {
-      score -= score_opponent_open_4;
-      continue;
-    }
+  if(opponents(pattern_open_4)) {
+    return -weights.opponent_open_4;
+  }
 
-    bool const opponent_skew_cross =
-      check_pattern(c, x, y, pattern_opponent_skew_cross);
-    if(opponent_skew_cross) {
-      score -= score_opponent_skew_cross;
-      continue;
-    }
+  if(opponents(pattern_skew_cross)) {
+    return -weights.opponent_skew_cross;
+  }
 
-    bool const opponent_skew_right_cross =
-      check_pattern(c, x, y, pattern_opponent_skew_right_cross);
-    if(opponent_skew_right_cross) {
-      score -= score_opponent_skew_right_cross;
-      continue;
-    }
+  if(opponents(pattern_skew_right_cross)) {
+    return -weights.opponent_skew_right_cross;
+  }
 
-    bool const opponent_skew_left_cross =
-      check_pattern(c, x, y, pattern_opponent_skew_left_cross);
-    if(opponent_skew_left_cross) {
-      score -= score_opponent_skew_left_cross;
-      continue;
-    }
+  if(opponents(pattern_skew_left_cross)) {
+    return -weights.opponent_skew_left_cross;
+  }
 
-    bool const skew_cross = check_pattern(c, x, y, pattern_skew_cross);
-    if(skew_cross) {
-      score -= score_skew_cross;
-      continue;
-    }
+  if(ours(pattern_skew_cross)) {
+    return -weights.skew_cross;
+  }
 
-    bool const skew_right_cross =
-      check_pattern(c, x, y, pattern_skew_right_cross);
-    if(skew_right_cross) {
-      score -= score_skew_right_cross;
-      continue;
-    }
+  if(ours(pattern_skew_right_cross)) {
+    return -weights.skew_right_cross;
+  }
 
-    bool const skew_left_cross =
-      check_pattern(c, x, y, pattern_skew_left_cross);
-    if(skew_left_cross) {
-      score -= score_skew_left_cross;
-      continue;
-    }
+  if(ours(pattern_skew_left_cross)) {
+    return -weights.skew_left_cross;
+  }
 
-    bool const closed_cross = check_pattern(c, x, y, pattern_closed_cross);
-    if(closed_cross) {
-      score += score_closed_cross;
-    }
+  i32 score = 0;
+  bool const closed_cross = ours(pattern_closed_cross);
+  if(closed_cross) {
+    score += weights.closed_cross;
+  }
 
-    if(!closed_cross) {
-      bool const open_cross = check_pattern(c, x, y, pattern_open_cross);
-      if(open_cross) {
-        score += score_open_cross;
-      }
+  if(!closed_cross) {
+    bool const open_cross = ours(pattern_open_cross);
+    if(open_cross) {
+      score += weights.open_cross;
     }
+  }
 
-    bool const opponent_open_cross =
-      check_pattern(c, x, y, pattern_opponent_open_cross);
-    if(opponent_open_cross) {
-      score -= score_opponent_open_cross;
-    }
+  if(opponents(pattern_open_cross)) {
+    score -= weights.opponent_open_cross;
+  }
 
-    bool const open_4 = check_pattern(c, x, y, pattern_open_4);
-    if(open_4) {
-      score += score_open_4;
-    }
+  if(ours(pattern_open_4)) {
+    score += weights.open_4;
+  }
 
-    bool const open_5 = check_pattern(c, x, y, pattern_open_5);
-    if(open_5) {
-      score -= score_open_5;
-    }
+  if(ours(pattern_open_5)) {
+    score -= weights.open_5;
+  }
 
-    bool const opponent_open_5 =
-      check_pattern(c, x, y, pattern_opponent_open_5);
-    if(opponent_open_5) {
-      score -= score_opponent_open_5;
-    }
+  if(opponents(pattern_open_5)) {
+    score -= weights.opponent_open_5;
   }
 
-  // std::vector<Point> player_reserve = calculate_reserve(player);
-  // std::vector<Point> opponent_reserve = calculate_reserve(OPPONENT(player));
-  // i32 common_reserve = 0;
+  return score;
+}
 
-  // i32 const score = player_weight * player_reserve.size() -
-  //                   opponent_weight * opponent_reserve.size() -
-  //                   common_weight * common_reserve;
+i32 heuristic(Bitboard const& board, Player const player,
+              Heuristic_Weights const& weights) {
+  i32 score = 0;
+  u32 empty = ~board.occupied() & Bitboard::full_mask;
+  while(empty != 0) {
+    i32 const index = std::countr_zero(empty);
+    empty &= empty - 1;
+    score += heuristic_square(board, player, index, weights);
+  }
   return score;
-}
\ No newline at end of file
+}
+
+i32 heuristic(Configuration const& c, Player const player,
+              Heuristic_Weights const& weights) {
+  return heuristic(c.to_bitboard(), player, weights);
+}
+
+// Squares whose windows contain a square, i.e. the squares whose score may
+// change when the square is taken.
+static constexpr std::array<u32, 25> dependents = [] {
+  std::array<u32, 25> dependents = {};
+  for(i32 kind = 0; kind < pattern_count; kind += 1) {
+    for(i32 index = 0; index < 25; index += 1) {
+      Pattern_Windows const& windows = pattern_table[kind][index];
+      for(i32 i = 0; i < windows.count; i += 1) {
+        Pattern_Window const& window = windows.windows[i];
+        u32 squares = window.own | window.other | window.empty;
+        while(squares != 0) {
+          dependents[std::countr_zero(squares)] |= 1u << index;
+          squares &= squares - 1;
+        }
+      }
+    }
+  }
+  return dependents;
+}();
+
+Evaluation::Evaluation(Bitboard const& board, Player const player,
+                       Heuristic_Weights const& weights)
+  : player(player), weights(&weights) {
+  u32 empty = ~board.occupied() & Bitboard::full_mask;
+  while(empty != 0) {
+    i32 const index = std::countr_zero(empty);
+    empty &= empty - 1;
+    scores[index] = heuristic_square(board, player, index, weights);
+    total += scores[index];
+  }
+}
+
+void Evaluation::place(Bitboard const& board, i32 const index) {
+  total -= scores[index];
+  scores[index] = 0;
+  u32 affected = dependents[index] & ~board.occupied();
+  while(affected != 0) {
+    i32 const square = std::countr_zero(affected);
+    affected &= affected - 1;
+    i32 const score = heuristic_square(board, player, square, *weights);
+    total += score - scores[square];
+    scores[square] = score;
+  }
+}
@@ -1,9 +1,78 @@
 #pragma once
 
+#include <bitboard.hpp>
 #include <configuration.hpp>
 #include <types.hpp>
 
+#include <array>
+
+// Heuristic_Weights
+// Scores of the patterns matched around the empty squares, see heuristic.cpp
+// for the patterns.
+//
+struct Heuristic_Weights {
+  i32 open_cross = 200;
+  i32 closed_cross = 500;
+  i32 skew_cross = 1000;
+  i32 skew_right_cross = 1000;
+  i32 skew_left_cross = 1000;
+  i32 open_4 = 50;
+  i32 open_5 = -800;
+  i32 opponent_open_4 = 10000;
+  i32 opponent_open_5 = -300;
+  i32 opponent_closed_cross = 10000;
+  i32 opponent_open_cross = 1000;
+  i32 opponent_skew_cross = 10000;
+  i32 opponent_skew_right_cross = 10000;
+  i32 opponent_skew_left_cross = 10000;
+};
+
+inline constexpr Heuristic_Weights default_heuristic_weights;
+
 // heuristic
 // Calculate favourability of a position for player.
 //
-[[nodiscard]] i32 heuristic(Configuration const& c, Player player);
+[[nodiscard]] i32
+heuristic(Configuration const& c, Player player,
+          Heuristic_Weights const& weights = default_heuristic_weights);
+[[nodiscard]] i32
+heuristic(Bitboard const& board, Player player,
+          Heuristic_Weights const& weights = default_heuristic_weights);
+
+// heuristic_square
+// Contribution of the empty square at index to heuristic.
+//
+[[nodiscard]] i32 heuristic_square(Bitboard const& board, Player player,
+                                   i32 index,
+                                   Heuristic_Weights const& weights);
+
+// Evaluation
+// heuristic of a position maintained incrementally as pieces are placed. The
+// score of an empty square depends only on the squares of the patterns around
+// it, hence a placed piece rescores only the few empty squares whose patterns
+// cover it.
+//
+struct Evaluation {
+public:
+  // Scores of the squares, 0 for the occupied ones.
+  std::array<i32, 25> scores = {};
+  i32 total = 0;
+  Player player;
+  // Must outlive the evaluation.
+  Heuristic_Weights const* weights;
+
+public:
+  Evaluation(Bitboard const& board, Player player,
+             Heuristic_Weights const& weights = default_heuristic_weights);
+
+  // place
+  //
+  // Parameters:
+  // board - position after a piece has been placed at index.
+  //
+  void place(Bitboard const& board, i32 index);
+
+  [[nodiscard]] i32 value() const {
+    return total;
+  }
+};
@@ -0,0 +1,726 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <bitboard.hpp>
+#include <types.hpp>
+
+// A server speaking the protocol of ttt_server that plays any number of games
+// at once. Every connection is a non-blocking socket registered with a single
+// epoll instance, the clients introduce themselves with the ID they want to
+// play as and wait in the lobby until a client with the other ID arrives.
+//
+// The protocol, as seen by ttt_client:
+// - the server greets the client with 700 and the client answers with its ID,
+//   1 for X or 2 for O,
+// - X is sent 600 and makes the first move,
+// - every move is sent as a 2 digit number, the column and the row counting
+//   from 1, and is forwarded to the opponent who answers with their move,
+// - a move ending the game is forwarded with the outcome for the opponent
+//   added, 100 won, 200 lost, 300 draw, and the mover is sent the outcome
+//   alone,
+// - an invalid move, a move not made in time or a lost connection end the
+//   game with 500 sent to the culprit and 400 to the opponent.
+
+enum Message : i32 {
+  message_won = 100,
+  message_lost = 200,
+  message_draw = 300,
+  message_opponent_error = 400,
+  message_error = 500,
+  message_start = 600,
+  message_greeting = 700,
+};
+
+enum struct Connection_State {
+  // Greeted, the ID has not been received yet.
+  greeting,
+  // In the lobby.
+  waiting,
+  playing,
+  closed,
+};
+
+struct Connection {
+  i32 fd = -1;
+  Connection_State state = Connection_State::closed;
+  i32 game = -1;
+  Player player = Player::x;
+  // Incremented whenever the timer of the connection is armed or disarmed.
+  // Timers of other generations are stale.
+  u32 generation = 0;
+  // The protocol has no delimiters, every read is a single message. Bytes
+  // sent out of turn are kept until the turn of the client.
+  char buffer[16] = {};
+  i32 buffered = 0;
+  // When the client has been asked to move.
+  i64 turn_start_ns = 0;
+};
+
+struct Game {
+  // Connections of X and O.
+  std::array<i32, 2> connections = {-1, -1};
+  Bitboard board;
+  Player turn = Player::x;
+};
+
+// Timer_Wheel
+// Deadlines of the connections hashed into slots by the tick they expire at.
+// Timers are never removed, a timer whose generation does not match its
+// connection anymore is dropped once its slot comes due. Deadlines further
+// than a revolution away stay in their slot until the right revolution.
+//
+struct Timer_Wheel {
+  static constexpr i64 tick_ms = 10;
+  static constexpr i32 slot_count = 256;
+
+  struct Timer {
+    i32 connection;
+    u32 generation;
+    i64 tick;
+  };
+
+  std::array<std::vector<Timer>, slot_count> slots;
+  // Last tick whose slot has been processed.
+  i64 current = 0;
+
+  void add(i32 const connection, u32 const generation, i64 tick) {
+    if(tick <= current) {
+      tick = current + 1;
+    }
+    slots[tick % slot_count].push_back(
+      Timer{.connection = connection, .generation = generation, .tick = tick});
+  }
+
+  // advance
+  // Process the slots up to tick.
+  //
+  // Parameters:
+  // expire - invoked as expire(connection, generation) for every timer that
+  //          is due. May add timers.
+  //
+  template<typename Expire>
+  void advance(i64 const tick, Expire&& expire) {
+    while(current < tick) {
+      current += 1;
+      std::vector<Timer>& slot = slots[current % slot_count];
+      std::vector<Timer> timers;
+      timers.swap(slot);
+      for(Timer const& timer: timers) {
+        if(timer.tick > current) {
+          slot.push_back(timer);
+        } else {
+          expire(timer.connection, timer.generation);
+        }
+      }
+    }
+  }
+};
+
+struct Server_Statistics {
+  i64 games_started = 0;
+  i64 games_finished = 0;
+  i64 moves = 0;
+  i64 invalid_moves = 0;
+  i64 timeouts = 0;
+  i64 disconnects = 0;
+  // Move latencies, the time between asking a client to move and receiving
+  // the move, bucketed by powers of 2 of microseconds. Bucket 0 counts the
+  // latencies below 1us, bucket i the ones in [2^(i-1), 2^i).
+  std::array<i64, 40> latency_histogram = {};
+};
+
+struct Server {
+  i32 epoll_fd = -1;
+  i32 listen_fd = -1;
+  // 0 disables the timeouts.
+  i64 move_timeout_ms = 0;
+  std::vector<Connection> connections;
+  std::vector<i32> free_connections;
+  std::vector<Game> games;
+  std::vector<i32> free_games;
+  // Clients waiting for an opponent by their ID.
+  std::array<std::deque<i32>, 2> lobby;
+  Timer_Wheel wheel;
+  Server_Statistics statistics;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Key of the listening socket in the epoll events. The connections are keyed
+// by their index.
+static constexpr u64 listen_key = ~0ULL;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(int) {
+  stop_requested = 1;
+}
+
+[[nodiscard]] static i64 elapsed_ns(Server const& server) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - server.start)
+    .count();
+}
+
+// parse_message
+//
+// Returns:
+// The leading decimal number of the message or 0 if there is none, the way
+// ttt_server reads the messages with atoi.
+//
+[[nodiscard]] static i32 parse_message(char const* const buffer,
+                                       i32 const size) {
+  i32 value = 0;
+  std::from_chars(buffer, buffer + size, value);
+  return value;
+}
+
+static void send_message(Server& server, i32 const connection,
+                         i32 const message) {
+  char text[16];
+  i32 const length = snprintf(text, sizeof(text), "%d", message);
+  // The messages are a few bytes and every client has at most one unanswered
+  // message, a failing send means the connection is gone, which is noticed
+  // when reading from it.
+  (void)send(server.connections[connection].fd, text, length, MSG_NOSIGNAL);
+}
+
+static void arm_timer(Server& server, i32 const connection) {
+  Connection& c = server.connections[connection];
+  c.generation += 1;
+  if(server.move_timeout_ms <= 0) {
+    return;
+  }
+  i64 const now_ms = elapsed_ns(server) / 1'000'000;
+  server.wheel.add(connection, c.generation,
+                   (now_ms + server.move_timeout_ms + Timer_Wheel::tick_ms -
+                    1) / Timer_Wheel::tick_ms);
+}
+
+static void close_connection(Server& server, i32 const connection) {
+  Connection& c = server.connections[connection];
+  if(c.state == Connection_State::waiting) {
+    std::deque<i32>& queue = server.lobby[static_cast<i32>(c.player)];
+    for(auto i = queue.begin(); i != queue.end(); ++i) {
+      if(*i == connection) {
+        queue.erase(i);
+        break;
+      }
+    }
+  }
+  close(c.fd);
+  c.fd = -1;
+  c.state = Connection_State::closed;
+  c.game = -1;
+  c.generation += 1;
+  c.buffered = 0;
+  server.free_connections.push_back(connection);
+}
+
+static void finish_game(Server& server, i32 const game) {
+  for(i32 const connection: server.games[game].connections) {
+    close_connection(server, connection);
+  }
+  server.free_games.push_back(game);
+  server.statistics.games_finished += 1;
+}
+
+// forfeit
+// End the game of connection with a loss of connection.
+//
+static void forfeit(Server& server, i32 const connection) {
+  Connection const& c = server.connections[connection];
+  Game const& g = server.games[c.game];
+  i32 const opponent = g.connections[static_cast<i32>(OPPONENT(c.player))];
+  send_message(server, opponent, message_opponent_error);
+  send_message(server, connection, message_error);
+  finish_game(server, c.game);
+}
+
+static void process(Server& server, i32 connection);
+
+static void begin_turn(Server& server, i32 const game) {
+  Game const& g = server.games[game];
+  i32 const connection = g.connections[static_cast<i32>(g.turn)];
+  server.connections[connection].turn_start_ns = elapsed_ns(server);
+  arm_timer(server, connection);
+  // The client might have sent its move already.
+  process(server, connection);
+}
+
+static void play_move(Server& server, i32 const connection, i32 const move) {
+  Connection& c = server.connections[connection];
+  i32 const game = c.game;
+  Game& g = server.games[game];
+  i32 const opponent = g.connections[static_cast<i32>(OPPONENT(c.player))];
+
+  i64 const latency_us = (elapsed_ns(server) - c.turn_start_ns) / 1000;
+  i32 bucket = 0;
+  while(bucket + 1 < (i32)server.statistics.latency_histogram.size() &&
+        (1LL << bucket) <= latency_us) {
+    bucket += 1;
+  }
+  server.statistics.latency_histogram[bucket] += 1;
+  server.statistics.moves += 1;
+
+  i32 const x = move / 10 - 1;
+  i32 const y = move % 10 - 1;
+  if(x < 0 || x >= Bitboard::width || y < 0 || y >= Bitboard::height ||
+     !g.board.is_empty(Bitboard::index(x, y))) {
+    server.statistics.invalid_moves += 1;
+    forfeit(server, connection);
+    return;
+  }
+
+  i32 const index = Bitboard::index(x, y);
+  g.board.place(index, c.player);
+  std::optional<Player> const winner = g.board.check_move(index, c.player);
+  if(winner) {
+    bool const won = winner.value() == c.player;
+    send_message(server, opponent, (won ? message_lost : message_won) + move);
+    send_message(server, connection, won ? message_won : message_lost);
+    finish_game(server, game);
+    return;
+  }
+
+  if(g.board.check_draw()) {
+    send_message(server, opponent, message_draw + move);
+    send_message(server, connection, message_draw);
+    finish_game(server, game);
+    return;
+  }
+
+  send_message(server, opponent, move);
+  // The mover waits for the reply of the opponent without a deadline.
+  c.generation += 1;
+  g.turn = OPPONENT(g.turn);
+  begin_turn(server, game);
+}
+
+static void start_games(Server& server) {
+  std::array<std::deque<i32>, 2>& lobby = server.lobby;
+  while(!lobby[0].empty() && !lobby[1].empty()) {
+    i32 game = 0;
+    if(server.free_games.empty()) {
+      game = server.games.size();
+      server.games.emplace_back();
+    } else {
+      game = server.free_games.back();
+      server.free_games.pop_back();
+    }
+
+    Game& g = server.games[game];
+    g = Game{};
+    for(i32 i = 0; i < 2; i += 1) {
+      i32 const connection = lobby[i].front();
+      lobby[i].pop_front();
+      g.connections[i] = connection;
+      server.connections[connection].state = Connection_State::playing;
+      server.connections[connection].game = game;
+    }
+    server.statistics.games_started += 1;
+
+    send_message(server, g.connections[0], message_start);
+    begin_turn(server, game);
+  }
+}
+
+// process
+// Act on the message buffered by connection if it is expected.
+//
+static void process(Server& server, i32 const connection) {
+  Connection& c = server.connections[connection];
+  if(c.buffered == 0) {
+    return;
+  }
+
+  if(c.state == Connection_State::greeting) {
+    i32 const id = parse_message(c.buffer, c.buffered);
+    c.buffered = 0;
+    if(id != 1 && id != 2) {
+      close_connection(server, connection);
+      return;
+    }
+
+    c.state = Connection_State::waiting;
+    c.player = static_cast<Player>(id - 1);
+    // No deadline in the lobby.
+    c.generation += 1;
+    server.lobby[id - 1].push_back(connection);
+    start_games(server);
+  } else if(c.state == Connection_State::playing &&
+            server.games[c.game].turn == c.player) {
+    i32 const move = parse_message(c.buffer, c.buffered);
+    c.buffered = 0;
+    play_move(server, connection, move);
+  }
+}
+
+static void accept_connections(Server& server) {
+  while(true) {
+    i32 const fd = accept4(server.listen_fd, nullptr, nullptr, SOCK_NONBLOCK);
+    if(fd < 0) {
+      if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        printf("warning: accept failed: %s\n", strerror(errno));
+      }
+      return;
+    }
+
+    i32 const no_delay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+    i32 connection = 0;
+    if(server.free_connections.empty()) {
+      connection = server.connections.size();
+      server.connections.emplace_back();
+    } else {
+      connection = server.free_connections.back();
+      server.free_connections.pop_back();
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.u64 = connection;
+    if(epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+      printf("warning: epoll_ctl failed: %s\n", strerror(errno));
+      close(fd);
+      server.free_connections.push_back(connection);
+      continue;
+    }
+
+    Connection& c = server.connections[connection];
+    c.fd = fd;
+    c.state = Connection_State::greeting;
+    c.game = -1;
+    c.buffered = 0;
+    send_message(server, connection, message_greeting);
+    arm_timer(server, connection);
+  }
+}
+
+// disconnect
+// Handle the loss of connection.
+//
+static void disconnect(Server& server, i32 const connection) {
+  Connection const& c = server.connections[connection];
+  if(c.state == Connection_State::playing) {
+    server.statistics.disconnects += 1;
+    forfeit(server, connection);
+  } else {
+    close_connection(server, connection);
+  }
+}
+
+static void receive(Server& server, i32 const connection) {
+  while(true) {
+    Connection& c = server.connections[connection];
+    if(c.state == Connection_State::closed) {
+      return;
+    }
+
+    i32 const capacity = sizeof(c.buffer) - c.buffered;
+    if(capacity == 0) {
+      // Not a message of the protocol.
+      disconnect(server, connection);
+      return;
+    }
+
+    ssize_t const size = recv(c.fd, c.buffer + c.buffered, capacity, 0);
+    if(size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    }
+    if(size < 0 && errno == EINTR) {
+      continue;
+    }
+    if(size <= 0) {
+      disconnect(server, connection);
+      return;
+    }
+
+    c.buffered += size;
+    process(server, connection);
+  }
+}
+
+static void expire(Server& server, i32 const connection,
+                   u32 const generation) {
+  Connection const& c = server.connections[connection];
+  if(c.state == Connection_State::closed || c.generation != generation) {
+    return;
+  }
+
+  server.statistics.timeouts += 1;
+  if(c.state == Connection_State::playing) {
+    forfeit(server, connection);
+  } else {
+    close_connection(server, connection);
+  }
+}
+
+static void print_progress(Server const& server, double const seconds,
+                           i64 const interval_games,
+                           double const interval_seconds) {
+  Server_Statistics const& s = server.statistics;
+  printf("%.1fs: %lld games finished (%.1f games/s), %lld in progress, %lld "
+         "moves, %lld invalid, %lld timeouts, %lld disconnects\n",
+         seconds, s.games_finished,
+         interval_seconds > 0 ? interval_games / interval_seconds : 0.0,
+         s.games_started - s.games_finished, s.moves, s.invalid_moves,
+         s.timeouts, s.disconnects);
+}
+
+static void print_histogram(Server_Statistics const& statistics) {
+  std::array<i64, 40> const& histogram = statistics.latency_histogram;
+  i64 largest = 0;
+  for(i64 const count: histogram) {
+    largest = std::max(largest, count);
+  }
+  if(largest == 0) {
+    return;
+  }
+
+  printf("move latency (us):\n");
+  for(i32 bucket = 0; bucket < (i32)histogram.size(); bucket += 1) {
+    if(histogram[bucket] == 0) {
+      continue;
+    }
+
+    i64 const low = bucket == 0 ? 0 : 1LL << (bucket - 1);
+    i64 const high = 1LL << bucket;
+    printf("  [%8lld, %8lld) %10lld ", low, high, histogram[bucket]);
+    for(i64 i = 0; i < 40 * histogram[bucket] / largest; i += 1) {
+      printf("#");
+    }
+    printf("\n");
+  }
+}
+
+static void help(char const* const name) {
+  printf("Usage: %s [OPTION]... IP PORT\n", name);
+  printf("\n");
+  printf("  IP - IPv4 to listen on.\n");
+  printf("  PORT - Port to listen on.\n");
+  printf("\n");
+  printf(
+    "Serve any number of concurrent games to ttt_client. Clients wait in the "
+    "lobby until a client with the other ID connects.\n");
+  printf("\n");
+  printf("OPTIONS\n");
+  printf("  -h, --help\n");
+  printf("    Display the help page.\n");
+  printf("  -t, --move-timeout MILLISECONDS\n");
+  printf(
+    "    Time a client has to introduce itself or to make a move before it "
+    "loses. 0 disables the limit. Defaults to 10000.\n");
+  printf("  -r, --report-interval SECONDS\n");
+  printf(
+    "    Print the games/sec and the counters every given number of seconds. 0 "
+    "disables the reports. Defaults to 10.\n");
+  printf("  -g, --games N\n");
+  printf("    Exit after N finished games. Defaults to serving until "
+         "interrupted.\n");
+}
+
+struct Arguments {
+  bool help = false;
+  i64 move_timeout_ms = 10'000;
+  i64 report_interval_s = 10;
+  i64 games = 0;
+  char const* ip = nullptr;
+  char const* port = nullptr;
+};
+
+static std::optional<Arguments> parse_arguments(i32 const argc,
+                                                char const* const* const argv) {
+  Arguments arguments;
+  i32 i = 1;
+  while(i < argc) {
+    std::string_view const option(argv[i]);
+    if(option == "-h" || option == "--help") {
+      arguments.help = true;
+      return arguments;
+    }
+
+    i64* target = nullptr;
+    if(option == "-t" || option == "--move-timeout") {
+      target = &arguments.move_timeout_ms;
+    } else if(option == "-r" || option == "--report-interval") {
+      target = &arguments.report_interval_s;
+    } else if(option == "-g" || option == "--games") {
+      target = &arguments.games;
+    } else {
+      // Not an option. End parsing.
+      if(!option.starts_with("-")) {
+        break;
+      }
+
+      printf("warning: unrecognised option: %s\n", argv[i]);
+      i += 1;
+      continue;
+    }
+
+    if(i + 1 >= argc) {
+      printf("error: missing mandatory argument to %s\n", argv[i]);
+      return std::nullopt;
+    }
+
+    std::string_view const value(argv[i + 1]);
+    auto const [end, error] =
+      std::from_chars(value.data(), value.data() + value.size(), *target);
+    if(error != std::errc() || end != value.data() + value.size() ||
+       *target < 0) {
+      printf("error: argument to %s must be a non-negative number: %s\n",
+             argv[i], argv[i + 1]);
+      return std::nullopt;
+    }
+    i += 2;
+  }
+
+  if(i >= argc) {
+    printf("error: missing IP argument\n");
+    return std::nullopt;
+  }
+  arguments.ip = argv[i];
+  i += 1;
+
+  if(i >= argc) {
+    printf("error: missing PORT argument\n");
+    return std::nullopt;
+  }
+  arguments.port = argv[i];
+  return arguments;
+}
+
+constexpr i32 RETURN_HELP = 2;
+constexpr i32 RETURN_SUCCESS = 0;
+constexpr i32 RETURN_FAILURE = 1;
+
+int main(int const argc, char const* const* const argv) {
+  std::optional<Arguments> const result = parse_arguments(argc, argv);
+  if(!result) {
+    return RETURN_FAILURE;
+  }
+
+  Arguments const& arguments = result.value();
+  if(arguments.help) {
+    help(argv[0]);
+    return RETURN_HELP;
+  }
+
+  Server server;
+  server.move_timeout_ms = arguments.move_timeout_ms;
+  server.listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if(server.listen_fd < 0) {
+    printf("Error while creating socket\n");
+    return RETURN_FAILURE;
+  }
+
+  i32 const reuse = 1;
+  setsockopt(server.listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse,
+             sizeof(reuse));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(atoi(arguments.port));
+  address.sin_addr.s_addr = inet_addr(arguments.ip);
+  if(bind(server.listen_fd, (sockaddr*)&address, sizeof(address)) < 0) {
+    printf("Couldn't bind to the port\n");
+    return RETURN_FAILURE;
+  }
+
+  if(listen(server.listen_fd, SOMAXCONN) < 0) {
+    printf("Error while listening\n");
+    return RETURN_FAILURE;
+  }
+
+  server.epoll_fd = epoll_create1(0);
+  if(server.epoll_fd < 0) {
+    printf("Error while creating epoll instance\n");
+    return RETURN_FAILURE;
+  }
+
+  epoll_event listen_event = {};
+  listen_event.events = EPOLLIN;
+  listen_event.data.u64 = listen_key;
+  if(epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.listen_fd,
+               &listen_event) < 0) {
+    printf("Error while registering the socket\n");
+    return RETURN_FAILURE;
+  }
+
+  // Without SA_RESTART, so that epoll_wait returns on the signals.
+  struct sigaction action = {};
+  action.sa_handler = request_stop;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  printf("Listening on %s:%s\n", arguments.ip, arguments.port);
+  server.start = std::chrono::steady_clock::now();
+  i64 const report_interval_ns = arguments.report_interval_s * 1'000'000'000;
+  i64 next_report_ns = report_interval_ns;
+  i64 reported_games = 0;
+  std::array<epoll_event, 256> events;
+  while(stop_requested == 0) {
+    i32 const count = epoll_wait(server.epoll_fd, events.data(), events.size(),
+                                 Timer_Wheel::tick_ms);
+    if(count < 0 && errno != EINTR) {
+      printf("Error while waiting for events: %s\n", strerror(errno));
+      return RETURN_FAILURE;
+    }
+
+    for(i32 i = 0; i < count; i += 1) {
+      if(events[i].data.u64 == listen_key) {
+        accept_connections(server);
+      } else {
+        receive(server, events[i].data.u64);
+      }
+    }
+
+    i64 const now_ns = elapsed_ns(server);
+    server.wheel.advance(now_ns / 1'000'000 / Timer_Wheel::tick_ms,
+                         [&server](i32 const connection, u32 const generation) {
+                           expire(server, connection, generation);
+                         });
+
+    if(report_interval_ns > 0 && now_ns >= next_report_ns) {
+      print_progress(server, now_ns / 1e9,
+                     server.statistics.games_finished - reported_games,
+                     arguments.report_interval_s);
+      reported_games = server.statistics.games_finished;
+      next_report_ns += report_interval_ns;
+    }
+
+    if(arguments.games > 0 &&
+       server.statistics.games_finished >= arguments.games) {
+      break;
+    }
+  }
+
+  double const seconds = elapsed_ns(server) / 1e9;
+  print_progress(server, seconds, server.statistics.games_finished, seconds);
+  print_histogram(server.statistics);
+
+  for(Connection const& c: server.connections) {
+    if(c.state != Connection_State::closed) {
+      close(c.fd);
+    }
+  }
+  close(server.listen_fd);
+  close(server.epoll_fd);
+  return RETURN_SUCCESS;
+}
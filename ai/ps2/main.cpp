@@ -1,5 +1,6 @@
 #include <types.hpp>
 
+#include <charconv>
 #include <optional>
 #include <string_view>
 
@@ -8,6 +9,8 @@
 
 #include <client.hpp>
 
+static constexpr i64 default_table_bytes = 16 << 20;
+
 static void help(char const* const name) {
   printf("Usage: %s [OPTION]... IP PORT ID DEPTH\n", name);
   printf("\n");
@@ -15,6 +18,7 @@ static void help(char const* const name) {
   printf("  PORT - Port of the server.\n");
   printf("  ID - The ID of the player (1 or 2).\n");
   printf("  DEPTH - The maximum search depth of the minmax (1 through 10).\n");
+  printf("          The bot deepens the search iteratively up to DEPTH.\n");
   printf("\n");
   printf("OPTIONS\n");
   printf("  -h, --help\n");
@@ -23,11 +27,42 @@ static void help(char const* const name) {
   printf(
     "    Do not attempt to connect to the server, instead play locally via "
     "tui.\n");
+  printf("  -b, --time-budget MILLISECONDS\n");
+  printf(
+    "    Stop deepening the search after the given time and play the best move "
+    "of the deepest completed search. Defaults to no limit.\n");
+  printf("  -j, --threads N\n");
+  printf(
+    "    Number of threads searching each move over the shared transposition "
+    "table. Defaults to 1.\n");
+  printf("  -t, --tt-memory SIZE\n");
+  printf(
+    "    Size of the transposition table in bytes. Accepts K, M and G "
+    "suffixes, 0 disables the table. Defaults to %lldM.\n",
+    default_table_bytes >> 20);
+  printf("  --symmetries\n");
+  printf(
+    "    Share the transposition table entries of positions symmetric under "
+    "rotations and reflections of the board.\n");
+  printf("  --tablebase PATH\n");
+  printf(
+    "    Map the tablebase generated by ttt_tablebase and look up the "
+    "positions with few empty squares instead of searching them.\n");
+  printf("  --book PATH\n");
+  printf(
+    "    Map the opening book generated by ttt_tablebase and play its moves "
+    "in the first plies without searching.\n");
 }
 
 struct Options {
   bool help = false;
   bool local = false;
+  i64 time_budget_ms = 0;
+  i32 threads = 1;
+  i64 table_bytes = default_table_bytes;
+  bool symmetries = false;
+  char const* tablebase_path = nullptr;
+  char const* book_path = nullptr;
 };
 
 struct Arguments {
@@ -38,6 +73,39 @@ struct Arguments {
   i32 depth = 0;
 };
 
+// parse_size
+// Parse a non-negative decimal number of bytes optionally followed by a K, M
+// or G binary suffix.
+//
+// Returns:
+// The number of bytes or std::nullopt if string is not a valid size.
+//
+static std::optional<i64> parse_size(std::string_view const string) {
+  i64 value = 0;
+  auto const [end, error] =
+    std::from_chars(string.data(), string.data() + string.size(), value);
+  if(error != std::errc() || value < 0) {
+    return std::nullopt;
+  }
+
+  std::string_view const suffix(end, string.data() + string.size());
+  i32 shift = 0;
+  if(suffix == "K") {
+    shift = 10;
+  } else if(suffix == "M") {
+    shift = 20;
+  } else if(suffix == "G") {
+    shift = 30;
+  } else if(suffix.size() > 0) {
+    return std::nullopt;
+  }
+
+  if(value > (maximum_i64 >> shift)) {
+    return std::nullopt;
+  }
+  return value << shift;
+}
+
 std::optional<Arguments> parse_arguments(i32 const argc,
                                          char const* const* const argv) {
   Arguments arguments;
@@ -52,6 +120,74 @@ std::optional<Arguments> parse_arguments(i32 const argc,
     if(option == "-l" || option == "--local") {
       arguments.options.local = true;
       i += 1;
+    } else if(option == "-b" || option == "--time-budget") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::string_view const value(argv[i + 1]);
+      i64 budget = 0;
+      auto const [end, error] =
+        std::from_chars(value.data(), value.data() + value.size(), budget);
+      if(error != std::errc() || end != value.data() + value.size() ||
+         budget <= 0) {
+        printf("error: argument to %s must be a positive number: %s\n",
+               argv[i], argv[i + 1]);
+        return std::nullopt;
+      }
+
+      arguments.options.time_budget_ms = budget;
+      i += 2;
+    } else if(option == "-j" || option == "--threads") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::string_view const value(argv[i + 1]);
+      i32 threads = 0;
+      auto const [end, error] =
+        std::from_chars(value.data(), value.data() + value.size(), threads);
+      if(error != std::errc() || end != value.data() + value.size() ||
+         threads <= 0) {
+        printf("error: argument to %s must be a positive number: %s\n",
+               argv[i], argv[i + 1]);
+        return std::nullopt;
+      }
+
+      arguments.options.threads = threads;
+      i += 2;
+    } else if(option == "-t" || option == "--tt-memory") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      std::optional<i64> const value = parse_size(argv[i + 1]);
+      if(!value) {
+        printf("error: argument to %s must be a size: %s\n", argv[i],
+               argv[i + 1]);
+        return std::nullopt;
+      }
+
+      arguments.options.table_bytes = value.value();
+      i += 2;
+    } else if(option == "--symmetries") {
+      arguments.options.symmetries = true;
+      i += 1;
+    } else if(option == "--tablebase" || option == "--book") {
+      if(i + 1 >= argc) {
+        printf("error: missing mandatory argument to %s\n", argv[i]);
+        return std::nullopt;
+      }
+
+      if(option == "--tablebase") {
+        arguments.options.tablebase_path = argv[i + 1];
+      } else {
+        arguments.options.book_path = argv[i + 1];
+      }
+      i += 2;
     } else {
       // Not an option. End parsing.
       if(!option.starts_with("-")) {
@@ -125,11 +261,35 @@ int main(int const argc, char const* const* const argv) {
     return RETURN_HELP;
   }
 
+  std::optional<Position_Table> tablebase;
+  if(arguments.options.tablebase_path != nullptr) {
+    tablebase = Position_Table::map(arguments.options.tablebase_path,
+                                    Position_Table_Kind::tablebase);
+    if(!tablebase) {
+      return RETURN_FAILURE;
+    }
+  }
+
+  std::optional<Position_Table> book;
+  if(arguments.options.book_path != nullptr) {
+    book = Position_Table::map(arguments.options.book_path,
+                               Position_Table_Kind::opening_book);
+    if(!book) {
+      return RETURN_FAILURE;
+    }
+  }
+
+  Bot_Options const bot{.max_depth = arguments.depth,
+                        .time_budget_ms = arguments.options.time_budget_ms,
+                        .threads = arguments.options.threads,
+                        .table_bytes = arguments.options.table_bytes,
+                        .symmetries = arguments.options.symmetries,
+                        .tablebase = tablebase ? &tablebase.value() : nullptr,
+                        .book = book ? &book.value() : nullptr};
   if(arguments.options.local) {
-    play_local(arguments.player, arguments.depth);
+    play_local(arguments.player, bot);
   } else {
-    play_online(arguments.ip, arguments.port, arguments.player,
-                arguments.depth);
+    play_online(arguments.ip, arguments.port, arguments.player, bot);
   }
 
   return RETURN_SUCCESS;
@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <stdio.h>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <bitboard.hpp>
+#include <bot.hpp>
+#include <configuration.hpp>
+#include <heuristic.hpp>
+#include <transposition_table.hpp>
+#include <types.hpp>
+
+// Size of the transposition table of every engine. A fresh table is used for
+// every game, so that the games do not depend on the order they are played in.
+static constexpr i64 engine_table_bytes = 1 << 20;
+
+struct Engine {
+  i32 max_depth = 4;
+  // 0 means no limit.
+  i64 time_budget_ms = 0;
+  Heuristic_Weights weights;
+};
+
+struct Options {
+  bool help = false;
+  i32 games = 1000;
+  i32 threads = std::max<i32>(std::thread::hardware_concurrency(), 1);
+  u64 seed = 0;
+  // Random moves played before the engines take over.
+  i32 opening_moves = 2;
+  std::array<Engine, 2> engines;
+};
+
+// Game_Record
+// Outcome of a single game and the searches of both engines. Engines are
+// indexed 0 for A and 1 for B.
+//
+struct Game_Record {
+  // Engine that has won or -1 on a draw.
+  i32 winner = -1;
+  std::array<i64, 2> moves = {};
+  std::array<i64, 2> nodes = {};
+  std::array<std::vector<i64>, 2> latencies_ns;
+};
+
+static void help(char const* const name) {
+  printf("Usage: %s [OPTION]...\n", name);
+  printf("\n");
+  printf(
+    "Play games between two engines A and B in-process and report the win, "
+    "draw and loss rates of A, the nodes per move and the move latencies of "
+    "both. The engines swap sides every game, every random opening is played "
+    "twice, once with A as X and once with B as X.\n");
+  printf("\n");
+  printf("OPTIONS\n");
+  printf("  -h, --help\n");
+  printf("    Display the help page.\n");
+  printf("  -g, --games N\n");
+  printf("    Number of games. Defaults to 1000.\n");
+  printf("  -j, --threads N\n");
+  printf("    Number of games played concurrently. Defaults to the number of "
+         "hardware threads.\n");
+  printf("  --seed N\n");
+  printf("    Seed of the random openings. Defaults to 0.\n");
+  printf("  --opening N\n");
+  printf("    Number of random moves that open every game. Defaults to 2.\n");
+  printf("  --depth-a N, --depth-b N\n");
+  printf("    Maximum search depth of the engine. Defaults to 4.\n");
+  printf("  --budget-a MILLISECONDS, --budget-b MILLISECONDS\n");
+  printf("    Time budget of a single move of the engine. Defaults to no "
+         "limit.\n");
+  printf("  --weight-a NAME=VALUE, --weight-b NAME=VALUE\n");
+  printf("    Override a weight of the heuristic of the engine. May be given "
+         "multiple times. NAME is one of:");
+  for(char const* const weight_name: {"open_cross",
+                                      "closed_cross",
+                                      "skew_cross",
+                                      "skew_right_cross",
+                                      "skew_left_cross",
+                                      "open_4",
+                                      "open_5",
+                                      "opponent_open_4",
+                                      "opponent_open_5",
+                                      "opponent_closed_cross",
+                                      "opponent_open_cross",
+                                      "opponent_skew_cross",
+                                      "opponent_skew_right_cross",
+                                      "opponent_skew_left_cross"}) {
+    printf(" %s", weight_name);
+  }
+  printf(".\n");
+}
+
+// parse_integer
+//
+// Returns:
+// The value of string or std::nullopt if string is not entirely a decimal
+// integer.
+//
+static std::optional<i64> parse_integer(std::string_view const string) {
+  i64 value = 0;
+  auto const [end, error] =
+    std::from_chars(string.data(), string.data() + string.size(), value);
+  if(error != std::errc() || end != string.data() + string.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+// find_weight
+//
+// Returns:
+// The weight called name or nullptr if there is none.
+//
+static i32* find_weight(Heuristic_Weights& weights,
+                        std::string_view const name) {
+  struct Weight {
+    std::string_view name;
+    i32 Heuristic_Weights::*member;
+  };
+
+  Weight const table[] = {
+    {"open_cross", &Heuristic_Weights::open_cross},
+    {"closed_cross", &Heuristic_Weights::closed_cross},
+    {"skew_cross", &Heuristic_Weights::skew_cross},
+    {"skew_right_cross", &Heuristic_Weights::skew_right_cross},
+    {"skew_left_cross", &Heuristic_Weights::skew_left_cross},
+    {"open_4", &Heuristic_Weights::open_4},
+    {"open_5", &Heuristic_Weights::open_5},
+    {"opponent_open_4", &Heuristic_Weights::opponent_open_4},
+    {"opponent_open_5", &Heuristic_Weights::opponent_open_5},
+    {"opponent_closed_cross", &Heuristic_Weights::opponent_closed_cross},
+    {"opponent_open_cross", &Heuristic_Weights::opponent_open_cross},
+    {"opponent_skew_cross", &Heuristic_Weights::opponent_skew_cross},
+    {"opponent_skew_right_cross",
+     &Heuristic_Weights::opponent_skew_right_cross},
+    {"opponent_skew_left_cross", &Heuristic_Weights::opponent_skew_left_cross},
+  };
+  for(Weight const& weight: table) {
+    if(weight.name == name) {
+      return &(weights.*weight.member);
+    }
+  }
+  return nullptr;
+}
+
+static std::optional<Options> parse_options(i32 const argc,
+                                            char const* const* const argv) {
+  Options options;
+  for(i32 i = 1; i < argc;) {
+    std::string_view const option(argv[i]);
+    if(option == "-h" || option == "--help") {
+      options.help = true;
+      return options;
+    }
+
+    if(i + 1 >= argc) {
+      printf("error: missing mandatory argument to %s\n", argv[i]);
+      return std::nullopt;
+    }
+
+    std::string_view const argument(argv[i + 1]);
+    i32 const engine = option.ends_with("-b") ? 1 : 0;
+    if(option == "--weight-a" || option == "--weight-b") {
+      u64 const separator = argument.find('=');
+      std::optional<i64> const value =
+        separator != std::string_view::npos
+          ? parse_integer(argument.substr(separator + 1))
+          : std::nullopt;
+      i32* const weight = separator != std::string_view::npos
+                            ? find_weight(options.engines[engine].weights,
+                                          argument.substr(0, separator))
+                            : nullptr;
+      if(!value || weight == nullptr) {
+        printf("error: argument to %s must be NAME=VALUE with a valid weight "
+               "name: %s\n",
+               argv[i], argv[i + 1]);
+        return std::nullopt;
+      }
+
+      *weight = value.value();
+      i += 2;
+      continue;
+    }
+
+    std::optional<i64> const value = parse_integer(argument);
+    bool const recognised =
+      option == "-g" || option == "--games" || option == "-j" ||
+      option == "--threads" || option == "--seed" || option == "--opening" ||
+      option == "--depth-a" || option == "--depth-b" ||
+      option == "--budget-a" || option == "--budget-b";
+    if(!recognised) {
+      printf("error: unrecognised option: %s\n", argv[i]);
+      return std::nullopt;
+    }
+
+    bool const non_negative = option == "--seed" || option == "--opening";
+    if(!value || value.value() < (non_negative ? 0 : 1) ||
+       value.value() > maximum_i32) {
+      printf("error: argument to %s must be a %s integer: %s\n", argv[i],
+             non_negative ? "non-negative" : "positive", argv[i + 1]);
+      return std::nullopt;
+    }
+
+    if(option == "-g" || option == "--games") {
+      options.games = value.value();
+    } else if(option == "-j" || option == "--threads") {
+      options.threads = value.value();
+    } else if(option == "--seed") {
+      options.seed = value.value();
+    } else if(option == "--opening") {
+      options.opening_moves = value.value();
+    } else if(option.starts_with("--depth")) {
+      options.engines[engine].max_depth = value.value();
+    } else {
+      options.engines[engine].time_budget_ms = value.value();
+    }
+    i += 2;
+  }
+  return options;
+}
+
+// play_game
+// Play the game of the given index. Engine A is X in the even games, the odd
+// games repeat the opening of the preceding even game with the sides swapped.
+//
+static void play_game(Options const& options, i32 const game,
+                      Game_Record& record) {
+  std::mt19937_64 random(options.seed * 0x9E3779B97F4A7C15ULL + game / 2);
+  std::array<i32, 2> const engine_of_player =
+    game % 2 == 0 ? std::array<i32, 2>{0, 1} : std::array<i32, 2>{1, 0};
+  std::array<Transposition_Table, 2> tables = {
+    Transposition_Table(engine_table_bytes),
+    Transposition_Table(engine_table_bytes)};
+
+  Configuration c;
+  Bitboard board;
+  Player turn = Player::x;
+  for(i32 move = 0; !board.check_draw(); move += 1) {
+    i32 index = -1;
+    if(move < options.opening_moves) {
+      // Random move that does not end the game, if there is any.
+      u32 const empty = ~board.occupied() & Bitboard::full_mask;
+      u32 quiet = 0;
+      for(u32 squares = empty; squares != 0; squares &= squares - 1) {
+        i32 const square = std::countr_zero(squares);
+        Bitboard next = board;
+        next.place(square, turn);
+        if(!next.check_move(square, turn)) {
+          quiet |= 1u << square;
+        }
+      }
+
+      u32 candidates = quiet != 0 ? quiet : empty;
+      for(i32 skip = random() % std::popcount(candidates); skip > 0;
+          skip -= 1) {
+        candidates &= candidates - 1;
+      }
+      index = std::countr_zero(candidates);
+    } else {
+      i32 const engine = engine_of_player[static_cast<i32>(turn)];
+      Engine const& settings = options.engines[engine];
+      MINMAX_Statistics statistics;
+      auto const start = std::chrono::steady_clock::now();
+      MINMAX_Result const result = iterative_deepening_search(
+        Iterative_Deepening_Parameters{
+          .c = c,
+          .player = turn,
+          .max_depth = settings.max_depth,
+          .time_budget_ms = settings.time_budget_ms,
+          .threads = 1,
+          .table = &tables[engine],
+          .symmetries = false,
+          .weights = settings.weights,
+          .statistics = &statistics,
+        });
+      record.latencies_ns[engine].push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+      record.moves[engine] += 1;
+      record.nodes[engine] += statistics.nodes;
+      index = Bitboard::index(result.x, result.y);
+    }
+
+    board.place(index, turn);
+    c(index % Bitboard::width, index / Bitboard::width) =
+      PLAYER_TO_STATE(turn);
+    std::optional<Player> const winner = board.check_move(index, turn);
+    if(winner) {
+      record.winner = engine_of_player[static_cast<i32>(winner.value())];
+      return;
+    }
+    turn = OPPONENT(turn);
+  }
+  record.winner = -1;
+}
+
+// percentile
+//
+// Parameters:
+// sorted - ascending, not empty.
+//
+// Returns:
+// The nearest-rank percentile of sorted.
+//
+[[nodiscard]] static i64 percentile(std::vector<i64> const& sorted,
+                                    i32 const percent) {
+  i64 const rank = ((i64)sorted.size() * percent + 99) / 100;
+  return sorted[std::max<i64>(rank, 1) - 1];
+}
+
+int main(int const argc, char const* const* const argv) {
+  constexpr i32 RETURN_SUCCESS = 0;
+  constexpr i32 RETURN_ERROR = 1;
+  constexpr i32 RETURN_HELP = 2;
+
+  std::optional<Options> const result = parse_options(argc, argv);
+  if(!result) {
+    return RETURN_ERROR;
+  }
+
+  Options const& options = result.value();
+  if(options.help) {
+    help(argv[0]);
+    return RETURN_HELP;
+  }
+
+  std::vector<Game_Record> records(options.games);
+  std::atomic<i32> next_game = 0;
+  auto const worker = [&options, &records, &next_game] {
+    while(true) {
+      i32 const game = next_game.fetch_add(1, std::memory_order_relaxed);
+      if(game >= options.games) {
+        return;
+      }
+      play_game(options, game, records[game]);
+    }
+  };
+
+  auto const start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for(i32 i = 1; i < options.threads; i += 1) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for(std::thread& thread: threads) {
+    thread.join();
+  }
+  double const seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+  std::array<i64, 3> outcomes = {};
+  std::array<i64, 2> moves = {};
+  std::array<i64, 2> nodes = {};
+  std::array<std::vector<i64>, 2> latencies;
+  for(Game_Record const& record: records) {
+    // Wins, draws and losses of A.
+    outcomes[record.winner == 0 ? 0 : (record.winner == -1 ? 1 : 2)] += 1;
+    for(i32 engine = 0; engine < 2; engine += 1) {
+      moves[engine] += record.moves[engine];
+      nodes[engine] += record.nodes[engine];
+      latencies[engine].insert(latencies[engine].end(),
+                               record.latencies_ns[engine].begin(),
+                               record.latencies_ns[engine].end());
+    }
+  }
+
+  printf("%d games in %.1fs on %d threads\n", options.games, seconds,
+         options.threads);
+  char const* const outcome_names[] = {"wins", "draws", "losses"};
+  for(i32 i = 0; i < 3; i += 1) {
+    printf("A %-6s %6lld (%5.1f%%)\n", outcome_names[i], outcomes[i],
+           options.games > 0 ? 100.0 * outcomes[i] / options.games : 0.0);
+  }
+
+  printf("\n");
+  printf("engine depth budget(ms)    moves  nodes/move  p50(ms)  p90(ms)  "
+         "p99(ms)  max(ms)\n");
+  for(i32 engine = 0; engine < 2; engine += 1) {
+    std::vector<i64>& sorted = latencies[engine];
+    std::sort(sorted.begin(), sorted.end());
+    Engine const& settings = options.engines[engine];
+    printf("%-6c %5d %10lld %8lld %11.1f", engine == 0 ? 'A' : 'B',
+           settings.max_depth, settings.time_budget_ms, moves[engine],
+           moves[engine] > 0 ? (double)nodes[engine] / moves[engine] : 0.0);
+    if(sorted.size() > 0) {
+      printf(" %8.3f %8.3f %8.3f %8.3f\n",
+             percentile(sorted, 50) / 1e6, percentile(sorted, 90) / 1e6,
+             percentile(sorted, 99) / 1e6, sorted.back() / 1e6);
+    } else {
+      printf("\n");
+    }
+  }
+
+  return RETURN_SUCCESS;
+}
@@ -0,0 +1,213 @@
+#include <tablebase.hpp>
+
+#include <algorithm>
+#include <array>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <transposition_table.hpp>
+
+// The file consists of a Position_Table_Header followed by the sorted
+// entries in the native byte order. The version must be bumped whenever the
+// key or the payloads change.
+
+static constexpr char position_table_magic[8] = {'T', 'T', 'T', 'P',
+                                                 'O', 'S', 0,   0};
+static constexpr u32 position_table_version = 1;
+
+struct Position_Table_Header {
+  char magic[8];
+  u32 version;
+  Position_Table_Kind kind;
+  i32 depth;
+  u32 padding;
+  u64 count;
+};
+
+static_assert(sizeof(Position_Table_Header) % 8 == 0);
+
+// Images of the rows of the board under the symmetries, indexed by the
+// symmetry, the row and the 5 bits of the row.
+static constexpr auto symmetry_rows = [] {
+  std::array<std::array<std::array<u32, 32>, 5>, 8> rows = {};
+  for(i32 s = 0; s < 8; s += 1) {
+    for(i32 y = 0; y < 5; y += 1) {
+      for(u32 bits = 0; bits < 32; bits += 1) {
+        for(i32 x = 0; x < 5; x += 1) {
+          if(bits & (1u << x)) {
+            i32 const square = symmetry_squares[s][Bitboard::index(x, y)];
+            rows[s][y][bits] |= 1u << square;
+          }
+        }
+      }
+    }
+  }
+  return rows;
+}();
+
+[[nodiscard]] static u32 map_pieces(u32 const pieces, i32 const symmetry) {
+  u32 image = 0;
+  for(i32 y = 0; y < 5; y += 1) {
+    image |= symmetry_rows[symmetry][y][(pieces >> (y * 5)) & 31];
+  }
+  return image;
+}
+
+Canonical_Position canonicalise(Bitboard const& board) {
+  Canonical_Position canonical{.key = position_key_mask, .symmetry = 0};
+  for(i32 s = 0; s < 8; s += 1) {
+    u64 const key = (u64)map_pieces(board.pieces[0], s) |
+                    (u64)map_pieces(board.pieces[1], s) << 25;
+    if(key < canonical.key) {
+      canonical = Canonical_Position{.key = key, .symmetry = s};
+    }
+  }
+  return canonical;
+}
+
+u64 pack_tablebase_entry(Tablebase_Entry const entry) {
+  return (u64)entry.outcome | (u64)entry.distance << 2;
+}
+
+Tablebase_Entry unpack_tablebase_entry(u64 const payload) {
+  return Tablebase_Entry{.outcome = static_cast<Outcome>(payload & 3),
+                         .distance = (i32)(payload >> 2)};
+}
+
+Position_Table::Position_Table(Position_Table&& other)
+  : kind(other.kind), depth(other.depth), mapping(other.mapping),
+    mapping_bytes(other.mapping_bytes), entries(other.entries),
+    count(other.count) {
+  other.mapping = nullptr;
+  other.entries = nullptr;
+  other.count = 0;
+}
+
+Position_Table& Position_Table::operator=(Position_Table&& other) {
+  if(this != &other) {
+    if(mapping != nullptr) {
+      munmap(mapping, mapping_bytes);
+    }
+    kind = other.kind;
+    depth = other.depth;
+    mapping = other.mapping;
+    mapping_bytes = other.mapping_bytes;
+    entries = other.entries;
+    count = other.count;
+    other.mapping = nullptr;
+    other.entries = nullptr;
+    other.count = 0;
+  }
+  return *this;
+}
+
+Position_Table::~Position_Table() {
+  if(mapping != nullptr) {
+    munmap(mapping, mapping_bytes);
+  }
+}
+
+std::optional<Position_Table>
+Position_Table::map(char const* const path, Position_Table_Kind const kind) {
+  i32 const fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    printf("error: could not open %s: %s\n", path, strerror(errno));
+    return std::nullopt;
+  }
+
+  struct stat file_stat;
+  if(fstat(fd, &file_stat) != 0 ||
+     file_stat.st_size < (i64)sizeof(Position_Table_Header)) {
+    printf("error: %s is not a position table\n", path);
+    close(fd);
+    return std::nullopt;
+  }
+
+  void* const file =
+    mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping remains valid after the descriptor is closed.
+  close(fd);
+  if(file == MAP_FAILED) {
+    printf("error: could not map %s: %s\n", path, strerror(errno));
+    return std::nullopt;
+  }
+
+  Position_Table_Header const& header =
+    *static_cast<Position_Table_Header const*>(file);
+  u64 const entries_bytes = file_stat.st_size - sizeof(Position_Table_Header);
+  if(memcmp(header.magic, position_table_magic, sizeof(header.magic)) != 0 ||
+     header.version != position_table_version || header.kind != kind ||
+     entries_bytes != header.count * sizeof(u64)) {
+    printf("error: %s is not %s of this version\n", path,
+           kind == Position_Table_Kind::tablebase ? "a tablebase"
+                                                  : "an opening book");
+    munmap(file, file_stat.st_size);
+    return std::nullopt;
+  }
+
+  Position_Table table;
+  table.kind = kind;
+  table.depth = header.depth;
+  table.mapping = file;
+  table.mapping_bytes = file_stat.st_size;
+  table.entries = reinterpret_cast<u64 const*>(
+    static_cast<char const*>(file) + sizeof(Position_Table_Header));
+  table.count = header.count;
+  return table;
+}
+
+std::optional<u64> Position_Table::find(u64 const key) const {
+  u64 const* const end = entries + count;
+  u64 const* const entry =
+    std::lower_bound(entries, end, key, [](u64 const entry, u64 const key) {
+      return (entry & position_key_mask) < key;
+    });
+  if(entry == end || (*entry & position_key_mask) != key) {
+    return std::nullopt;
+  }
+  return *entry >> position_key_bits;
+}
+
+bool write_position_table(char const* const path,
+                          Position_Table_Kind const kind, i32 const depth,
+                          std::vector<u64>& entries) {
+  std::sort(entries.begin(), entries.end(), [](u64 const a, u64 const b) {
+    return (a & position_key_mask) < (b & position_key_mask);
+  });
+
+  Position_Table_Header header = {};
+  memcpy(header.magic, position_table_magic, sizeof(header.magic));
+  header.version = position_table_version;
+  header.kind = kind;
+  header.depth = depth;
+  header.count = entries.size();
+
+  // Written under a temporary name and renamed so that a client starting
+  // concurrently never maps a partially written table.
+  std::vector<char> temporary_path(strlen(path) + 5);
+  snprintf(temporary_path.data(), temporary_path.size(), "%s.tmp", path);
+  FILE* const file = fopen(temporary_path.data(), "wb");
+  if(file == nullptr) {
+    printf("error: could not open %s: %s\n", temporary_path.data(),
+           strerror(errno));
+    return false;
+  }
+
+  bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(entries.data(), sizeof(u64), entries.size(), file) ==
+                   entries.size();
+  success = fclose(file) == 0 && success;
+  if(success) {
+    success = rename(temporary_path.data(), path) == 0;
+  }
+  if(!success) {
+    printf("error: could not write %s\n", path);
+    remove(temporary_path.data());
+  }
+  return success;
+}
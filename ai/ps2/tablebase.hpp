@@ -0,0 +1,192 @@
+#pragma once
+
+#include <bitboard.hpp>
+#include <types.hpp>
+
+#include <bit>
+#include <optional>
+#include <vector>
+
+// Solved positions and the opening book are both sorted arrays of positions
+// under symmetry with a small payload, stored on disk by ttt_tablebase and
+// memory-mapped by the client.
+//
+// An entry packs the canonical key of a position in the low position_key_bits
+// bits and the payload above them. The key holds the pieces of x in the low
+// 25 bits and the pieces of o in the next 25 bits, the canonical key is the
+// smallest key of the 8 symmetric images of the position. The side to move is
+// implied by the number of pieces.
+
+constexpr i32 position_key_bits = 50;
+constexpr u64 position_key_mask = (1ULL << position_key_bits) - 1;
+
+// Canonical_Position
+//
+struct Canonical_Position {
+  u64 key;
+  // Index into symmetry_squares of the symmetry that maps the position onto
+  // its canonical image.
+  i32 symmetry;
+};
+
+[[nodiscard]] Canonical_Position canonicalise(Bitboard const& board);
+
+// side_to_move
+// x moves first, hence x is to move whenever both players have placed the
+// same number of pieces.
+//
+[[nodiscard]] inline Player side_to_move(Bitboard const& board) {
+  return std::popcount(board.pieces[0]) == std::popcount(board.pieces[1])
+           ? Player::x
+           : Player::o;
+}
+
+[[nodiscard]] inline i32 empty_squares(Bitboard const& board) {
+  return Bitboard::squares - std::popcount(board.occupied());
+}
+
+// Outcome of a position for the side to move with perfect play.
+enum struct Outcome : u8 {
+  loss,
+  draw,
+  win,
+};
+
+// Tablebase_Entry
+//
+struct Tablebase_Entry {
+  Outcome outcome = Outcome::draw;
+  // Moves until the end of the game, the loser delaying it as long as
+  // possible and the winner ending it as soon as possible.
+  i32 distance = 0;
+};
+
+[[nodiscard]] u64 pack_tablebase_entry(Tablebase_Entry entry);
+[[nodiscard]] Tablebase_Entry unpack_tablebase_entry(u64 payload);
+
+struct Solved_Move {
+  // Index of the square of the best move.
+  i32 index = -1;
+  Tablebase_Entry entry;
+};
+
+// solve_position
+// Solve a position that is not over from the positions one move away.
+//
+// Parameters:
+// find - invoked as find(canonical key) for every move that does not end the
+//        game and does not fill the board. Returns the Tablebase_Entry of the
+//        position after the move.
+//
+// Returns:
+// The best move, the quickest win, a draw or the slowest loss, and the entry
+// of board. The first of the equally good moves by the square index.
+//
+template<typename Find>
+[[nodiscard]] Solved_Move solve_position(Bitboard const& board, Find&& find) {
+  Player const turn = side_to_move(board);
+  Solved_Move best;
+  // Ranks the entries, the larger the better.
+  auto const rank = [](Tablebase_Entry const entry) -> i32 {
+    switch(entry.outcome) {
+      case Outcome::win:
+        return 2 * Bitboard::squares - entry.distance;
+      case Outcome::draw:
+        return 0;
+      case Outcome::loss:
+        return -2 * Bitboard::squares + entry.distance;
+    }
+    return 0;
+  };
+
+  u32 empty = ~board.occupied() & Bitboard::full_mask;
+  while(empty != 0) {
+    i32 const index = std::countr_zero(empty);
+    empty &= empty - 1;
+    Bitboard next = board;
+    next.place(index, turn);
+    Tablebase_Entry entry{.outcome = Outcome::draw, .distance = 1};
+    std::optional<Player> const winner = next.check_move(index, turn);
+    if(winner) {
+      entry.outcome = winner.value() == turn ? Outcome::win : Outcome::loss;
+    } else if(!next.check_draw()) {
+      Tablebase_Entry const reply = find(canonicalise(next).key);
+      entry.distance = reply.distance + 1;
+      entry.outcome = reply.outcome == Outcome::win    ? Outcome::loss
+                      : reply.outcome == Outcome::loss ? Outcome::win
+                                                       : Outcome::draw;
+    }
+
+    if(best.index == -1 || rank(entry) > rank(best.entry)) {
+      best = Solved_Move{.index = index, .entry = entry};
+    }
+  }
+  return best;
+}
+
+enum struct Position_Table_Kind : u32 {
+  // Tablebase_Entry of every position that is not over and has at most depth
+  // empty squares.
+  tablebase = 1,
+  // Index of the square of the best move, in the canonical image, of the
+  // positions within depth moves of the empty board.
+  opening_book = 2,
+};
+
+// Position_Table
+// A memory-mapped file of sorted entries.
+//
+struct Position_Table {
+public:
+  Position_Table_Kind kind = Position_Table_Kind::tablebase;
+  // Largest number of empty squares of the tablebase or the number of plies
+  // of the opening book.
+  i32 depth = 0;
+
+private:
+  void* mapping = nullptr;
+  u64 mapping_bytes = 0;
+  u64 const* entries = nullptr;
+  i64 count = 0;
+
+  Position_Table() = default;
+
+public:
+  Position_Table(Position_Table const&) = delete;
+  Position_Table(Position_Table&& other);
+  Position_Table& operator=(Position_Table const&) = delete;
+  Position_Table& operator=(Position_Table&& other);
+  ~Position_Table();
+
+  // map
+  // Map the file at path. Prints the reason of a failure.
+  //
+  // Returns:
+  // The table or std::nullopt if the file could not be mapped or is not a
+  // table of the given kind.
+  //
+  [[nodiscard]] static std::optional<Position_Table>
+  map(char const* path, Position_Table_Kind kind);
+
+  // find
+  //
+  // Returns:
+  // The payload of the canonical key or std::nullopt if key is absent.
+  //
+  [[nodiscard]] std::optional<u64> find(u64 key) const;
+
+  [[nodiscard]] i64 size() const {
+    return count;
+  }
+};
+
+// write_position_table
+// Sort entries and write them to path as a table of kind. Prints the reason
+// of a failure.
+//
+// Returns:
+// Whether the file has been written.
+//
+[[nodiscard]] bool write_position_table(char const* path,
+                                        Position_Table_Kind kind, i32 depth,
+                                        std::vector<u64>& entries);
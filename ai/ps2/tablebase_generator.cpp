@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <assert.h>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <optional>
+#include <stdio.h>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <bitboard.hpp>
+#include <bot.hpp>
+#include <configuration.hpp>
+#include <tablebase.hpp>
+#include <transposition_table.hpp>
+#include <types.hpp>
+
+static void help(char const* const name) {
+  printf("Usage: %s [OPTION]...\n", name);
+  printf("\n");
+  printf(
+    "Solve every position with at most the given number of empty squares "
+    "into a tablebase and search the positions of the first plies into an "
+    "opening book. ttt_client maps both with --tablebase and --book.\n");
+  printf("\n");
+  printf("OPTIONS\n");
+  printf("  -h, --help\n");
+  printf("    Display the help page.\n");
+  printf("  -e, --empty N\n");
+  printf(
+    "    Largest number of empty squares of the solved positions (1 through "
+    "6). Every additional square multiplies the size roughly by 7. Defaults "
+    "to 4.\n");
+  printf("  -p, --plies N\n");
+  printf(
+    "    Number of plies covered by the opening book, 0 skips the book. "
+    "Defaults to 3.\n");
+  printf("  -d, --depth N\n");
+  printf("    Search depth of the moves of the opening book. Defaults to 8.\n");
+  printf("  -j, --threads N\n");
+  printf("    Number of threads searching each position of the opening book. "
+         "Defaults to the number of hardware threads.\n");
+  printf("  -t, --tablebase PATH\n");
+  printf("    Output path of the tablebase. Defaults to tablebase.bin.\n");
+  printf("  -b, --book PATH\n");
+  printf("    Output path of the opening book. Defaults to book.bin.\n");
+}
+
+struct Options {
+  bool help = false;
+  i32 empty = 4;
+  i32 plies = 3;
+  i32 depth = 8;
+  i32 threads = std::max<i32>(std::thread::hardware_concurrency(), 1);
+  char const* tablebase_path = "tablebase.bin";
+  char const* book_path = "book.bin";
+};
+
+static std::optional<Options> parse_options(i32 const argc,
+                                            char const* const* const argv) {
+  Options options;
+  for(i32 i = 1; i < argc; i += 2) {
+    std::string_view const option(argv[i]);
+    if(option == "-h" || option == "--help") {
+      options.help = true;
+      return options;
+    }
+
+    if(i + 1 >= argc) {
+      printf("error: missing mandatory argument to %s\n", argv[i]);
+      return std::nullopt;
+    }
+
+    if(option == "-t" || option == "--tablebase") {
+      options.tablebase_path = argv[i + 1];
+      continue;
+    } else if(option == "-b" || option == "--book") {
+      options.book_path = argv[i + 1];
+      continue;
+    }
+
+    i32* target = nullptr;
+    i32 minimum = 1;
+    i32 maximum = maximum_i32;
+    if(option == "-e" || option == "--empty") {
+      target = &options.empty;
+      maximum = 6;
+    } else if(option == "-p" || option == "--plies") {
+      target = &options.plies;
+      minimum = 0;
+      maximum = Bitboard::squares;
+    } else if(option == "-d" || option == "--depth") {
+      target = &options.depth;
+      maximum = Bitboard::squares;
+    } else if(option == "-j" || option == "--threads") {
+      target = &options.threads;
+    } else {
+      printf("error: unrecognised option: %s\n", argv[i]);
+      return std::nullopt;
+    }
+
+    std::string_view const value(argv[i + 1]);
+    auto const [end, error] =
+      std::from_chars(value.data(), value.data() + value.size(), *target);
+    if(error != std::errc() || end != value.data() + value.size() ||
+       *target < minimum || *target > maximum) {
+      printf("error: argument to %s must be a number between %d and %d: %s\n",
+             argv[i], minimum, maximum, argv[i + 1]);
+      return std::nullopt;
+    }
+  }
+  return options;
+}
+
+[[nodiscard]] static Bitboard board_from_key(u64 const key) {
+  Bitboard board;
+  board.pieces[0] = key & Bitboard::full_mask;
+  board.pieces[1] = (key >> 25) & Bitboard::full_mask;
+  return board;
+}
+
+[[nodiscard]] static double elapsed_s(
+  std::chrono::steady_clock::time_point const start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+    .count();
+}
+
+// Level_Enumeration
+// Positions of a single number of empty squares that are not over, i.e. have
+// no 3 pieces of a player in a line, and are their own canonical images.
+//
+struct Level_Enumeration {
+  i32 x_count;
+  i32 o_count;
+  // Receives the keys of the positions.
+  std::vector<u64>& keys;
+
+  void enumerate(i32 const index, u32 const x, u32 const o, i32 const xs,
+                 i32 const os) {
+    if(xs + os + (Bitboard::squares - index) < x_count + o_count) {
+      return;
+    }
+
+    if(index == Bitboard::squares) {
+      Bitboard board;
+      board.pieces = {x, o};
+      u64 const key = (u64)x | (u64)o << 25;
+      if(canonicalise(board).key == key) {
+        keys.push_back(key);
+      }
+      return;
+    }
+
+    // Only the lines through the placed square may have been completed.
+    auto const forms_line = [index](u32 const pieces) -> bool {
+      Bitboard_Square_Lines const& square = bitboard_square_lines[index];
+      for(i32 i = 0; i < square.three_count; i += 1) {
+        if((pieces & square.threes[i]) == square.threes[i]) {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    u32 const bit = 1u << index;
+    enumerate(index + 1, x, o, xs, os);
+    if(xs < x_count && !forms_line(x | bit)) {
+      enumerate(index + 1, x | bit, o, xs + 1, os);
+    }
+    if(os < o_count && !forms_line(o | bit)) {
+      enumerate(index + 1, x, o | bit, xs, os + 1);
+    }
+  }
+};
+
+// generate_tablebase
+// Solve the positions level by level, every level from the entries of the
+// positions with one empty square less.
+//
+// Returns:
+// The entries of all the levels.
+//
+[[nodiscard]] static std::vector<u64> generate_tablebase(i32 const max_empty) {
+  std::vector<u64> entries;
+  std::vector<u64> previous;
+  for(i32 empty = 1; empty <= max_empty; empty += 1) {
+    auto const start = std::chrono::steady_clock::now();
+    i32 const pieces = Bitboard::squares - empty;
+    std::vector<u64> keys;
+    Level_Enumeration enumeration{.x_count = (pieces + 1) / 2,
+                                  .o_count = pieces / 2,
+                                  .keys = keys};
+    enumeration.enumerate(0, 0, 0, 0, 0);
+
+    std::array<i64, 3> outcomes = {};
+    std::vector<u64> level;
+    level.reserve(keys.size());
+    for(u64 const key: keys) {
+      Solved_Move const solved =
+        solve_position(board_from_key(key), [&previous](u64 const child) {
+          auto const entry = std::lower_bound(
+            previous.begin(), previous.end(), child,
+            [](u64 const entry, u64 const key) {
+              return (entry & position_key_mask) < key;
+            });
+          assert(entry != previous.end() &&
+                 (*entry & position_key_mask) == child);
+          return unpack_tablebase_entry(*entry >> position_key_bits);
+        });
+      outcomes[static_cast<i32>(solved.entry.outcome)] += 1;
+      level.push_back(key |
+                      pack_tablebase_entry(solved.entry) << position_key_bits);
+    }
+
+    printf("%d empty squares: %zu positions, %lld won, %lld drawn, %lld lost "
+           "by the side to move (%.1fs)\n",
+           empty, level.size(), outcomes[2], outcomes[1], outcomes[0],
+           elapsed_s(start));
+    // The enumeration visits the keys in no particular order.
+    std::sort(level.begin(), level.end(), [](u64 const a, u64 const b) {
+      return (a & position_key_mask) < (b & position_key_mask);
+    });
+    entries.insert(entries.end(), level.begin(), level.end());
+    previous = std::move(level);
+  }
+  return entries;
+}
+
+// generate_book
+// Search the best move of every position of the first plies.
+//
+// Returns:
+// The entries of the positions that are not over.
+//
+[[nodiscard]] static std::vector<u64>
+generate_book(Options const& options, Position_Table const* const tablebase) {
+  Transposition_Table table(64 << 20);
+  std::vector<u64> entries;
+  std::vector<u64> positions = {0};
+  for(i32 ply = 0; ply < options.plies; ply += 1) {
+    auto const start = std::chrono::steady_clock::now();
+    for(u64 const key: positions) {
+      Bitboard const board = board_from_key(key);
+      Configuration c;
+      for(i32 index = 0; index < Bitboard::squares; index += 1) {
+        for(Player const player: {Player::x, Player::o}) {
+          if(board.pieces[static_cast<i32>(player)] & (1u << index)) {
+            c(index % Bitboard::width, index / Bitboard::width) =
+              PLAYER_TO_STATE(player);
+          }
+        }
+      }
+
+      MINMAX_Result const result =
+        iterative_deepening_search(Iterative_Deepening_Parameters{
+          .c = c,
+          .player = side_to_move(board),
+          .max_depth = options.depth,
+          .threads = options.threads,
+          .table = &table,
+          .tablebase = tablebase,
+        });
+      u64 const move = Bitboard::index(result.x, result.y);
+      entries.push_back(key | move << position_key_bits);
+    }
+    printf("ply %d: %zu positions (%.1fs)\n", ply, positions.size(),
+           elapsed_s(start));
+
+    std::vector<u64> next;
+    for(u64 const key: positions) {
+      Bitboard const board = board_from_key(key);
+      Player const turn = side_to_move(board);
+      u32 empty = ~board.occupied() & Bitboard::full_mask;
+      while(empty != 0) {
+        i32 const index = std::countr_zero(empty);
+        empty &= empty - 1;
+        Bitboard child = board;
+        child.place(index, turn);
+        if(!child.check_move(index, turn) && !child.check_draw()) {
+          next.push_back(canonicalise(child).key);
+        }
+      }
+    }
+    std::sort(next.begin(), next.end());
+    next.erase(std::unique(next.begin(), next.end()), next.end());
+    positions = std::move(next);
+  }
+  return entries;
+}
+
+int main(int const argc, char const* const* const argv) {
+  constexpr i32 RETURN_SUCCESS = 0;
+  constexpr i32 RETURN_ERROR = 1;
+  constexpr i32 RETURN_HELP = 2;
+
+  std::optional<Options> const result = parse_options(argc, argv);
+  if(!result) {
+    return RETURN_ERROR;
+  }
+
+  Options const& options = result.value();
+  if(options.help) {
+    help(argv[0]);
+    return RETURN_HELP;
+  }
+
+  std::vector<u64> tablebase_entries = generate_tablebase(options.empty);
+  if(!write_position_table(options.tablebase_path,
+                           Position_Table_Kind::tablebase, options.empty,
+                           tablebase_entries)) {
+    return RETURN_ERROR;
+  }
+  printf("Wrote %zu positions to %s\n", tablebase_entries.size(),
+         options.tablebase_path);
+  tablebase_entries = {};
+
+  if(options.plies == 0) {
+    return RETURN_SUCCESS;
+  }
+
+  // The book searches end in the tablebase just written.
+  std::optional<Position_Table> const tablebase = Position_Table::map(
+    options.tablebase_path, Position_Table_Kind::tablebase);
+  if(!tablebase) {
+    return RETURN_ERROR;
+  }
+
+  std::vector<u64> book_entries = generate_book(options, &tablebase.value());
+  if(!write_position_table(options.book_path,
+                           Position_Table_Kind::opening_book, options.plies,
+                           book_entries)) {
+    return RETURN_ERROR;
+  }
+  printf("Wrote %zu positions to %s\n", book_entries.size(),
+         options.book_path);
+  return RETURN_SUCCESS;
+}
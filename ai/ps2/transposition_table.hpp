@@ -0,0 +1,297 @@
+#pragma once
+
+#include <bitboard.hpp>
+#include <types.hpp>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Zobrist keys of the pieces of either player on every square. Generated with
+// splitmix64 from a fixed seed so that the keys do not change between builds.
+//
+constexpr std::array<std::array<u64, 25>, 2> zobrist_keys = [] {
+  std::array<std::array<u64, 25>, 2> keys = {};
+  u64 state = 0x5A0B1F7C3D2E4968ULL;
+  for(std::array<u64, 25>& player_keys: keys) {
+    for(u64& key: player_keys) {
+      state += 0x9E3779B97F4A7C15ULL;
+      u64 z = state;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      key = z ^ (z >> 31);
+    }
+  }
+  return keys;
+}();
+
+// Toggled on every move.
+constexpr u64 zobrist_turn_key = 0xD6E8FEB86659FD93ULL;
+// Present when the search maximises for o. The values of the search are
+// relative to the maximising player, hence they must not be shared between
+// searches for different players.
+constexpr u64 zobrist_player_key = 0xA0761D6478BD642FULL;
+
+// Images of the squares under the 8 symmetries of the board, the identity
+// first.
+//
+constexpr std::array<std::array<i32, 25>, 8> symmetry_squares = [] {
+  std::array<std::array<i32, 25>, 8> squares = {};
+  for(i32 y = 0; y < 5; y += 1) {
+    for(i32 x = 0; x < 5; x += 1) {
+      Point const images[8] = {
+        // Rotations.
+        {x, y},
+        {4 - y, x},
+        {4 - x, 4 - y},
+        {y, 4 - x},
+        // Reflections.
+        {4 - x, y},
+        {x, 4 - y},
+        {y, x},
+        {4 - y, 4 - x},
+      };
+      for(i32 s = 0; s < 8; s += 1) {
+        squares[s][Bitboard::index(x, y)] =
+          Bitboard::index(images[s].x, images[s].y);
+      }
+    }
+  }
+  return squares;
+}();
+
+// Zobrist_Hash
+// Zobrist hash of a position, updated incrementally with every placed piece.
+// With symmetries the hash additionally tracks the hashes of the 7 symmetric
+// images of the position and the key is the smallest of them, i.e. symmetric
+// positions share a key.
+//
+struct Zobrist_Hash {
+public:
+  std::array<u64, 8> keys = {};
+  // 1 or 8.
+  i32 symmetries = 1;
+
+public:
+  // Zobrist_Hash
+  //
+  // Parameters:
+  // board - position to hash.
+  // turn - player to move.
+  // player - maximising player of the search.
+  // canonicalise - whether symmetric positions share a key.
+  //
+  Zobrist_Hash(Bitboard const& board, Player const turn, Player const player,
+               bool const canonicalise)
+    : symmetries(canonicalise ? 8 : 1) {
+    u64 base = 0;
+    if(turn == Player::o) {
+      base ^= zobrist_turn_key;
+    }
+    if(player == Player::o) {
+      base ^= zobrist_player_key;
+    }
+    for(i32 s = 0; s < symmetries; s += 1) {
+      keys[s] = base;
+      for(i32 index = 0; index < Bitboard::squares; index += 1) {
+        for(Player const p: {Player::x, Player::o}) {
+          if(board.pieces[static_cast<i32>(p)] & (1u << index)) {
+            keys[s] ^= zobrist_keys[static_cast<i32>(p)]
+                                   [symmetry_squares[s][index]];
+          }
+        }
+      }
+    }
+  }
+
+  void place(i32 const index, Player const player) {
+    for(i32 s = 0; s < symmetries; s += 1) {
+      keys[s] ^= zobrist_keys[static_cast<i32>(player)]
+                             [symmetry_squares[s][index]] ^
+                 zobrist_turn_key;
+    }
+  }
+
+  [[nodiscard]] u64 key() const {
+    u64 key = keys[0];
+    for(i32 s = 1; s < symmetries; s += 1) {
+      if(keys[s] < key) {
+        key = keys[s];
+      }
+    }
+    return key;
+  }
+};
+
+enum struct Bound : u8 {
+  exact,
+  // The value is at least the stored value.
+  lower,
+  // The value is at most the stored value.
+  upper,
+};
+
+// Transposition_Entry
+// Value of a position searched to depth plies. Searches of at least as many
+// plies may reuse it.
+//
+struct Transposition_Entry {
+  i32 value = 0;
+  // Nodes searched below the position to obtain the value. Saturates.
+  i32 nodes = 0;
+  i32 depth = 0;
+  Bound bound = Bound::exact;
+  // Index of the square of the best move or -1 if none is known.
+  i32 move = -1;
+  // minmax_search the entry has been stored by.
+  i32 generation = 0;
+};
+
+struct Transposition_Table_Statistics {
+  i64 probes = 0;
+  i64 hits = 0;
+  // Hits that ended the search of the position.
+  i64 cutoffs = 0;
+  // Nodes the cutoffs had taken to search when the entries were stored.
+  i64 nodes_saved = 0;
+  i64 stores = 0;
+
+  void accumulate(Transposition_Table_Statistics const& other) {
+    probes += other.probes;
+    hits += other.hits;
+    cutoffs += other.cutoffs;
+    nodes_saved += other.nodes_saved;
+    stores += other.stores;
+  }
+};
+
+// Transposition_Table
+// Fixed size table of Transposition_Entry. Every key maps to a single slot,
+// an entry replaces the one in its slot unless that one comes from the same
+// search and is deeper.
+//
+// Meant to be kept over the whole game, every search begins a new generation
+// that takes precedence over the entries of the previous moves.
+//
+// The table may be shared by the threads of a search without locking. A slot
+// holds the packed entry and the key xored with it, both written with separate
+// relaxed stores. A slot torn by concurrent stores fails the key check and
+// reads as empty, hence a lookup never returns the entry of a different key.
+//
+struct Transposition_Table {
+private:
+  struct Slot {
+    std::atomic<u64> check;
+    std::atomic<u64> data;
+  };
+
+  // Layout of the packed entry from the least significant bit. The value is
+  // biased to be non-negative, entries with values out of its range are not
+  // stored. The occupied bit distinguishes entries from the empty slots.
+  static constexpr i32 value_bits = 22;
+  static constexpr i32 nodes_bits = 21;
+  static constexpr i32 depth_bits = 5;
+  static constexpr i32 bound_bits = 2;
+  static constexpr i32 move_bits = 5;
+  static constexpr i32 generation_bits = 8;
+  static_assert(value_bits + nodes_bits + depth_bits + bound_bits + move_bits +
+                  generation_bits + 1 ==
+                64);
+
+  static constexpr i32 value_bias = 1 << (value_bits - 1);
+  static constexpr i32 maximum_nodes = (1 << nodes_bits) - 1;
+
+  std::vector<Slot> slots;
+  u64 mask = 0;
+
+public:
+  // Incremented by every search. Must not change while a search is running.
+  u8 generation = 0;
+
+public:
+  // Transposition_Table
+  //
+  // Parameters:
+  // bytes - upper bound of the memory used by the table. Rounded down to the
+  //         power of 2 slots, at least one slot.
+  //
+  explicit Transposition_Table(i64 const bytes) {
+    i64 capacity = 1;
+    while(capacity * 2 * (i64)sizeof(Slot) <= bytes) {
+      capacity *= 2;
+    }
+    slots = std::vector<Slot>(capacity);
+    mask = capacity - 1;
+  }
+
+  [[nodiscard]] i64 capacity() const {
+    return mask + 1;
+  }
+
+  // find
+  //
+  // Returns:
+  // Whether an entry of key is present. entry is only written when it is.
+  //
+  [[nodiscard]] bool find(u64 const key, Transposition_Entry& entry) const {
+    Slot const& slot = slots[key & mask];
+    u64 const data = slot.data.load(std::memory_order_relaxed);
+    u64 const check = slot.check.load(std::memory_order_relaxed);
+    if(data == 0 || (check ^ data) != key) {
+      return false;
+    }
+
+    entry = unpack(data);
+    return true;
+  }
+
+  void store(u64 const key, Transposition_Entry entry) {
+    if(entry.value < -value_bias || entry.value >= value_bias) {
+      return;
+    }
+
+    Slot& slot = slots[key & mask];
+    u64 const data = slot.data.load(std::memory_order_relaxed);
+    if(data != 0) {
+      Transposition_Entry const stored = unpack(data);
+      if(stored.generation == generation && stored.depth > entry.depth) {
+        return;
+      }
+    }
+
+    entry.generation = generation;
+    u64 const packed = pack(entry);
+    slot.data.store(packed, std::memory_order_relaxed);
+    slot.check.store(key ^ packed, std::memory_order_relaxed);
+  }
+
+private:
+  [[nodiscard]] static u64 pack(Transposition_Entry const entry) {
+    u64 data = 1;
+    data = (data << generation_bits) | (u8)entry.generation;
+    data = (data << move_bits) | (u64)(entry.move + 1);
+    data = (data << bound_bits) | (u64)entry.bound;
+    data = (data << depth_bits) | (u64)entry.depth;
+    i32 const nodes = entry.nodes < maximum_nodes ? entry.nodes : maximum_nodes;
+    data = (data << nodes_bits) | (u64)nodes;
+    data = (data << value_bits) | (u64)(entry.value + value_bias);
+    return data;
+  }
+
+  [[nodiscard]] static Transposition_Entry unpack(u64 data) {
+    auto const take = [&data](i32 const bits) -> i32 {
+      i32 const field = data & ((1ULL << bits) - 1);
+      data >>= bits;
+      return field;
+    };
+
+    Transposition_Entry entry;
+    entry.value = take(value_bits) - value_bias;
+    entry.nodes = take(nodes_bits);
+    entry.depth = take(depth_bits);
+    entry.bound = static_cast<Bound>(take(bound_bits));
+    entry.move = take(move_bits) - 1;
+    entry.generation = take(generation_bits);
+    return entry;
+  }
+};
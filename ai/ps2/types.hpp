@@ -1,11 +1,15 @@
 #pragma once
 
 using u8 = unsigned char;
+using u32 = unsigned int;
+using u64 = unsigned long long;
 
 using i32 = int;
+using i64 = long long;
 
 constexpr i32 maximum_i32 = 0x7FFFFFFF;
 constexpr i32 minimum_i32 = 0x80000000;
+constexpr i64 maximum_i64 = 0x7FFFFFFFFFFFFFFF;
 
 enum struct Player { x = 0, o = 1 };
 
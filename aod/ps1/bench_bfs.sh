@@ -0,0 +1,40 @@
+#!/bin/bash
+# Scaling of the parallel breadth-first search on Kronecker graphs, against the
+# sequential one. Expects the binaries of compile.sh in the current directory.
+#
+# Usage: ./bench_bfs.sh [SCALE...]
+
+scales=("$@")
+if [[ ${#scales[@]} -eq 0 ]]; then
+    scales=(16 18 20)
+fi
+
+threads=(1 2 4 8 16)
+mkdir -p ./bench
+
+traversal_ms() {
+    "$@" 2>&1 >/dev/null | awk '/graph traversed in/ { printf "%.1f", $4 / 1e6 }'
+}
+
+for kind in undirected directed; do
+    flag=""
+    if [[ "$kind" == "directed" ]]; then
+        flag="--directed"
+    fi
+
+    for scale in "${scales[@]}"; do
+        graph="./bench/rmat-${kind}-${scale}.txt"
+        if [[ ! -f "$graph" ]]; then
+            ./main_rmat --scale "$scale" $flag > "$graph"
+        fi
+
+        printf "%s scale %d: bfs %sms" "$kind" "$scale" \
+            "$(traversal_ms ./main_e1 --bfs < "$graph")"
+        for t in "${threads[@]}"; do
+            printf ", pbfs/%d %sms" "$t" \
+                "$(traversal_ms ./main_e1 --pbfs --threads "$t" < "$graph")"
+        done
+        printf ", ordered/%d %sms\n" "${threads[-1]}" \
+            "$(traversal_ms ./main_e1 --pbfs --ordered --threads "${threads[-1]}" < "$graph")"
+    done
+done
@@ -0,0 +1,32 @@
+#!/bin/bash
+# Parallel strongly connected components against Tarjan on directed Kronecker
+# graphs with millions of vertices. Expects the binaries of compile.sh in the
+# current directory.
+#
+# Usage: ./bench_scc.sh [SCALE...]
+
+scales=("$@")
+if [[ ${#scales[@]} -eq 0 ]]; then
+    scales=(20 21 22)
+fi
+
+threads=(1 2 4 8 16)
+mkdir -p ./bench
+
+scc_ms() {
+    "$@" 2>&1 >/dev/null | awk '/scc found in/ { printf "%.1f", $4 / 1e6 }'
+}
+
+for scale in "${scales[@]}"; do
+    graph="./bench/rmat-directed-${scale}.txt"
+    if [[ ! -f "$graph" ]]; then
+        ./main_rmat --scale "$scale" --directed > "$graph"
+    fi
+
+    printf "scale %d: tarjan %sms" "$scale" "$(scc_ms ./main_e3 < "$graph")"
+    for t in "${threads[@]}"; do
+        printf ", parallel/%d %sms" "$t" \
+            "$(scc_ms ./main_e3 --parallel --threads "$t" < "$graph")"
+    done
+    printf "\n"
+done
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <barrier>
+#include <charconv>
 #include <chrono>
+#include <iostream>
 #include <optional>
+#include <span>
 #include <stdio.h>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 #ifndef ENABLE_HOTSPOT_ERRORS
@@ -12,9 +18,20 @@
 using u8 = unsigned char;
 using i32 = int;
 using i64 = long long;
+using u64 = unsigned long long;
 
 #define INPUT_BUFFER_SIZE 4096
 
+// parse_number
+// Parse the whole of value as a decimal number.
+//
+template<typename T>
+[[nodiscard]] bool parse_number(std::string_view const value, T& out) {
+    auto const [end, error] =
+        std::from_chars(value.data(), value.data() + value.size(), out);
+    return error == std::errc() && end == value.data() + value.size();
+}
+
 struct String_View {
     char* begin;
     char* end;
@@ -125,12 +142,16 @@ public:
     }
 
     void write_newline() {
+        write_char('\n');
+    }
+
+    void write_char(char const c) {
         if(end - i < 1) {
             fwrite(buf, 1, i - buf, stdout);
             i = buf;
         }
 
-        *i = '\n';
+        *i = c;
         ++i;
     }
 
@@ -172,8 +193,83 @@ public:
     }
 };
 
-template<typename Vertex>
-[[nodiscard]] inline std::optional<std::vector<Vertex>> read_graph() {
+// Graph
+// Compressed sparse row adjacency. The edges leaving vertex v are
+// targets[offsets[v]] through targets[offsets[v + 1] - 1] in the order they
+// have been read. An undirected edge is stored in both directions.
+//
+struct Graph {
+    std::vector<i32> offsets;
+    std::vector<i32> targets;
+    // The edges entering every vertex in the same layout. Empty unless
+    // requested from read_graph and for undirected graphs, whose edges are the
+    // same in both directions.
+    std::vector<i32> reverse_offsets;
+    std::vector<i32> reverse_targets;
+    bool directed = false;
+
+    [[nodiscard]] i32 vertex_count() const {
+        return static_cast<i32>(offsets.size()) - 1;
+    }
+
+    [[nodiscard]] std::span<i32 const> edges(i32 const vertex) const {
+        return {targets.data() + offsets[vertex],
+                targets.data() + offsets[vertex + 1]};
+    }
+
+    [[nodiscard]] std::span<i32 const> reverse_edges(i32 const vertex) const {
+        if(!directed) {
+            return edges(vertex);
+        }
+
+        return {reverse_targets.data() + reverse_offsets[vertex],
+                reverse_targets.data() + reverse_offsets[vertex + 1]};
+    }
+};
+
+// build_csr
+// Bucket the edges by their sources. Counting sort, hence stable.
+//
+inline void build_csr(i32 const num_vertices, std::vector<i32> const& sources,
+                      std::vector<i32> const& destinations, bool const directed,
+                      std::vector<i32>& offsets, std::vector<i32>& targets) {
+    offsets.assign(num_vertices + 1, 0);
+    for(i32 i = 0; i < static_cast<i32>(sources.size()); i += 1) {
+        offsets[sources[i] + 1] += 1;
+        if(!directed) {
+            offsets[destinations[i] + 1] += 1;
+        }
+    }
+
+    for(i32 v = 0; v < num_vertices; v += 1) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    // Next free slot of every vertex.
+    std::vector<i32> cursors(offsets.begin(), offsets.end() - 1);
+    targets.resize(offsets[num_vertices]);
+    for(i32 i = 0; i < static_cast<i32>(sources.size()); i += 1) {
+        targets[cursors[sources[i]]] = destinations[i];
+        cursors[sources[i]] += 1;
+        if(!directed) {
+            targets[cursors[destinations[i]]] = sources[i];
+            cursors[destinations[i]] += 1;
+        }
+    }
+}
+
+// read_graph
+// Read the graph from the standard input in two passes, first the edge list
+// is read and the degrees counted, then the edges are scattered into the CSR
+// arrays. Prints the load time to the standard error.
+//
+// Parameters:
+// build_reverse - whether to build the reverse adjacency as well.
+//
+[[nodiscard]] inline std::optional<Graph> read_graph(bool const build_reverse =
+                                                         false) {
+    Timer load_timer;
+    load_timer.start();
     Input_Buffer in;
 
     u8 graph_kind;
@@ -182,7 +278,8 @@ template<typename Vertex>
         return std::nullopt;
     }
 
-    bool const directed = graph_kind == 'D';
+    Graph graph;
+    graph.directed = graph_kind == 'D';
 
     i32 num_vertices;
     if(!in.read_i32(num_vertices)) {
@@ -190,9 +287,6 @@ template<typename Vertex>
         return std::nullopt;
     }
 
-    std::vector<Vertex> vertices;
-    vertices.resize(num_vertices);
-
     i32 num_edges;
     if(!in.read_i32(num_edges)) {
         std::cerr << "error: could not read number of edges\n";
@@ -201,8 +295,10 @@ template<typename Vertex>
 
     Timer edges_read_timer;
     edges_read_timer.start();
+    std::vector<i32> sources(num_edges);
+    std::vector<i32> destinations(num_edges);
     for(i32 i = 0; i < num_edges; i += 1) {
-        i32 src;
+        i32 src = 0;
         if constexpr(!ENABLE_HOTSPOT_ERRORS) {
             in.read_i32(src);
         } else {
@@ -212,7 +308,7 @@ template<typename Vertex>
             }
         }
 
-        i32 dst;
+        i32 dst = 0;
         if constexpr(!ENABLE_HOTSPOT_ERRORS) {
             in.read_i32(dst);
         } else {
@@ -222,11 +318,80 @@ template<typename Vertex>
             }
         }
 
-        vertices[src - 1].edges.push_back(dst - 1);
-        if(!directed) {
-            vertices[dst - 1].edges.push_back(src - 1);
-        }
+        sources[i] = src - 1;
+        destinations[i] = dst - 1;
     }
     std::cerr << "edges read in " << edges_read_timer.end() << "ns\n";
-    return vertices;
+
+    build_csr(num_vertices, sources, destinations, graph.directed,
+              graph.offsets, graph.targets);
+    if(build_reverse && graph.directed) {
+        build_csr(num_vertices, destinations, sources, graph.directed,
+                  graph.reverse_offsets, graph.reverse_targets);
+    }
+    std::cerr << "graph loaded in " << load_timer.end() << "ns\n";
+    return graph;
 }
+
+// Thread_Pool
+// Runs a job on the calling thread and thread_count - 1 workers at once. The
+// workers sleep on a barrier between the jobs, hence a job is cheap enough to
+// be run for every level of a traversal.
+//
+struct Thread_Pool {
+private:
+    std::vector<std::thread> workers;
+    std::barrier<> start_barrier;
+    std::barrier<> end_barrier;
+    void (*invoke)(void*, i32) = nullptr;
+    void* job = nullptr;
+    bool stopping = false;
+
+public:
+    explicit Thread_Pool(i32 const thread_count)
+        : start_barrier(thread_count), end_barrier(thread_count) {
+        for(i32 index = 1; index < thread_count; index += 1) {
+            workers.emplace_back([this, index] {
+                while(true) {
+                    start_barrier.arrive_and_wait();
+                    if(stopping) {
+                        return;
+                    }
+
+                    invoke(job, index);
+                    end_barrier.arrive_and_wait();
+                }
+            });
+        }
+    }
+
+    Thread_Pool(Thread_Pool const&) = delete;
+    Thread_Pool& operator=(Thread_Pool const&) = delete;
+
+    ~Thread_Pool() {
+        stopping = true;
+        start_barrier.arrive_and_wait();
+        for(std::thread& worker: workers) {
+            worker.join();
+        }
+    }
+
+    [[nodiscard]] i32 thread_count() const {
+        return static_cast<i32>(workers.size()) + 1;
+    }
+
+    // run
+    // Invoke job(thread_index) on every thread, 0 being the calling thread,
+    // and wait for all of them to return.
+    //
+    template<typename Job>
+    void run(Job& job) {
+        this->job = &job;
+        invoke = [](void* const job, i32 const index) {
+            (*static_cast<Job*>(job))(index);
+        };
+        start_barrier.arrive_and_wait();
+        job(0);
+        end_barrier.arrive_and_wait();
+    }
+};
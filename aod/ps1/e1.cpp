@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <optional>
 #include <queue>
@@ -9,13 +11,7 @@
 #include <common.hpp>
 
 struct Vertex {
-    std::vector<i32> edges;
-    i32 index = 0;
     bool visited = false;
-
-    Vertex() {
-        edges.reserve(16);
-    }
 };
 
 struct Edge {
@@ -28,32 +24,33 @@ struct Traversal_Data {
     std::vector<Edge> tree;
 };
 
-[[nodiscard]] Traversal_Data dfs(std::span<Vertex> const vertices) {
+[[nodiscard]] Traversal_Data dfs(Graph const& graph,
+                                 std::span<Vertex> const vertices) {
     struct Vertex_Info {
-        Vertex* vertex;
-        Vertex* parent;
+        i32 vertex;
+        // -1 for the roots.
+        i32 parent;
     };
 
     Traversal_Data data;
     std::stack<Vertex_Info> stack;
-    for(Vertex& source: vertices) {
-        if(source.visited) {
+    for(i32 source = 0; source < graph.vertex_count(); source += 1) {
+        if(vertices[source].visited) {
             continue;
         }
 
-        stack.push({&source, nullptr});
+        stack.push({source, -1});
         while(stack.size() > 0) {
             auto const [vertex, parent] = stack.top();
             stack.pop();
-            if(!vertex->visited) {
-                data.order.push_back(vertex->index);
-                vertex->visited = true;
-                if(parent != nullptr) {
-                    data.tree.push_back(Edge{parent->index, vertex->index});
+            if(!vertices[vertex].visited) {
+                data.order.push_back(vertex + 1);
+                vertices[vertex].visited = true;
+                if(parent != -1) {
+                    data.tree.push_back(Edge{parent + 1, vertex + 1});
                 }
 
-                for(i32 const index: vertex->edges) {
-                    Vertex* const neighbor = vertices.data() + index;
+                for(i32 const neighbor: graph.edges(vertex)) {
                     stack.push({neighbor, vertex});
                 }
             }
@@ -62,32 +59,33 @@ struct Traversal_Data {
     return data;
 }
 
-[[nodiscard]] Traversal_Data bfs(std::span<Vertex> const vertices) {
+[[nodiscard]] Traversal_Data bfs(Graph const& graph,
+                                 std::span<Vertex> const vertices) {
     struct Vertex_Info {
-        Vertex* vertex;
-        Vertex* parent;
+        i32 vertex;
+        // -1 for the roots.
+        i32 parent;
     };
 
     Traversal_Data data;
     std::queue<Vertex_Info> queue;
-    for(Vertex& source: vertices) {
-        if(source.visited) {
+    for(i32 source = 0; source < graph.vertex_count(); source += 1) {
+        if(vertices[source].visited) {
             continue;
         }
 
-        queue.push({&source, nullptr});
+        queue.push({source, -1});
         while(queue.size() > 0) {
             auto const [vertex, parent] = queue.front();
             queue.pop();
-            if(!vertex->visited) {
-                data.order.push_back(vertex->index);
-                vertex->visited = true;
-                if(parent != nullptr) {
-                    data.tree.push_back(Edge{parent->index, vertex->index});
+            if(!vertices[vertex].visited) {
+                data.order.push_back(vertex + 1);
+                vertices[vertex].visited = true;
+                if(parent != -1) {
+                    data.tree.push_back(Edge{parent + 1, vertex + 1});
                 }
 
-                for(i32 const index: vertex->edges) {
-                    Vertex* const neighbor = vertices.data() + index;
+                for(i32 const neighbor: graph.edges(vertex)) {
                     queue.push({neighbor, vertex});
                 }
             }
@@ -96,14 +94,381 @@ struct Traversal_Data {
     return data;
 }
 
+// Parallel_BFS
+// Level-synchronous breadth-first search. Every level is expanded either
+// top-down, the frontier claiming its unvisited neighbours, or bottom-up, the
+// unvisited vertices looking for a parent in the bitmap of the frontier. The
+// direction is chosen for every level by the heuristic of Beamer et al.
+//
+// The levels are the same as those of bfs, but the order within a level and
+// the parents depend on the scheduling. When ordered is set the levels are
+// expanded top-down only, in two phases, every vertex first recording the
+// smallest position in the frontier of its parents and then being claimed by
+// that parent, which reproduces the order and the tree of bfs exactly.
+//
+struct Parallel_BFS {
+private:
+    // Waking the workers costs more than expanding a frontier with fewer
+    // edges than this on the calling thread.
+    static constexpr i64 PARALLEL_STEP_THRESHOLD = 4096;
+    // Switch to bottom-up once the edges leaving the frontier exceed 1/ALPHA of
+    // the edges entering the unvisited vertices, and back to top-down once the
+    // frontier holds fewer than 1/BETA of the vertices.
+    static constexpr i64 ALPHA = 14;
+    static constexpr i64 BETA = 24;
+    // Frontier vertices per chunk of a top-down step.
+    static constexpr i64 TOP_DOWN_CHUNK = 256;
+    // Bitmap words per chunk of a bottom-up step.
+    static constexpr i64 BOTTOM_UP_CHUNK = 16;
+    static constexpr i32 UNVISITED = -2;
+    static constexpr i32 NO_CLAIM = 0x7FFFFFFF;
+
+    struct alignas(64) Thread_Data {
+        std::vector<i32> discovered;
+        // Edges leaving and entering the discovered vertices.
+        i64 out_edges = 0;
+        i64 in_edges = 0;
+    };
+
+    Graph const& graph;
+    Thread_Pool& pool;
+    bool ordered;
+    // -1 for the roots.
+    std::vector<i32> parents;
+    // Smallest position in the frontier of the parents of a vertex. Only set
+    // by the ordered top-down steps, NO_CLAIM for every unvisited vertex
+    // between the levels.
+    std::vector<i32> claims;
+    std::vector<u64> frontier_bits;
+    std::vector<u64> next_bits;
+    std::vector<Thread_Data> threads;
+    // Vertices discovered from every chunk of an ordered top-down step.
+    std::vector<std::vector<i32>> chunks;
+    std::atomic<i64> next_chunk = 0;
+    // Edges entering the unvisited vertices.
+    i64 unvisited_edges = 0;
+
+public:
+    i32 top_down_steps = 0;
+    i32 bottom_up_steps = 0;
+
+    Parallel_BFS(Graph const& graph, Thread_Pool& pool, bool const ordered)
+        : graph(graph), pool(pool), ordered(ordered) {}
+
+    [[nodiscard]] Traversal_Data run() {
+        i32 const n = graph.vertex_count();
+        parents.assign(n, UNVISITED);
+        if(ordered) {
+            claims.assign(n, NO_CLAIM);
+        }
+        frontier_bits.assign((n + 63) / 64, 0);
+        next_bits.assign((n + 63) / 64, 0);
+        threads.resize(pool.thread_count());
+        unvisited_edges = static_cast<i64>(
+            graph.directed ? graph.reverse_targets.size()
+                           : graph.targets.size());
+
+        std::vector<i32> order;
+        order.reserve(n);
+        std::vector<i32> frontier;
+        std::vector<i32> next;
+        for(i32 source = 0; source < n; source += 1) {
+            if(parents[source] != UNVISITED) {
+                continue;
+            }
+
+            parents[source] = -1;
+            order.push_back(source);
+            unvisited_edges -= graph.reverse_edges(source).size();
+            frontier.assign(1, source);
+            i64 frontier_edges = graph.edges(source).size();
+            bool bottom_up = false;
+            while(frontier.size() > 0) {
+                i64 const size = frontier.size();
+                if(!ordered && !bottom_up &&
+                   frontier_edges > unvisited_edges / ALPHA &&
+                   size >= n / BETA) {
+                    bottom_up = true;
+                    fill_frontier_bits(frontier);
+                } else if(bottom_up && size < n / BETA) {
+                    bottom_up = false;
+                }
+
+                if(bottom_up) {
+                    frontier_edges = bottom_up_step(next);
+                    bottom_up_steps += 1;
+                } else if(frontier_edges + size < PARALLEL_STEP_THRESHOLD) {
+                    frontier_edges = sequential_step(frontier, next);
+                    top_down_steps += 1;
+                } else if(ordered) {
+                    frontier_edges = ordered_top_down_step(frontier, next);
+                    top_down_steps += 1;
+                } else {
+                    frontier_edges = top_down_step(frontier, next);
+                    top_down_steps += 1;
+                }
+
+                order.insert(order.end(), next.begin(), next.end());
+                std::swap(frontier, next);
+            }
+        }
+
+        Traversal_Data data;
+        data.order.reserve(n);
+        data.tree.reserve(n);
+        for(i32 const vertex: order) {
+            data.order.push_back(vertex + 1);
+            if(parents[vertex] != -1) {
+                data.tree.push_back(Edge{parents[vertex] + 1, vertex + 1});
+            }
+        }
+        return data;
+    }
+
+private:
+    // Each step fills next with the vertices of the following level and
+    // returns the number of edges leaving them.
+
+    [[nodiscard]] i64 sequential_step(std::vector<i32> const& frontier,
+                                      std::vector<i32>& next) {
+        next.clear();
+        i64 out_edges = 0;
+        for(i32 const vertex: frontier) {
+            for(i32 const neighbor: graph.edges(vertex)) {
+                if(parents[neighbor] == UNVISITED) {
+                    parents[neighbor] = vertex;
+                    next.push_back(neighbor);
+                    out_edges += graph.edges(neighbor).size();
+                    unvisited_edges -= graph.reverse_edges(neighbor).size();
+                }
+            }
+        }
+        return out_edges;
+    }
+
+    [[nodiscard]] i64 top_down_step(std::vector<i32> const& frontier,
+                                    std::vector<i32>& next) {
+        i64 const size = frontier.size();
+        i64 const chunk_count = (size + TOP_DOWN_CHUNK - 1) / TOP_DOWN_CHUNK;
+        next_chunk.store(0, std::memory_order_relaxed);
+        auto job = [&](i32 const thread) {
+            Thread_Data& data = threads[thread];
+            data.discovered.clear();
+            data.out_edges = 0;
+            data.in_edges = 0;
+            while(true) {
+                i64 const chunk =
+                    next_chunk.fetch_add(1, std::memory_order_relaxed);
+                if(chunk >= chunk_count) {
+                    break;
+                }
+
+                i64 const end = std::min(size, (chunk + 1) * TOP_DOWN_CHUNK);
+                for(i64 i = chunk * TOP_DOWN_CHUNK; i < end; i += 1) {
+                    i32 const vertex = frontier[i];
+                    for(i32 const neighbor: graph.edges(vertex)) {
+                        std::atomic_ref<i32> parent(parents[neighbor]);
+                        i32 expected = UNVISITED;
+                        if(parent.load(std::memory_order_relaxed) ==
+                               UNVISITED &&
+                           parent.compare_exchange_strong(
+                               expected, vertex, std::memory_order_relaxed)) {
+                            data.discovered.push_back(neighbor);
+                            data.out_edges += graph.edges(neighbor).size();
+                            data.in_edges +=
+                                graph.reverse_edges(neighbor).size();
+                        }
+                    }
+                }
+            }
+        };
+        pool.run(job);
+        return gather(next);
+    }
+
+    [[nodiscard]] i64 ordered_top_down_step(std::vector<i32> const& frontier,
+                                            std::vector<i32>& next) {
+        i64 const size = frontier.size();
+        i64 const chunk_count = (size + TOP_DOWN_CHUNK - 1) / TOP_DOWN_CHUNK;
+        if(static_cast<i64>(chunks.size()) < chunk_count) {
+            chunks.resize(chunk_count);
+        }
+
+        next_chunk.store(0, std::memory_order_relaxed);
+        auto claim_job = [&](i32) {
+            while(true) {
+                i64 const chunk =
+                    next_chunk.fetch_add(1, std::memory_order_relaxed);
+                if(chunk >= chunk_count) {
+                    break;
+                }
+
+                i64 const end = std::min(size, (chunk + 1) * TOP_DOWN_CHUNK);
+                for(i32 i = chunk * TOP_DOWN_CHUNK; i < end; i += 1) {
+                    for(i32 const neighbor: graph.edges(frontier[i])) {
+                        if(parents[neighbor] != UNVISITED) {
+                            continue;
+                        }
+
+                        std::atomic_ref<i32> claim(claims[neighbor]);
+                        i32 current = claim.load(std::memory_order_relaxed);
+                        while(i < current &&
+                              !claim.compare_exchange_weak(
+                                  current, i, std::memory_order_relaxed)) {}
+                    }
+                }
+            }
+        };
+        pool.run(claim_job);
+
+        // Only the parent with the recorded position reads and writes the
+        // parent of a vertex, hence the second phase needs no atomics.
+        next_chunk.store(0, std::memory_order_relaxed);
+        auto discover_job = [&](i32 const thread) {
+            Thread_Data& data = threads[thread];
+            data.out_edges = 0;
+            data.in_edges = 0;
+            while(true) {
+                i64 const chunk =
+                    next_chunk.fetch_add(1, std::memory_order_relaxed);
+                if(chunk >= chunk_count) {
+                    break;
+                }
+
+                std::vector<i32>& discovered = chunks[chunk];
+                discovered.clear();
+                i64 const end = std::min(size, (chunk + 1) * TOP_DOWN_CHUNK);
+                for(i32 i = chunk * TOP_DOWN_CHUNK; i < end; i += 1) {
+                    i32 const vertex = frontier[i];
+                    for(i32 const neighbor: graph.edges(vertex)) {
+                        if(claims[neighbor] == i &&
+                           parents[neighbor] == UNVISITED) {
+                            parents[neighbor] = vertex;
+                            discovered.push_back(neighbor);
+                            data.out_edges += graph.edges(neighbor).size();
+                            data.in_edges +=
+                                graph.reverse_edges(neighbor).size();
+                        }
+                    }
+                }
+            }
+        };
+        pool.run(discover_job);
+
+        next.clear();
+        for(i64 chunk = 0; chunk < chunk_count; chunk += 1) {
+            next.insert(next.end(), chunks[chunk].begin(), chunks[chunk].end());
+        }
+        i64 out_edges = 0;
+        for(Thread_Data const& data: threads) {
+            out_edges += data.out_edges;
+            unvisited_edges -= data.in_edges;
+        }
+        return out_edges;
+    }
+
+    [[nodiscard]] i64 bottom_up_step(std::vector<i32>& next) {
+        i32 const n = graph.vertex_count();
+        i64 const words = frontier_bits.size();
+        i64 const chunk_count = (words + BOTTOM_UP_CHUNK - 1) / BOTTOM_UP_CHUNK;
+        next_chunk.store(0, std::memory_order_relaxed);
+        auto job = [&](i32 const thread) {
+            Thread_Data& data = threads[thread];
+            data.discovered.clear();
+            data.out_edges = 0;
+            data.in_edges = 0;
+            while(true) {
+                i64 const chunk =
+                    next_chunk.fetch_add(1, std::memory_order_relaxed);
+                if(chunk >= chunk_count) {
+                    break;
+                }
+
+                i64 const end = std::min(words, (chunk + 1) * BOTTOM_UP_CHUNK);
+                for(i64 word = chunk * BOTTOM_UP_CHUNK; word < end; word += 1) {
+                    u64 found = 0;
+                    i32 const first = word * 64;
+                    i32 const last = std::min(n, first + 64);
+                    for(i32 vertex = first; vertex < last; vertex += 1) {
+                        if(parents[vertex] != UNVISITED) {
+                            continue;
+                        }
+
+                        for(i32 const parent: graph.reverse_edges(vertex)) {
+                            if((frontier_bits[parent >> 6] >> (parent & 63)) &
+                               1) {
+                                parents[vertex] = parent;
+                                found |= u64(1) << (vertex - first);
+                                data.discovered.push_back(vertex);
+                                data.out_edges += graph.edges(vertex).size();
+                                data.in_edges +=
+                                    graph.reverse_edges(vertex).size();
+                                break;
+                            }
+                        }
+                    }
+                    next_bits[word] = found;
+                }
+            }
+        };
+        pool.run(job);
+        std::swap(frontier_bits, next_bits);
+        return gather(next);
+    }
+
+    void fill_frontier_bits(std::vector<i32> const& frontier) {
+        std::fill(frontier_bits.begin(), frontier_bits.end(), 0);
+        i64 const size = frontier.size();
+        i64 const chunk_count = (size + TOP_DOWN_CHUNK - 1) / TOP_DOWN_CHUNK;
+        next_chunk.store(0, std::memory_order_relaxed);
+        auto job = [&](i32) {
+            while(true) {
+                i64 const chunk =
+                    next_chunk.fetch_add(1, std::memory_order_relaxed);
+                if(chunk >= chunk_count) {
+                    break;
+                }
+
+                i64 const end = std::min(size, (chunk + 1) * TOP_DOWN_CHUNK);
+                for(i64 i = chunk * TOP_DOWN_CHUNK; i < end; i += 1) {
+                    i32 const vertex = frontier[i];
+                    std::atomic_ref<u64> word(frontier_bits[vertex >> 6]);
+                    word.fetch_or(u64(1) << (vertex & 63),
+                                  std::memory_order_relaxed);
+                }
+            }
+        };
+        pool.run(job);
+    }
+
+    // gather
+    // Concatenate the vertices discovered by the threads into next.
+    //
+    [[nodiscard]] i64 gather(std::vector<i32>& next) {
+        next.clear();
+        i64 out_edges = 0;
+        for(Thread_Data const& data: threads) {
+            next.insert(next.end(), data.discovered.begin(),
+                        data.discovered.end());
+            out_edges += data.out_edges;
+            unvisited_edges -= data.in_edges;
+        }
+        return out_edges;
+    }
+};
+
 enum struct Algorithm_Kind {
     dfs,
     bfs,
+    pbfs,
 };
 
 struct Options {
     Algorithm_Kind algorithm;
     bool tree = false;
+    // Only used by the parallel breadth-first search.
+    i32 threads = std::max<i32>(std::thread::hardware_concurrency(), 1);
+    bool ordered = false;
 };
 
 [[nodiscard]] std::optional<Options> parse_options(int argc, char** argv) {
@@ -117,8 +482,26 @@ struct Options {
         } else if(arg == "--bfs") {
             options.algorithm = Algorithm_Kind::bfs;
             algorithm_selected = true;
+        } else if(arg == "--pbfs") {
+            options.algorithm = Algorithm_Kind::pbfs;
+            algorithm_selected = true;
+        } else if(arg == "--ordered") {
+            options.ordered = true;
         } else if(arg == "--tree") {
             options.tree = true;
+        } else if(arg == "--threads") {
+            if(i + 1 >= argc) {
+                std::cerr << "error: missing number of threads\n";
+                return std::nullopt;
+            }
+
+            i += 1;
+            std::string_view const value(argv[i]);
+            if(!parse_number(value, options.threads) || options.threads < 1) {
+                std::cerr << "error: invalid number of threads: " << value
+                          << '\n';
+                return std::nullopt;
+            }
         }
     }
 
@@ -138,27 +521,34 @@ int main(int argc, char** argv) {
 
     Options const options = option_parsing_result.value();
 
-    std::optional<std::vector<Vertex>> graph_read_result = read_graph<Vertex>();
+    // The bottom-up steps follow the edges backwards.
+    std::optional<Graph> graph_read_result =
+        read_graph(options.algorithm == Algorithm_Kind::pbfs);
     if(!graph_read_result) {
         return 1;
     }
 
-    std::vector<Vertex>& vertices = graph_read_result.value();
-    for(i32 index = 1; Vertex & vertex: vertices) {
-        vertex.index = index;
-        index += 1;
-    }
+    Graph const& graph = graph_read_result.value();
+    std::vector<Vertex> vertices(graph.vertex_count());
 
     Timer traverse_timer;
     traverse_timer.start();
     Traversal_Data data;
     switch(options.algorithm) {
         case Algorithm_Kind::dfs:
-            data = dfs(vertices);
+            data = dfs(graph, vertices);
             break;
         case Algorithm_Kind::bfs:
-            data = bfs(vertices);
+            data = bfs(graph, vertices);
             break;
+        case Algorithm_Kind::pbfs: {
+            Thread_Pool pool(options.threads);
+            Parallel_BFS search(graph, pool, options.ordered);
+            data = search.run();
+            std::cerr << "bfs levels: " << search.top_down_steps
+                      << " top-down, " << search.bottom_up_steps
+                      << " bottom-up\n";
+        } break;
     }
     std::cerr << "graph traversed in " << traverse_timer.end() << "ns\n";
 
@@ -9,14 +9,8 @@
 #include <common.hpp>
 
 struct Vertex {
-    std::vector<i32> edges;
-    i32 index = 0;
     bool visited = false;
     bool pathed = false;
-
-    Vertex() {
-        edges.reserve(16);
-    }
 };
 
 struct Traversal_Data {
@@ -24,42 +18,44 @@ struct Traversal_Data {
     bool cycle = false;
 };
 
-[[nodiscard]] Traversal_Data dfs(std::span<Vertex> const vertices) {
+[[nodiscard]] Traversal_Data dfs(Graph const& graph,
+                                 std::span<Vertex> const vertices) {
     Traversal_Data data;
     struct Frame {
-        Vertex* vertex;
+        i32 vertex;
         i32 edge;
     };
     std::stack<Frame> path;
-    for(Vertex& source: vertices) {
-        if(source.visited) {
+    for(i32 source = 0; source < graph.vertex_count(); source += 1) {
+        if(vertices[source].visited) {
             continue;
         }
 
-        path.push({&source, 0});
+        path.push({source, 0});
         while(path.size() > 0) {
             auto& [vertex, edge] = path.top();
-            vertex->pathed = true;
-            vertex->visited = true;
+            vertices[vertex].pathed = true;
+            vertices[vertex].visited = true;
 
-            if(edge >= static_cast<i32>(vertex->edges.size())) {
-                data.order.push_back(vertex->index);
-                vertex->pathed = false;
+            std::span<i32 const> const edges = graph.edges(vertex);
+            if(edge >= static_cast<i32>(edges.size())) {
+                data.order.push_back(vertex + 1);
+                vertices[vertex].pathed = false;
                 path.pop();
                 continue;
             }
 
-            while(edge < static_cast<i32>(vertex->edges.size())) {
-                Vertex& n = vertices[vertex->edges[edge]];
+            while(edge < static_cast<i32>(edges.size())) {
+                i32 const n = edges[edge];
                 edge += 1;
-                if(n.pathed) {
+                if(vertices[n].pathed) {
                     // Impossible to sort.
                     data.cycle = true;
                     return data;
                 }
 
-                if(!n.visited) {
-                    path.push({&n, 0});
+                if(!vertices[n].visited) {
+                    path.push({n, 0});
                     break;
                 }
             }
@@ -69,20 +65,17 @@ struct Traversal_Data {
 }
 
 int main() {
-    std::optional<std::vector<Vertex>> graph_read_result = read_graph<Vertex>();
+    std::optional<Graph> graph_read_result = read_graph();
     if(!graph_read_result) {
         return 1;
     }
 
-    std::vector<Vertex>& vertices = graph_read_result.value();
-    for(i32 index = 1; Vertex & vertex: vertices) {
-        vertex.index = index;
-        index += 1;
-    }
+    Graph const& graph = graph_read_result.value();
+    std::vector<Vertex> vertices(graph.vertex_count());
 
     Timer traverse_timer;
     traverse_timer.start();
-    Traversal_Data data = dfs(vertices);
+    Traversal_Data data = dfs(graph, vertices);
     std::cerr << "graph traversed in " << traverse_timer.end() << "ns\n";
     if(data.cycle) {
         std::cout << "graph has a cycle\n";
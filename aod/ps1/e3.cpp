@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <optional>
 #include <queue>
@@ -13,68 +15,63 @@ static i32 min(i32 const a, i32 const b) {
 }
 
 struct Vertex {
-    std::vector<i32> edges;
-    i32 index = 0;
     i32 preorder = -1;
     // "lowest" index reachable from this vertex.
     i32 low = -1;
     bool pathed = false;
-
-    Vertex() {
-        edges.reserve(16);
-    }
 };
 
-std::vector<std::vector<Vertex*>> scc(std::span<Vertex> const vertices) {
+std::vector<std::vector<i32>> scc(Graph const& graph,
+                                  std::span<Vertex> const vertices) {
     i32 preorder = 0;
     struct Frame {
-        Vertex* vertex;
+        i32 vertex;
         i32 edge;
-        Vertex* visited_vertex = nullptr;
+        i32 visited_vertex = -1;
     };
     std::stack<Frame> stack;
-    std::stack<Vertex*> scc_stack;
-    std::vector<std::vector<Vertex*>> sccs;
-    for(Vertex& source: vertices) {
-        if(source.preorder != -1) {
+    std::stack<i32> scc_stack;
+    std::vector<std::vector<i32>> sccs;
+    for(i32 source = 0; source < graph.vertex_count(); source += 1) {
+        if(vertices[source].preorder != -1) {
             continue;
         }
 
-        stack.push({&source, 0, nullptr});
+        stack.push({source, 0, -1});
         while(stack.size() > 0) {
             Frame& frame = stack.top();
-            Vertex*& vertex = frame.vertex;
+            i32 const index = frame.vertex;
+            Vertex& vertex = vertices[index];
             i32& edge = frame.edge;
-            Vertex*& visited_vertex = frame.visited_vertex;
-            // auto& [vertex, edge, visited_vertex] = stack.top();
-            if(vertex->preorder == -1) {
-                vertex->preorder = preorder;
-                vertex->low = preorder;
+            i32& visited_vertex = frame.visited_vertex;
+            if(vertex.preorder == -1) {
+                vertex.preorder = preorder;
+                vertex.low = preorder;
                 preorder += 1;
-                vertex->pathed = true;
-                scc_stack.push(vertex);
+                vertex.pathed = true;
+                scc_stack.push(index);
             }
 
             // Code from after the recursive call.
-            if(visited_vertex != nullptr) {
-                vertex->low = min(vertex->low, visited_vertex->low);
-                visited_vertex = nullptr;
+            if(visited_vertex != -1) {
+                vertex.low = min(vertex.low, vertices[visited_vertex].low);
+                visited_vertex = -1;
             }
 
-            i32 const edges = vertex->edges.size();
+            std::span<i32 const> const edges = graph.edges(index);
             bool recurse = false;
-            while(edge < edges) {
-                Vertex* v = vertices.data() + vertex->edges[edge];
+            while(edge < static_cast<i32>(edges.size())) {
+                i32 const v = edges[edge];
                 edge += 1;
-                if(v->preorder == -1) {
+                if(vertices[v].preorder == -1) {
                     // Store v on our callstack.
                     visited_vertex = v;
-                    stack.push({v, 0, nullptr});
+                    stack.push({v, 0, -1});
                     // Break the flow for a "recursive call".
                     recurse = true;
                     break;
-                } else if(v->pathed) {
-                    vertex->low = min(vertex->low, v->low);
+                } else if(vertices[v].pathed) {
+                    vertex.low = min(vertex.low, vertices[v].low);
                 }
             }
 
@@ -84,14 +81,14 @@ std::vector<std::vector<Vertex*>> scc(std::span<Vertex> const vertices) {
 
             // We get here only if the loop above ends, hence no vertices to
             // check, hence we wrap up for this vertex.
-            if(vertex->low == vertex->preorder) {
-                std::vector<Vertex*>& scc = sccs.emplace_back();
+            if(vertex.low == vertex.preorder) {
+                std::vector<i32>& scc = sccs.emplace_back();
                 while(true) {
-                    Vertex* const v = scc_stack.top();
+                    i32 const v = scc_stack.top();
                     scc_stack.pop();
-                    v->pathed = false;
+                    vertices[v].pathed = false;
                     scc.push_back(v);
-                    if(v == vertex) {
+                    if(v == index) {
                         break;
                     }
                 }
@@ -102,26 +99,444 @@ std::vector<std::vector<Vertex*>> scc(std::span<Vertex> const vertices) {
     return sccs;
 }
 
-int main() {
-    std::optional<std::vector<Vertex>> graph_read_result = read_graph<Vertex>();
+struct SCC_Result {
+    // Index of the strongly connected component of every vertex.
+    std::vector<i32> components;
+    i32 count = 0;
+};
+
+// Parallel_SCC
+// Multistep decomposition (Slota et al.). Vertices without active
+// predecessors or successors are trimmed off as single vertex components,
+// the component of the vertex with the largest degree, usually the giant one,
+// is found as the intersection of a forward and a backward search, and the
+// rest is split by rounds of coloring. A round propagates the largest index of
+// the predecessors of every vertex until it is stable, after which every
+// vertex that kept its own index is the root of a component made of the
+// vertices of its color that reach it backwards.
+//
+// The components are numbered in the order they are found, which differs from
+// the order of scc.
+//
+struct Parallel_SCC {
+private:
+    static constexpr i32 UNASSIGNED = -1;
+    // Vertices or frontier vertices per chunk of work.
+    static constexpr i64 CHUNK = 1024;
+    // Color roots per chunk of the backward searches of a coloring round.
+    static constexpr i64 ROOT_CHUNK = 16;
+    // Trimming is repeated while a pass removes more than 1/TRIM_RATIO of the
+    // active vertices.
+    static constexpr i64 TRIM_RATIO = 100;
+    static constexpr u8 FORWARD = 1;
+    static constexpr u8 BACKWARD = 2;
+
+    struct alignas(64) Thread_Data {
+        std::vector<i32> found;
+        i64 count = 0;
+        i64 best_degree = -1;
+        i32 best_vertex = -1;
+        bool changed = false;
+    };
+
+    Graph const& graph;
+    Thread_Pool& pool;
+    std::vector<i32> components;
+    std::vector<i32> colors;
+    std::vector<u8> marks;
+    // Vertices without a component yet.
+    std::vector<i32> active;
+    std::vector<Thread_Data> threads;
+    std::atomic<i64> next_chunk = 0;
+    i32 component_count = 0;
+
+public:
+    i64 trimmed = 0;
+    i64 giant_size = 0;
+    i32 coloring_rounds = 0;
+
+    Parallel_SCC(Graph const& graph, Thread_Pool& pool)
+        : graph(graph), pool(pool) {}
+
+    [[nodiscard]] SCC_Result run() {
+        i32 const n = graph.vertex_count();
+        components.assign(n, UNASSIGNED);
+        colors.resize(n);
+        marks.assign(n, 0);
+        threads.resize(pool.thread_count());
+        active.resize(n);
+        for(i32 v = 0; v < n; v += 1) {
+            active[v] = v;
+        }
+
+        trim();
+        forward_backward();
+        while(true) {
+            trim();
+            if(active.size() == 0) {
+                break;
+            }
+
+            color();
+        }
+        return SCC_Result{std::move(components), component_count};
+    }
+
+private:
+    [[nodiscard]] bool is_active(i32 const vertex) const {
+        return components[vertex] == UNASSIGNED;
+    }
+
+    // for_each_chunk
+    // Invoke body(thread, begin, end) on the pool for consecutive ranges of
+    // [0, size) of at most chunk elements.
+    //
+    template<typename Body>
+    void for_each_chunk(i64 const size, i64 const chunk, Body const& body) {
+        i64 const chunk_count = (size + chunk - 1) / chunk;
+        next_chunk.store(0, std::memory_order_relaxed);
+        auto job = [&](i32 const thread) {
+            while(true) {
+                i64 const index =
+                    next_chunk.fetch_add(1, std::memory_order_relaxed);
+                if(index >= chunk_count) {
+                    break;
+                }
+
+                body(thread, index * chunk,
+                     std::min(size, (index + 1) * chunk));
+            }
+        };
+        pool.run(job);
+    }
+
+    void reset_threads() {
+        for(Thread_Data& data: threads) {
+            data.found.clear();
+            data.count = 0;
+            data.best_degree = -1;
+            data.best_vertex = -1;
+            data.changed = false;
+        }
+    }
+
+    void compact_active() {
+        std::erase_if(active, [this](i32 const vertex) {
+            return !is_active(vertex);
+        });
+    }
+
+    void trim() {
+        while(active.size() > 0) {
+            i64 const size = active.size();
+            reset_threads();
+            // Self-loops do not keep a vertex in a larger component.
+            auto const has_active_neighbor =
+                [this](i32 const vertex, std::span<i32 const> const edges) {
+                    for(i32 const neighbor: edges) {
+                        if(neighbor != vertex && is_active(neighbor)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                };
+            auto const pass = [&](i32 const thread, i64 const begin,
+                                  i64 const end) {
+                for(i64 i = begin; i < end; i += 1) {
+                    i32 const v = active[i];
+                    if(!has_active_neighbor(v, graph.reverse_edges(v)) ||
+                       !has_active_neighbor(v, graph.edges(v))) {
+                        threads[thread].found.push_back(v);
+                    }
+                }
+            };
+            for_each_chunk(size, CHUNK, pass);
+
+            // The components are assigned after the pass so that the pass
+            // only reads them.
+            i64 removed = 0;
+            for(Thread_Data const& data: threads) {
+                for(i32 const vertex: data.found) {
+                    components[vertex] = component_count;
+                    component_count += 1;
+                }
+                removed += data.found.size();
+            }
+            trimmed += removed;
+            compact_active();
+            if(removed == 0 || removed <= size / TRIM_RATIO) {
+                break;
+            }
+        }
+    }
+
+    // reach
+    // Mark every active vertex reachable from source along the edges, or
+    // against them when backward is set, with mark.
+    //
+    void reach(i32 const source, bool const backward, u8 const mark) {
+        std::vector<i32> frontier = {source};
+        std::vector<i32> next;
+        marks[source] |= mark;
+        auto const expand = [&](i32 const thread, i64 const begin,
+                                i64 const end) {
+            for(i64 i = begin; i < end; i += 1) {
+                i32 const v = frontier[i];
+                std::span<i32 const> const edges =
+                    backward ? graph.reverse_edges(v) : graph.edges(v);
+                for(i32 const neighbor: edges) {
+                    if(!is_active(neighbor)) {
+                        continue;
+                    }
+
+                    std::atomic_ref<u8> marks_ref(marks[neighbor]);
+                    if((marks_ref.load(std::memory_order_relaxed) & mark) ==
+                           0 &&
+                       (marks_ref.fetch_or(mark, std::memory_order_relaxed) &
+                        mark) == 0) {
+                        threads[thread].found.push_back(neighbor);
+                    }
+                }
+            }
+        };
+        while(frontier.size() > 0) {
+            reset_threads();
+            for_each_chunk(frontier.size(), CHUNK, expand);
+            next.clear();
+            for(Thread_Data const& data: threads) {
+                next.insert(next.end(), data.found.begin(), data.found.end());
+            }
+            std::swap(frontier, next);
+        }
+    }
+
+    void forward_backward() {
+        if(active.size() == 0) {
+            return;
+        }
+
+        // The pivot is the vertex with the largest product of degrees.
+        reset_threads();
+        auto const find_pivot = [&](i32 const thread, i64 const begin,
+                                    i64 const end) {
+            Thread_Data& data = threads[thread];
+            for(i64 i = begin; i < end; i += 1) {
+                i32 const v = active[i];
+                i64 const degree = i64(graph.edges(v).size()) *
+                                   i64(graph.reverse_edges(v).size());
+                if(degree > data.best_degree) {
+                    data.best_degree = degree;
+                    data.best_vertex = v;
+                }
+            }
+        };
+        for_each_chunk(active.size(), CHUNK, find_pivot);
+
+        Thread_Data const& best = *std::max_element(
+            threads.begin(), threads.end(),
+            [](Thread_Data const& a, Thread_Data const& b) {
+                return a.best_degree < b.best_degree;
+            });
+        i32 const pivot = best.best_vertex;
+        reach(pivot, false, FORWARD);
+        reach(pivot, true, BACKWARD);
+
+        i32 const component = component_count;
+        component_count += 1;
+        reset_threads();
+        auto const assign = [&](i32 const thread, i64 const begin,
+                                i64 const end) {
+            for(i64 i = begin; i < end; i += 1) {
+                i32 const v = active[i];
+                if(marks[v] == (FORWARD | BACKWARD)) {
+                    components[v] = component;
+                    threads[thread].count += 1;
+                }
+            }
+        };
+        for_each_chunk(active.size(), CHUNK, assign);
+        for(Thread_Data const& data: threads) {
+            giant_size += data.count;
+        }
+        compact_active();
+    }
+
+    void color() {
+        coloring_rounds += 1;
+        i64 const size = active.size();
+        for_each_chunk(size, CHUNK, [&](i32, i64 const begin, i64 const end) {
+            for(i64 i = begin; i < end; i += 1) {
+                colors[active[i]] = active[i];
+            }
+        });
+
+        // Every vertex pulls the colors of its predecessors and only writes
+        // its own.
+        auto const propagate = [&](i32 const thread, i64 const begin,
+                                   i64 const end) {
+            for(i64 i = begin; i < end; i += 1) {
+                i32 const v = active[i];
+                std::atomic_ref<i32> own(colors[v]);
+                i32 const current = own.load(std::memory_order_relaxed);
+                i32 color = current;
+                for(i32 const u: graph.reverse_edges(v)) {
+                    if(is_active(u)) {
+                        std::atomic_ref<i32> other(colors[u]);
+                        color = std::max(color,
+                                         other.load(std::memory_order_relaxed));
+                    }
+                }
+
+                if(color != current) {
+                    own.store(color, std::memory_order_relaxed);
+                    threads[thread].changed = true;
+                }
+            }
+        };
+        bool changed = true;
+        while(changed) {
+            reset_threads();
+            for_each_chunk(size, CHUNK, propagate);
+            changed = false;
+            for(Thread_Data const& data: threads) {
+                changed = changed || data.changed;
+            }
+        }
+
+        reset_threads();
+        auto const find_roots = [&](i32 const thread, i64 const begin,
+                                    i64 const end) {
+            for(i64 i = begin; i < end; i += 1) {
+                i32 const v = active[i];
+                if(colors[v] == v) {
+                    threads[thread].found.push_back(v);
+                }
+            }
+        };
+        for_each_chunk(size, CHUNK, find_roots);
+        std::vector<i32> roots;
+        for(Thread_Data const& data: threads) {
+            roots.insert(roots.end(), data.found.begin(), data.found.end());
+        }
+
+        // The colors partition the active vertices, hence the searches of
+        // different roots never touch the same vertex. The color is checked
+        // first so that only the owner of a vertex reads its component.
+        i32 const first_component = component_count;
+        component_count += roots.size();
+        auto const collect = [&](i32 const thread, i64 const begin,
+                                 i64 const end) {
+            std::vector<i32>& queue = threads[thread].found;
+            for(i64 i = begin; i < end; i += 1) {
+                i32 const root = roots[i];
+                i32 const component = first_component + i;
+                components[root] = component;
+                queue.assign(1, root);
+                for(i64 head = 0; head < i64(queue.size()); head += 1) {
+                    for(i32 const u: graph.reverse_edges(queue[head])) {
+                        if(colors[u] == root && is_active(u)) {
+                            components[u] = component;
+                            queue.push_back(u);
+                        }
+                    }
+                }
+            }
+        };
+        reset_threads();
+        for_each_chunk(roots.size(), ROOT_CHUNK, collect);
+        compact_active();
+    }
+};
+
+struct Options {
+    bool parallel = false;
+    i32 threads = std::max<i32>(std::thread::hardware_concurrency(), 1);
+};
+
+[[nodiscard]] std::optional<Options> parse_options(int argc, char** argv) {
+    Options options;
+    for(i32 i = 1; i < argc; i += 1) {
+        std::string_view arg(argv[i]);
+        if(arg == "--parallel") {
+            options.parallel = true;
+        } else if(arg == "--threads") {
+            if(i + 1 >= argc) {
+                std::cerr << "error: missing number of threads\n";
+                return std::nullopt;
+            }
+
+            i += 1;
+            std::string_view const value(argv[i]);
+            if(!parse_number(value, options.threads) || options.threads < 1) {
+                std::cerr << "error: invalid number of threads: " << value
+                          << '\n';
+                return std::nullopt;
+            }
+        }
+    }
+
+    return options;
+}
+
+int main(int argc, char** argv) {
+    std::optional<Options> option_parsing_result = parse_options(argc, argv);
+    if(!option_parsing_result) {
+        return 1;
+    }
+
+    Options const options = option_parsing_result.value();
+
+    // The parallel decomposition follows the edges backwards.
+    std::optional<Graph> graph_read_result = read_graph(options.parallel);
     if(!graph_read_result) {
         return 1;
     }
 
-    std::vector<Vertex>& vertices = graph_read_result.value();
-    for(i32 index = 1; Vertex & vertex: vertices) {
-        vertex.index = index;
-        index += 1;
+    Graph const& graph = graph_read_result.value();
+    if(options.parallel) {
+        Timer traverse_timer;
+        traverse_timer.start();
+        Thread_Pool pool(options.threads);
+        Parallel_SCC search(graph, pool);
+        SCC_Result const result = search.run();
+        std::cerr << "scc found in " << traverse_timer.end() << "ns\n";
+        std::cerr << "trimmed " << search.trimmed << ", giant component "
+                  << search.giant_size << ", coloring rounds "
+                  << search.coloring_rounds << '\n';
+
+        // Group the vertices by component, counting sort.
+        std::vector<i32> offsets(result.count + 1, 0);
+        for(i32 const component: result.components) {
+            offsets[component + 1] += 1;
+        }
+        for(i32 c = 0; c < result.count; c += 1) {
+            offsets[c + 1] += offsets[c];
+        }
+        std::vector<i32> members(graph.vertex_count());
+        for(i32 v = 0; v < graph.vertex_count(); v += 1) {
+            members[offsets[result.components[v]]] = v;
+            offsets[result.components[v]] += 1;
+        }
+
+        for(i32 c = 0, i = 0; c < result.count; c += 1) {
+            std::cout << "scc " << c + 1 << '\n';
+            for(; i < offsets[c]; i += 1) {
+                std::cout << members[i] + 1 << '\n';
+            }
+        }
+        return 0;
     }
 
+    std::vector<Vertex> vertices(graph.vertex_count());
+
     Timer traverse_timer;
     traverse_timer.start();
-    std::vector<std::vector<Vertex*>> sccs = scc(vertices);
+    std::vector<std::vector<i32>> sccs = scc(graph, vertices);
     std::cerr << "scc found in " << traverse_timer.end() << "ns\n";
-    for(i32 index = 1; std::vector<Vertex*> const& scc: sccs) {
+    for(i32 index = 1; std::vector<i32> const& scc: sccs) {
         std::cout << "scc " << index << '\n';
-        for(Vertex* const vertex: scc) {
-            std::cout << vertex->index << '\n';
+        for(i32 const vertex: scc) {
+            std::cout << vertex + 1 << '\n';
         }
         index += 1;
     }
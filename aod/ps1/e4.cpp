@@ -10,40 +10,36 @@ constexpr Color COLOR_BLACK = false;
 constexpr Color COLOR_RED = true;
 
 struct Vertex {
-    std::vector<i32> edges;
     Color color = COLOR_BLACK;
     bool colored = false;
-
-    Vertex() {
-        edges.reserve(16);
-    }
 };
 
-[[nodiscard]] bool twocolor_graph(std::span<Vertex> const vertices) {
+[[nodiscard]] bool twocolor_graph(Graph const& graph,
+                                  std::span<Vertex> const vertices) {
     struct Vertex_Info {
-        Vertex* vertex;
+        i32 vertex;
         Color last_color;
     };
 
     std::stack<Vertex_Info> stack;
-    for(Vertex& source: vertices) {
-        if(source.colored) {
+    for(i32 source = 0; source < graph.vertex_count(); source += 1) {
+        if(vertices[source].colored) {
             continue;
         }
 
-        stack.push({&source, COLOR_BLACK});
+        stack.push({source, COLOR_BLACK});
         while(stack.size() > 0) {
-            auto const [vertex, last_color] = stack.top();
+            auto const [index, last_color] = stack.top();
             stack.pop();
-            if(vertex->colored) {
-                if(vertex->color == last_color) {
+            Vertex& vertex = vertices[index];
+            if(vertex.colored) {
+                if(vertex.color == last_color) {
                     return false;
                 }
             } else {
-                vertex->color = !last_color;
-                vertex->colored = true;
-                for(i32 const index: vertex->edges) {
-                    Vertex* const neighbor = vertices.data() + index;
+                vertex.color = !last_color;
+                vertex.colored = true;
+                for(i32 const neighbor: graph.edges(index)) {
                     stack.push({neighbor, !last_color});
                 }
             }
@@ -53,16 +49,17 @@ struct Vertex {
 }
 
 int main() {
-    std::optional<std::vector<Vertex>> graph_read_result = read_graph<Vertex>();
+    std::optional<Graph> graph_read_result = read_graph();
     if(!graph_read_result) {
         return 1;
     }
 
-    std::vector<Vertex>& vertices = graph_read_result.value();
+    Graph const& graph = graph_read_result.value();
+    std::vector<Vertex> vertices(graph.vertex_count());
 
     Timer coloring_timer;
     coloring_timer.start();
-    bool const result = twocolor_graph(vertices);
+    bool const result = twocolor_graph(graph, vertices);
     std::cerr << "graph colored in " << coloring_timer.end() << "ns\n";
     if(!result) {
         std::cout << "0\n";
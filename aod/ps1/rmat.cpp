@@ -0,0 +1,118 @@
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include <common.hpp>
+
+// Generates a Kronecker (R-MAT) graph with the parameters of Graph500 in the
+// input format of the other tools. Every edge descends scale times into one of
+// the quadrants of the adjacency matrix, picked with the probabilities A, B, C
+// and D, and the vertices are relabelled by a random permutation afterwards so
+// that the degree does not correlate with the label. Duplicate edges and
+// self-loops are kept.
+
+constexpr double A = 0.57;
+constexpr double B = 0.19;
+constexpr double C = 0.19;
+
+struct Options {
+    i32 scale = 16;
+    i32 edge_factor = 16;
+    u64 seed = 1;
+    bool directed = false;
+};
+
+[[nodiscard]] std::optional<Options> parse_options(int argc, char** argv) {
+    Options options;
+    for(i32 i = 1; i < argc; i += 1) {
+        std::string_view arg(argv[i]);
+        if(arg == "--directed") {
+            options.directed = true;
+            continue;
+        }
+
+        if(i + 1 >= argc) {
+            std::cerr << "error: missing argument to " << arg << '\n';
+            return std::nullopt;
+        }
+
+        i += 1;
+        std::string_view const value(argv[i]);
+        bool valid = false;
+        if(arg == "--scale") {
+            valid = parse_number(value, options.scale) && options.scale >= 1 &&
+                    options.scale <= 30;
+        } else if(arg == "--edge-factor") {
+            valid = parse_number(value, options.edge_factor) &&
+                    options.edge_factor >= 1;
+        } else if(arg == "--seed") {
+            valid = parse_number(value, options.seed);
+        } else {
+            std::cerr << "error: unrecognised option: " << arg << '\n';
+            return std::nullopt;
+        }
+
+        if(!valid) {
+            std::cerr << "error: invalid argument to " << arg << ": " << value
+                      << '\n';
+            return std::nullopt;
+        }
+    }
+
+    i64 const edges = (i64(1) << options.scale) * options.edge_factor;
+    if(edges > 0x7FFFFFFF) {
+        std::cerr << "error: the graph has more than 2^31 - 1 edges\n";
+        return std::nullopt;
+    }
+
+    return options;
+}
+
+int main(int argc, char** argv) {
+    std::optional<Options> option_parsing_result = parse_options(argc, argv);
+    if(!option_parsing_result) {
+        return 1;
+    }
+
+    Options const options = option_parsing_result.value();
+    i32 const num_vertices = 1 << options.scale;
+    i32 const num_edges = num_vertices * options.edge_factor;
+
+    std::mt19937_64 random(options.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<i32> permutation(num_vertices);
+    for(i32 v = 0; v < num_vertices; v += 1) {
+        permutation[v] = v;
+    }
+    for(i32 v = num_vertices - 1; v > 0; v -= 1) {
+        std::uniform_int_distribution<i32> pick(0, v);
+        std::swap(permutation[v], permutation[pick(random)]);
+    }
+
+    Output_Buffer out;
+    out.write_char(options.directed ? 'D' : 'U');
+    out.write_newline();
+    out.write_i64(num_vertices);
+    out.write_newline();
+    out.write_i64(num_edges);
+    out.write_newline();
+    for(i32 e = 0; e < num_edges; e += 1) {
+        i32 src = 0;
+        i32 dst = 0;
+        for(i32 bit = 0; bit < options.scale; bit += 1) {
+            double const r = uniform(random);
+            bool const src_bit = r >= A + B;
+            bool const dst_bit = (r >= A && r < A + B) || r >= A + B + C;
+            src |= i32(src_bit) << bit;
+            dst |= i32(dst_bit) << bit;
+        }
+
+        out.write_i64(permutation[src] + 1);
+        out.write_char(' ');
+        out.write_i64(permutation[dst] + 1);
+        out.write_newline();
+    }
+    return 0;
+}